@@ -0,0 +1,97 @@
+#include "alloc_counter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include <opencv2/core.hpp>
+
+namespace
+{
+    std::atomic<uint64_t> heapAllocations{0};
+    std::atomic<uint64_t> matAllocations{0};
+
+    void *countedAllocate(std::size_t size)
+    {
+        heapAllocations.fetch_add(1, std::memory_order_relaxed);
+
+        if (void *pointer = std::malloc(size == 0 ? 1 : size))
+        {
+            return pointer;
+        }
+
+        throw std::bad_alloc();
+    }
+
+    // Counts the buffers, the standard allocator does the work and frees them
+    class CountingMatAllocator : public cv::MatAllocator
+    {
+    public:
+        cv::UMatData *allocate(int dims, const int *sizes, int type, void *data, size_t *step, cv::AccessFlag flags, cv::UMatUsageFlags usageFlags) const override
+        {
+            if (data == nullptr)
+            {
+                matAllocations.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            return cv::Mat::getStdAllocator()->allocate(dims, sizes, type, data, step, flags, usageFlags);
+        }
+
+        bool allocate(cv::UMatData *data, cv::AccessFlag accessFlags, cv::UMatUsageFlags usageFlags) const override
+        {
+            return cv::Mat::getStdAllocator()->allocate(data, accessFlags, usageFlags);
+        }
+
+        void deallocate(cv::UMatData *data) const override
+        {
+            cv::Mat::getStdAllocator()->deallocate(data);
+        }
+    };
+}
+
+void *operator new(std::size_t size)
+{
+    return countedAllocate(size);
+}
+
+void *operator new[](std::size_t size)
+{
+    return countedAllocate(size);
+}
+
+void operator delete(void *pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void *pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void *pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete[](void *pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+namespace AllocCounter
+{
+    void install()
+    {
+        static CountingMatAllocator allocator;
+        cv::Mat::setDefaultAllocator(&allocator);
+    }
+
+    Counts snapshot()
+    {
+        Counts counts;
+        counts.heap = heapAllocations.load(std::memory_order_relaxed);
+        counts.mats = matAllocations.load(std::memory_order_relaxed);
+        return counts;
+    }
+}
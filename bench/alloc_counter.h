@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+
+// Heap allocations made by the whole process, counted by replacing the global
+// operator new and by wrapping the OpenCV matrix allocator
+namespace AllocCounter
+{
+    struct Counts
+    {
+        uint64_t heap = 0; // operator new, on any thread
+        uint64_t mats = 0; // cv::Mat buffers
+    };
+
+    // Routes cv::Mat allocations through the counter, call once before any decoding
+    void install();
+
+    Counts snapshot();
+}
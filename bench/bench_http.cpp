@@ -0,0 +1,690 @@
+#include "benchmark.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include <Poco/Exception.h>
+#include <Poco/Net/HTTPClientSession.h>
+#include <Poco/Net/HTTPRequest.h>
+#include <Poco/Net/HTTPResponse.h>
+#include <Poco/Net/HTTPServer.h>
+#include <Poco/Net/HTTPServerParams.h>
+#include <Poco/Net/PollSet.h>
+#include <Poco/Net/ServerSocket.h>
+#include <Poco/Net/WebSocket.h>
+#include <Poco/NullStream.h>
+#include <Poco/StreamCopier.h>
+
+#include <nlohmann/json.hpp>
+
+#include "image_catalog.h"
+#include "preview_stream.h"
+#include "rpc_dispatcher.h"
+#include "state_hub.h"
+#include "web_server.h"
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    // The web server of the demo on a loopback port picked by the system
+    class LoopbackServer
+    {
+    public:
+        explicit LoopbackServer(const std::string &webRoot, std::shared_ptr<MediaRoot> mediaRoot = nullptr, std::shared_ptr<RpcDispatcher> dispatcher = nullptr, std::shared_ptr<StateHub> hub = nullptr, std::shared_ptr<ImageCatalog> catalog = nullptr, std::shared_ptr<PreviewStream> preview = nullptr)
+            : server(new RequestHandlerFactory(webRoot, mediaRoot, dispatcher, hub, catalog, preview), Poco::Net::ServerSocket(Poco::Net::SocketAddress("127.0.0.1", Poco::UInt16(0))), new Poco::Net::HTTPServerParams)
+        {
+            server.start();
+        }
+
+        ~LoopbackServer()
+        {
+            server.stopAll(true);
+        }
+
+        LoopbackServer(const LoopbackServer &) = delete;
+        LoopbackServer &operator=(const LoopbackServer &) = delete;
+
+        Poco::UInt16 port() const { return server.port(); }
+        int busyThreads() const { return server.currentThreads(); }
+
+    private:
+        Poco::Net::HTTPServer server;
+    };
+
+    struct RequestOptions
+    {
+        bool gzip = false;       // Sends Accept-Encoding: gzip
+        bool revalidate = false; // Sends the ETag of the first response, expects 304
+    };
+
+    // Fetches the file a number of times per iteration through one client
+    // session, which reconnects whenever the server closes the connection
+    void staticFile(BenchmarkState &state, const BenchmarkEnvironment &environment, const std::string &uri, int requests, RequestOptions options = RequestOptions())
+    {
+        LoopbackServer server(environment.asset("web"));
+        Poco::Net::HTTPClientSession session("127.0.0.1", server.port());
+        session.setKeepAlive(true);
+
+        double bodyBytes = 0.0;
+        std::string etag;
+        int expectedStatus = Poco::Net::HTTPResponse::HTTP_OK;
+        bool ok = true;
+
+        auto fetch = [&]()
+        {
+            Poco::Net::HTTPRequest request(Poco::Net::HTTPRequest::HTTP_GET, uri, Poco::Net::HTTPMessage::HTTP_1_1);
+            if (options.gzip)
+            {
+                request.set("Accept-Encoding", "gzip");
+            }
+            if (!etag.empty())
+            {
+                request.set("If-None-Match", etag);
+            }
+            session.sendRequest(request);
+
+            Poco::Net::HTTPResponse response;
+            std::istream &body = session.receiveResponse(response);
+
+            Poco::NullOutputStream discard;
+            bodyBytes = static_cast<double>(Poco::StreamCopier::copyStream(body, discard));
+            ok = ok && response.getStatus() == expectedStatus;
+            return response.get("ETag", "");
+        };
+
+        std::string firstEtag = fetch();
+        if (!ok)
+        {
+            state.skip("cannot fetch " + uri);
+            return;
+        }
+
+        if (options.revalidate)
+        {
+            etag = firstEtag;
+            expectedStatus = Poco::Net::HTTPResponse::HTTP_NOT_MODIFIED;
+            state.check("etag", !etag.empty());
+        }
+
+        state.setItemsPerIteration(requests);
+        state.setCounter("body_bytes", bodyBytes);
+
+        while (state.next())
+        {
+            for (int i = 0; i < requests; ++i)
+            {
+                fetch();
+            }
+        }
+
+        if (bodyBytes > 0.0)
+        {
+            state.setBytesPerIteration(bodyBytes * requests);
+        }
+
+        state.check("status", ok);
+    }
+
+    // Large media file in a temporary project folder, removed with the object
+    class TemporaryMedia
+    {
+    public:
+        explicit TemporaryMedia(uint64_t size)
+            : folder(fs::temp_directory_path() / "demo_bench_media"), size(size)
+        {
+            fs::create_directories(folder);
+
+            std::ofstream file(folder / "video.mp4", std::ios::binary);
+            std::vector<char> block(1024 * 1024);
+            for (size_t i = 0; i < block.size(); ++i)
+            {
+                block[i] = static_cast<char>(i * 31);
+            }
+
+            for (uint64_t written = 0; written < size; written += block.size())
+            {
+                file.write(block.data(), static_cast<std::streamsize>(std::min<uint64_t>(block.size(), size - written)));
+            }
+        }
+
+        ~TemporaryMedia()
+        {
+            std::error_code error;
+            fs::remove_all(folder, error);
+        }
+
+        TemporaryMedia(const TemporaryMedia &) = delete;
+        TemporaryMedia &operator=(const TemporaryMedia &) = delete;
+
+        std::shared_ptr<MediaRoot> root() const
+        {
+            auto mediaRoot = std::make_shared<MediaRoot>();
+            mediaRoot->set(folder.string());
+            return mediaRoot;
+        }
+
+        uint64_t fileSize() const { return size; }
+
+    private:
+        fs::path folder;
+        uint64_t size;
+    };
+
+    // Peak resident set size of the process in KB, Linux only
+    long peakRssKb()
+    {
+        std::ifstream status("/proc/self/status");
+        std::string line;
+
+        while (std::getline(status, line))
+        {
+            if (line.compare(0, 6, "VmHWM:") == 0)
+            {
+                return std::strtol(line.c_str() + 6, nullptr, 10);
+            }
+        }
+
+        return -1;
+    }
+
+    // Starts a new peak measurement from the current RSS
+    bool resetPeakRss()
+    {
+        std::ofstream clearRefs("/proc/self/clear_refs");
+        clearRefs << "5";
+        clearRefs.flush();
+        return static_cast<bool>(clearRefs);
+    }
+
+    // Random 1 MB ranges of a large video, as a player seeking
+    void mediaRanges(BenchmarkState &state, const BenchmarkEnvironment &environment, int requests)
+    {
+        TemporaryMedia media(64ull * 1024 * 1024);
+        LoopbackServer server(environment.asset("web"), media.root());
+        Poco::Net::HTTPClientSession session("127.0.0.1", server.port());
+        session.setKeepAlive(true);
+
+        const uint64_t rangeSize = 1024 * 1024;
+        uint64_t seed = 12345;
+        bool ok = true;
+
+        state.setItemsPerIteration(requests);
+        state.setBytesPerIteration(static_cast<double>(rangeSize) * requests);
+
+        while (state.next())
+        {
+            for (int i = 0; i < requests; ++i)
+            {
+                seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+                uint64_t first = (seed >> 16) % (media.fileSize() - rangeSize);
+
+                Poco::Net::HTTPRequest request(Poco::Net::HTTPRequest::HTTP_GET, "/media/video.mp4", Poco::Net::HTTPMessage::HTTP_1_1);
+                request.set("Range", "bytes=" + std::to_string(first) + "-" + std::to_string(first + rangeSize - 1));
+                session.sendRequest(request);
+
+                Poco::Net::HTTPResponse response;
+                std::istream &body = session.receiveResponse(response);
+
+                Poco::NullOutputStream discard;
+                std::streamsize received = Poco::StreamCopier::copyStream(body, discard);
+                ok = ok && response.getStatus() == Poco::Net::HTTPResponse::HTTP_PARTIAL_CONTENT && received == static_cast<std::streamsize>(rangeSize);
+            }
+        }
+
+        state.check("partial_content", ok);
+    }
+
+    // Whole-file downloads by several clients at once. The server streams
+    // from the file through a small buffer per connection, so the peak RSS may
+    // only grow by a few MB per client, whatever the file size.
+    void mediaConcurrent(BenchmarkState &state, const BenchmarkEnvironment &environment, int clients)
+    {
+        TemporaryMedia media(64ull * 1024 * 1024);
+        LoopbackServer server(environment.asset("web"), media.root());
+
+        state.setItemsPerIteration(clients);
+        state.setBytesPerIteration(static_cast<double>(media.fileSize()) * clients);
+
+        bool measured = peakRssKb() >= 0 && resetPeakRss();
+        long baseline = peakRssKb();
+        std::atomic<bool> ok{true};
+
+        while (state.next())
+        {
+            std::vector<std::thread> threads;
+
+            for (int i = 0; i < clients; ++i)
+            {
+                threads.emplace_back([&]()
+                                     {
+                    try
+                    {
+                        Poco::Net::HTTPClientSession session("127.0.0.1", server.port());
+                        Poco::Net::HTTPRequest request(Poco::Net::HTTPRequest::HTTP_GET, "/media/video.mp4", Poco::Net::HTTPMessage::HTTP_1_1);
+                        session.sendRequest(request);
+
+                        Poco::Net::HTTPResponse response;
+                        std::istream &body = session.receiveResponse(response);
+
+                        Poco::NullOutputStream discard;
+                        std::streamsize received = Poco::StreamCopier::copyStream(body, discard);
+                        if (response.getStatus() != Poco::Net::HTTPResponse::HTTP_OK || received != static_cast<std::streamsize>(media.fileSize()))
+                        {
+                            ok = false;
+                        }
+                    }
+                    catch (const Poco::Exception &)
+                    {
+                        ok = false;
+                    } });
+            }
+
+            for (std::thread &thread : threads)
+            {
+                thread.join();
+            }
+        }
+
+        state.check("complete", ok);
+
+        if (measured)
+        {
+            double growthMb = (peakRssKb() - baseline) / 1024.0;
+            // Thread stacks and socket buffers, plus a fixed margin for the server itself
+            double allowedMb = 8.0 + 2.0 * clients;
+            state.setCounter("peak_rss_growth_mb", growthMb);
+            state.setCounter("allowed_growth_mb", allowedMb);
+            state.check("bounded_memory", growthMb < allowedMb);
+        }
+    }
+
+    // Remote control commands through the server while a thread stands in
+    // for the render loop, draining the queue every millisecond
+    void moduleCalls(BenchmarkState &state, const BenchmarkEnvironment &environment, int requests)
+    {
+        auto dispatcher = std::make_shared<RpcDispatcher>();
+        std::atomic<int> executed{0};
+        dispatcher->addCommand("modules.player.show", [&executed](const nlohmann::json &)
+                               {
+            executed++;
+            return true; });
+
+        LoopbackServer server(environment.asset("web"), nullptr, dispatcher);
+        std::atomic<bool> running{true};
+
+        std::thread renderLoop([&]()
+                               {
+            while (running)
+            {
+                dispatcher->drain();
+                dispatcher->presented();
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            } });
+
+        Poco::Net::HTTPClientSession session("127.0.0.1", server.port());
+        session.setKeepAlive(true);
+
+        const std::string body = R"({"func": "modules.player.show"})";
+        int sent = 0;
+        bool ok = true;
+
+        state.setItemsPerIteration(requests);
+
+        while (state.next())
+        {
+            for (int i = 0; i < requests; ++i)
+            {
+                Poco::Net::HTTPRequest request(Poco::Net::HTTPRequest::HTTP_POST, "/api/module/call", Poco::Net::HTTPMessage::HTTP_1_1);
+                request.setContentType("application/json");
+                request.setContentLength(static_cast<std::streamsize>(body.size()));
+                session.sendRequest(request) << body;
+
+                Poco::Net::HTTPResponse response;
+                std::istream &reply = session.receiveResponse(response);
+                Poco::NullOutputStream discard;
+                Poco::StreamCopier::copyStream(reply, discard);
+
+                ok = ok && response.getStatus() == Poco::Net::HTTPResponse::HTTP_OK;
+                sent++;
+            }
+        }
+
+        running = false;
+        renderLoop.join();
+        dispatcher->drain();
+
+        state.check("all_executed", ok && executed == sent);
+
+        RpcStats stats = dispatcher->statistics();
+        state.setCounter("queue_p50_ms", stats.queueP50);
+        state.setCounter("queue_p99_ms", stats.queueP99);
+    }
+
+    // One state fanned out to idle WebSocket clients, each client measures
+    // the time from publish() to its frame. The clients are read by one
+    // poll loop, like the hub, so the bench needs no thread per client.
+    void stateBroadcast(BenchmarkState &state, const BenchmarkEnvironment &environment, int clients)
+    {
+        using Clock = std::chrono::steady_clock;
+
+        auto hub = std::make_shared<StateHub>();
+        LoopbackServer server(environment.asset("web"), nullptr, nullptr, hub);
+
+        std::vector<Poco::Net::WebSocket> sockets;
+        Poco::Net::PollSet pollSet;
+
+        for (int i = 0; i < clients; ++i)
+        {
+            Poco::Net::HTTPClientSession session("127.0.0.1", server.port());
+            Poco::Net::HTTPRequest request(Poco::Net::HTTPRequest::HTTP_GET, "/api/events", Poco::Net::HTTPMessage::HTTP_1_1);
+            Poco::Net::HTTPResponse response;
+
+            sockets.emplace_back(session, request, response);
+            sockets.back().setReceiveTimeout(Poco::Timespan(2, 0));
+            pollSet.add(sockets.back(), Poco::Net::PollSet::POLL_READ);
+        }
+
+        // Upgraded connections reach the hub asynchronously
+        for (int i = 0; i < 200 && hub->statistics().clients < static_cast<size_t>(clients); ++i)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+
+        state.check("connected", hub->statistics().clients == static_cast<size_t>(clients));
+        state.check("no_thread_per_client", server.busyThreads() < clients);
+
+        std::vector<float> latencies;
+        std::vector<char> buffer(1024);
+        bool delivered = true;
+
+        state.setItemsPerIteration(clients);
+
+        while (state.next())
+        {
+            Clock::time_point published = Clock::now();
+            hub->publish({{"mode", "text"}, {"text", "Broadcast"}});
+
+            int received = 0;
+            while (received < clients)
+            {
+                Poco::Net::PollSet::SocketModeMap ready = pollSet.poll(Poco::Timespan(2, 0));
+                if (ready.empty())
+                {
+                    delivered = false;
+                    break;
+                }
+
+                for (const auto &entry : ready)
+                {
+                    Poco::Net::WebSocket socket(entry.first);
+                    int flags = 0;
+                    socket.receiveFrame(buffer.data(), static_cast<int>(buffer.size()), flags);
+
+                    latencies.push_back(std::chrono::duration<float, std::milli>(Clock::now() - published).count());
+                    received++;
+                }
+            }
+        }
+
+        state.check("delivered", delivered);
+
+        if (!latencies.empty())
+        {
+            std::sort(latencies.begin(), latencies.end());
+            state.setCounter("delivery_p50_ms", latencies[latencies.size() / 2]);
+            state.setCounter("delivery_p99_ms", latencies[static_cast<size_t>(latencies.size() * 0.99)]);
+            state.setCounter("delivery_max_ms", latencies.back());
+        }
+
+        for (Poco::Net::WebSocket &socket : sockets)
+        {
+            socket.shutdown();
+        }
+    }
+
+    // Reads a whole response, returns the body size or -1 when the status differs
+    std::streamsize fetchBody(Poco::Net::HTTPClientSession &session, const std::string &uri, std::string *body = nullptr)
+    {
+        Poco::Net::HTTPRequest request(Poco::Net::HTTPRequest::HTTP_GET, uri, Poco::Net::HTTPMessage::HTTP_1_1);
+        session.sendRequest(request);
+
+        Poco::Net::HTTPResponse response;
+        std::istream &stream = session.receiveResponse(response);
+
+        std::ostringstream text;
+        Poco::NullOutputStream discard;
+        std::streamsize received = Poco::StreamCopier::copyStream(stream, body ? static_cast<std::ostream &>(text) : discard);
+
+        if (body)
+        {
+            *body = text.str();
+        }
+
+        return response.getStatus() == Poco::Net::HTTPResponse::HTTP_OK ? received : -1;
+    }
+
+    // What a phone downloads to show the first page of the project: the
+    // listing and every thumbnail, against the size of the original files
+    void imagesPageLoad(BenchmarkState &state, const BenchmarkEnvironment &environment, int width)
+    {
+        using Clock = std::chrono::steady_clock;
+
+        std::vector<CatalogImage> images;
+        double originalBytes = 0.0;
+        std::error_code error;
+
+        for (const auto &entry : fs::directory_iterator(environment.asset("images"), error))
+        {
+            if (entry.is_regular_file())
+            {
+                images.push_back({entry.path().string(), 0, 0});
+                originalBytes += static_cast<double>(entry.file_size());
+            }
+        }
+
+        if (images.empty())
+        {
+            state.skip("no images in " + environment.asset("images"));
+            return;
+        }
+
+        auto catalog = std::make_shared<ImageCatalog>();
+        catalog->publish(images);
+
+        LoopbackServer server(environment.asset("web"), nullptr, nullptr, nullptr, catalog);
+        Poco::Net::HTTPClientSession session("127.0.0.1", server.port());
+        session.setKeepAlive(true);
+
+        const std::string listing = "/api/images?offset=0&limit=50&w=" + std::to_string(width);
+        bool ok = true;
+
+        // Loads one page, the thumbnail URLs come from the listing
+        auto loadPage = [&]()
+        {
+            std::string body;
+            std::streamsize bytes = fetchBody(session, listing, &body);
+            ok = ok && bytes > 0;
+
+            nlohmann::json page = nlohmann::json::parse(body, nullptr, false);
+            if (page.is_discarded() || !page.contains("images"))
+            {
+                ok = false;
+                return 0.0;
+            }
+
+            double total = static_cast<double>(bytes);
+            for (const auto &image : page["images"])
+            {
+                std::streamsize thumbnail = fetchBody(session, image["thumb"].get<std::string>());
+                ok = ok && thumbnail > 0;
+                total += static_cast<double>(thumbnail);
+            }
+
+            return total;
+        };
+
+        // First load encodes every thumbnail
+        Clock::time_point coldStart = Clock::now();
+        double pageBytes = loadPage();
+        state.setCounter("cold_page_ms", std::chrono::duration<double, std::milli>(Clock::now() - coldStart).count());
+
+        state.setItemsPerIteration(static_cast<double>(images.size()));
+        state.setBytesPerIteration(pageBytes);
+
+        while (state.next())
+        {
+            loadPage();
+        }
+
+        CatalogStats stats = catalog->statistics();
+        state.setCounter("page_kb", pageBytes / 1024.0);
+        state.setCounter("original_kb", originalBytes / 1024.0);
+        state.setCounter("encodes", static_cast<double>(stats.misses));
+
+        state.check("served", ok);
+        state.check("encoded_once", stats.misses == images.size());
+        state.check("smaller_than_originals", pageBytes < originalBytes);
+    }
+
+    // Reads the next part of a multipart/x-mixed-replace body, returns its size or -1
+    std::streamsize readPart(std::istream &stream)
+    {
+        std::string line;
+        std::streamsize length = -1;
+
+        while (std::getline(stream, line) && line != "\r")
+        {
+            if (line.compare(0, 15, "Content-Length:") == 0)
+            {
+                length = std::strtoll(line.c_str() + 15, nullptr, 10);
+            }
+        }
+
+        if (!stream || length < 0)
+        {
+            return -1;
+        }
+
+        std::vector<char> jpeg(static_cast<size_t>(length));
+        stream.read(jpeg.data(), length);
+        std::getline(stream, line); // CRLF after the frame
+
+        return stream ? length : -1;
+    }
+
+    // Render thread submitting readbacks of a 640x360 projector to one viewer
+    // of /api/preview.mjpeg. Measures the time from the submit to the frame
+    // arriving, which is the encode plus the send.
+    void previewStream(BenchmarkState &state, const BenchmarkEnvironment &environment)
+    {
+        const int width = 640;
+        const int height = 360;
+
+        std::vector<unsigned char> pixels(static_cast<size_t>(width) * height * 4);
+        for (size_t i = 0; i < pixels.size(); ++i)
+        {
+            pixels[i] = static_cast<unsigned char>((i / 4) % width * 255 / width);
+        }
+
+        auto preview = std::make_shared<PreviewStream>();
+        LoopbackServer server(environment.asset("web"), nullptr, nullptr, nullptr, nullptr, preview);
+
+        // Without a viewer nothing is captured nor encoded
+        preview->submit(pixels, width, height);
+        state.check("idle_skips_capture", !preview->wanted() && preview->statistics().captured == 0);
+
+        Poco::Net::HTTPClientSession session("127.0.0.1", server.port());
+        Poco::Net::HTTPRequest request(Poco::Net::HTTPRequest::HTTP_GET, "/api/preview.mjpeg", Poco::Net::HTTPMessage::HTTP_1_1);
+        session.setTimeout(Poco::Timespan(2, 0));
+        session.sendRequest(request);
+
+        Poco::Net::HTTPResponse response;
+        std::istream &body = session.receiveResponse(response);
+        state.check("multipart", response.getContentType().find("multipart/x-mixed-replace") == 0);
+
+        for (int i = 0; i < 200 && preview->statistics().clients == 0; ++i)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+
+        bool delivered = true;
+        std::streamsize frameBytes = 0;
+
+        while (state.next())
+        {
+            preview->submit(pixels, width, height);
+            frameBytes = readPart(body);
+            delivered = delivered && frameBytes > 0;
+        }
+
+        PreviewStats stats = preview->statistics();
+        state.setItemsPerIteration(1);
+        state.setBytesPerIteration(static_cast<double>(std::max<std::streamsize>(0, frameBytes)));
+        state.setCounter("frame_kb", static_cast<double>(frameBytes) / 1024.0);
+        state.setCounter("encode_max_ms", stats.maxEncodeMs);
+        state.setCounter("skipped", static_cast<double>(stats.skipped));
+
+        // The handler leaves on close, the viewer count drops back to zero
+        preview->closeClients();
+        session.reset();
+
+        for (int i = 0; i < 200 && preview->statistics().clients > 0; ++i)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+
+        state.check("delivered", delivered);
+        state.check("viewer_released", preview->statistics().clients == 0);
+    }
+}
+
+void registerHttpBenchmarks(BenchmarkRunner &runner, const BenchmarkEnvironment &environment)
+{
+    runner.add("http/static_index", [environment](BenchmarkState &state)
+               { staticFile(state, environment, "/rcontrol/index.html", 100); },
+               10);
+
+    runner.add("http/static_css", [environment](BenchmarkState &state)
+               { staticFile(state, environment, "/rcontrol/css/app.26eb705a.css", 20); },
+               10);
+
+    runner.add("http/static_css_gzip", [environment](BenchmarkState &state)
+               { staticFile(state, environment, "/rcontrol/css/app.26eb705a.css", 20, {true, false}); },
+               10);
+
+    runner.add("http/revalidate_304", [environment](BenchmarkState &state)
+               { staticFile(state, environment, "/rcontrol/index.html", 100, {false, true}); },
+               10);
+
+    runner.add("http/media_range", [environment](BenchmarkState &state)
+               { mediaRanges(state, environment, 20); },
+               10);
+
+    runner.add("http/module_call", [environment](BenchmarkState &state)
+               { moduleCalls(state, environment, 100); },
+               10);
+
+    runner.add("http/events_broadcast_100", [environment](BenchmarkState &state)
+               { stateBroadcast(state, environment, 100); },
+               20);
+
+    runner.add("http/images_page_load", [environment](BenchmarkState &state)
+               { imagesPageLoad(state, environment, 256); },
+               10);
+
+    runner.add("http/preview_mjpeg", [environment](BenchmarkState &state)
+               { previewStream(state, environment); },
+               20);
+
+    runner.add("http/media_concurrent_rss", [environment](BenchmarkState &state)
+               { mediaConcurrent(state, environment, 8); },
+               3, 0);
+}
@@ -0,0 +1,475 @@
+#include "benchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <thread>
+
+#include "folder_watcher.h"
+#include "image_decode_pool.h"
+#include "image_library.h"
+#include "opengl.h"
+#include "texture_manager.h"
+#include "thumbnail_cache.h"
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    // Same cell size as the grid of the demo
+    const int thumbnailWidth = 120;
+    const int thumbnailHeight = 80;
+
+    struct ImageSet
+    {
+        std::vector<std::string> paths;
+        double bytes = 0.0;
+    };
+
+    ImageSet listImages(const BenchmarkEnvironment &environment)
+    {
+        ImageSet set;
+        std::error_code error;
+
+        for (const auto &entry : fs::directory_iterator(environment.asset("images"), error))
+        {
+            std::string extension = entry.path().extension().string();
+            std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+
+            if (entry.is_regular_file() && (extension == ".jpg" || extension == ".jpeg" || extension == ".png"))
+            {
+                set.paths.push_back(entry.path().string());
+                set.bytes += static_cast<double>(entry.file_size());
+            }
+        }
+
+        std::sort(set.paths.begin(), set.paths.end());
+        return set;
+    }
+
+    void decodeFiles(BenchmarkState &state, const ImageSet &images)
+    {
+        if (images.paths.empty())
+        {
+            state.skip("no images");
+            return;
+        }
+
+        state.setItemsPerIteration(static_cast<double>(images.paths.size()));
+        state.setBytesPerIteration(images.bytes);
+
+        while (state.next())
+        {
+            for (const std::string &path : images.paths)
+            {
+                DecodedImage image = ImageDecodePool::decodeFile(path);
+                state.check("decoded", !image.failed());
+            }
+        }
+    }
+
+    // Whole folder through the worker pool, as the catalog loads it
+    void decodePool(BenchmarkState &state, const ImageSet &images)
+    {
+        if (images.paths.empty())
+        {
+            state.skip("no images");
+            return;
+        }
+
+        ImageDecodePool pool(ImageDecodePool::decodeFile);
+        const int rounds = 4;
+        int total = static_cast<int>(images.paths.size()) * rounds;
+
+        state.setItemsPerIteration(total);
+        state.setBytesPerIteration(images.bytes * rounds);
+        state.setCounter("threads", pool.threadCount());
+
+        while (state.next())
+        {
+            for (int i = 0; i < total; ++i)
+            {
+                pool.submit(i, images.paths[i % images.paths.size()]);
+            }
+
+            DecodedImage image;
+            for (int received = 0; received < total;)
+            {
+                if (pool.popResult(image))
+                {
+                    received++;
+                }
+                else
+                {
+                    std::this_thread::yield();
+                }
+            }
+        }
+    }
+
+    void makeThumbnails(BenchmarkState &state, const ImageSet &images)
+    {
+        std::vector<DecodedImage> decoded;
+        for (const std::string &path : images.paths)
+        {
+            DecodedImage image = ImageDecodePool::decodeFile(path);
+            if (!image.failed())
+            {
+                decoded.push_back(std::move(image));
+            }
+        }
+
+        if (decoded.empty())
+        {
+            state.skip("no images");
+            return;
+        }
+
+        state.setItemsPerIteration(static_cast<double>(decoded.size()));
+
+        while (state.next())
+        {
+            for (const DecodedImage &image : decoded)
+            {
+                DecodedImage thumbnail = ThumbnailCache::makeThumbnail(image.pixels.get(), image.width, image.height, thumbnailWidth, thumbnailHeight);
+                state.check("generated", !thumbnail.failed());
+            }
+        }
+    }
+
+    void thumbnailCacheHits(BenchmarkState &state, const ImageSet &images)
+    {
+        if (images.paths.empty())
+        {
+            state.skip("no images");
+            return;
+        }
+
+        fs::path directory = fs::temp_directory_path() / "demo_bench_thumbnails";
+        std::error_code error;
+        fs::remove_all(directory, error);
+
+        ThumbnailCache cache(directory.string(), thumbnailWidth, thumbnailHeight);
+
+        // First pass fills the cache
+        for (const std::string &path : images.paths)
+        {
+            cache.load(path);
+        }
+
+        cache.resetCounters();
+        state.setItemsPerIteration(static_cast<double>(images.paths.size()));
+
+        while (state.next())
+        {
+            for (const std::string &path : images.paths)
+            {
+                DecodedImage thumbnail = cache.load(path);
+                state.check("loaded", !thumbnail.failed());
+            }
+        }
+
+        state.setCounter("hits", cache.hits());
+        state.setCounter("misses", cache.misses());
+        state.check("all_hits", cache.misses() == 0);
+
+        fs::remove_all(directory, error);
+    }
+
+    // Opens the image folder through the library until every thumbnail is on
+    // the GPU. Cold starts from an empty thumbnail cache, warm from the one the
+    // cold run left, which must open faster. The cold case records its time.
+    void openFolder(BenchmarkState &state, const BenchmarkEnvironment &environment, const ImageSet &images, bool warm, double &coldOpenMs)
+    {
+        if (!environment.glAvailable)
+        {
+            state.skip("no OpenGL context");
+            return;
+        }
+
+        if (images.paths.empty())
+        {
+            state.skip("no images");
+            return;
+        }
+
+        fs::path directory = fs::temp_directory_path() / "demo_bench_open_thumbnails";
+        std::string folder = environment.asset("images");
+        std::error_code error;
+
+        TextureManager textures(256 * 1024 * 1024);
+        ImageLibrary library(textures, directory.string(), thumbnailWidth, thumbnailHeight);
+
+        auto load = [&]()
+        {
+            library.open(folder);
+
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(60);
+            while (library.pendingCount() > 0 && std::chrono::steady_clock::now() < deadline)
+            {
+                library.processUploads(4.0);
+            }
+
+            return library.pendingCount() == 0;
+        };
+
+        if (warm)
+        {
+            fs::remove_all(directory, error);
+            load();
+        }
+
+        double totalOpenMs = 0.0;
+        int opens = 0;
+        bool complete = true;
+
+        state.setItemsPerIteration(static_cast<double>(images.paths.size()));
+
+        while (state.next())
+        {
+            if (!warm)
+            {
+                state.pauseTiming();
+                fs::remove_all(directory, error);
+                state.resumeTiming();
+            }
+
+            complete = load() && complete;
+            totalOpenMs += library.lastOpenMs();
+            opens++;
+        }
+
+        double openMs = opens > 0 ? totalOpenMs / opens : 0.0;
+
+        state.setCounter("open_ms", openMs);
+        state.setCounter("resident_kb", static_cast<double>(library.residentBytes() / 1024));
+        state.setCounter("cache_hits", library.thumbnailCache().hits());
+        state.setCounter("cache_misses", library.thumbnailCache().misses());
+        state.check("all_loaded", complete);
+
+        if (!warm)
+        {
+            coldOpenMs = openMs;
+        }
+        else if (coldOpenMs > 0.0)
+        {
+            state.check("warm_faster", openMs < coldOpenMs);
+        }
+
+        library.clear();
+        textures.releaseAll();
+        fs::remove_all(directory, error);
+    }
+
+    // Thousands of in-memory images through the library, no call to
+    // processUploads() may exceed its budget by more than a fixed allowance for
+    // the last strip, whose size is only an estimate
+    void uploadBudget(BenchmarkState &state, const BenchmarkEnvironment &environment, int imageCount)
+    {
+        if (!environment.glAvailable)
+        {
+            state.skip("no OpenGL context");
+            return;
+        }
+
+        const double budgetMs = 4.0;
+        const double stripAllowanceMs = 1.0;
+
+        // Empty files give the library its entries, the pixels are made up from the name
+        fs::path root = fs::temp_directory_path() / "demo_bench_uploads";
+        fs::path folder = root / "images";
+        std::error_code error;
+        fs::remove_all(root, error);
+        fs::create_directories(folder, error);
+
+        for (int i = 0; i < imageCount; ++i)
+        {
+            std::ofstream(folder / ("img-" + std::to_string(i) + ".png"));
+        }
+
+        // Mostly cell-sized, every hundredth one at 720p so its upload spans several calls
+        auto synthesize = [](const std::string &path)
+        {
+            size_t hash = std::hash<std::string>()(path);
+            bool large = hash % 100 == 0;
+
+            DecodedImage image;
+            image.width = large ? 1280 : thumbnailWidth;
+            image.height = large ? 720 : thumbnailHeight;
+            image.sourceWidth = image.width;
+            image.sourceHeight = image.height;
+
+            size_t bytes = static_cast<size_t>(image.width) * image.height * 4;
+            image.pixels.reset(static_cast<unsigned char *>(std::malloc(bytes)));
+            std::memset(image.pixels.get(), static_cast<int>(hash & 0xFF), bytes);
+            return image;
+        };
+
+        TextureManager textures(512 * 1024 * 1024);
+        bool complete = true;
+        uint64_t calls = 0;
+        double maxUploadMs = 0.0;
+        double maxStripMs = 0.0;
+        uint64_t overBudget = 0;
+
+        state.setItemsPerIteration(imageCount);
+
+        while (state.next())
+        {
+            ImageLibrary library(textures, (root / "thumbnails").string(), thumbnailWidth, thumbnailHeight, synthesize);
+            library.open(folder.string());
+
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(60);
+            while (library.pendingCount() > 0 && std::chrono::steady_clock::now() < deadline)
+            {
+                double uploadMs = library.processUploads(budgetMs);
+                overBudget += uploadMs > budgetMs + stripAllowanceMs ? 1 : 0;
+                calls++;
+            }
+
+            glFinish();
+            complete = complete && library.pendingCount() == 0;
+            maxUploadMs = (std::max)(maxUploadMs, library.maxUploadMs());
+            maxStripMs = (std::max)(maxStripMs, library.maxStripMs());
+
+            state.pauseTiming();
+            library.clear();
+            state.resumeTiming();
+        }
+
+        state.setCounter("calls", static_cast<double>(calls));
+        state.setCounter("max_upload_ms", maxUploadMs);
+        state.setCounter("max_strip_ms", maxStripMs);
+        state.setCounter("over_budget_calls", static_cast<double>(overBudget));
+        state.check("within_budget", overBudget == 0);
+        state.check("all_uploaded", complete);
+        state.check("gl_errors", glGetError() == GL_NO_ERROR);
+
+        textures.releaseAll();
+        fs::remove_all(root, error);
+    }
+
+    // A bulk copy into the watched folder: the copies reach the catalog in a
+    // few batches and only they are given to the decode pool
+    void watchCopy(BenchmarkState &state, const ImageSet &images, int copies)
+    {
+        if (images.paths.empty())
+        {
+            state.skip("no images");
+            return;
+        }
+
+        fs::path root = fs::temp_directory_path() / "demo_bench_watch";
+        fs::path folder = root / "images";
+        std::error_code error;
+
+        // Textures are never created, nothing is uploaded without a context
+        TextureManager textures(64 * 1024 * 1024);
+
+        size_t batches = 0;
+        uint64_t jobs = 0;
+        bool complete = true;
+
+        state.setItemsPerIteration(copies);
+
+        while (state.next())
+        {
+            state.pauseTiming();
+            fs::remove_all(root, error);
+            fs::create_directories(folder, error);
+
+            for (const std::string &path : images.paths)
+            {
+                fs::copy_file(path, folder / fs::path(path).filename(), error);
+            }
+
+            ImageLibrary library(textures, (root / "thumbnails").string(), thumbnailWidth, thumbnailHeight);
+            FolderWatcher watcher;
+            watcher.watch(folder.string());
+            library.open(folder.string());
+
+            size_t initial = library.size();
+            uint64_t initialJobs = library.thumbnailRequests();
+            state.resumeTiming();
+
+            for (int i = 0; i < copies; ++i)
+            {
+                const fs::path source = images.paths[i % images.paths.size()];
+                fs::copy_file(source, folder / ("copy-" + std::to_string(i) + source.extension().string()), error);
+            }
+
+            // Until every copy is in the catalog, a lost event gives up after a while
+            std::vector<FolderChange> changes;
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+            batches = 0;
+
+            while (library.size() < initial + copies && std::chrono::steady_clock::now() < deadline)
+            {
+                if (watcher.poll(changes))
+                {
+                    library.applyChanges(changes);
+                    batches++;
+                }
+                else
+                {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                }
+            }
+
+            state.pauseTiming();
+            jobs = library.thumbnailRequests() - initialJobs;
+            complete = complete && library.size() == initial + copies;
+            watcher.stop();
+            library.clear();
+            state.resumeTiming();
+        }
+
+        state.setCounter("batches", static_cast<double>(batches));
+        state.setCounter("thumbnail_jobs", static_cast<double>(jobs));
+        state.check("all_added", complete);
+        state.check("only_new_decoded", jobs == static_cast<uint64_t>(copies));
+
+        fs::remove_all(root, error);
+    }
+}
+
+void registerImageBenchmarks(BenchmarkRunner &runner, const BenchmarkEnvironment &environment)
+{
+    ImageSet images = listImages(environment);
+
+    runner.add("image/decode_file", [images](BenchmarkState &state)
+               { decodeFiles(state, images); },
+               10);
+
+    runner.add("image/decode_pool", [images](BenchmarkState &state)
+               { decodePool(state, images); },
+               10);
+
+    runner.add("thumbnail/make", [images](BenchmarkState &state)
+               { makeThumbnails(state, images); });
+
+    runner.add("thumbnail/cache_hit", [images](BenchmarkState &state)
+               { thumbnailCacheHits(state, images); });
+
+    auto coldOpenMs = std::make_shared<double>(0.0);
+
+    runner.add("image/open_cold", [environment, images, coldOpenMs](BenchmarkState &state)
+               { openFolder(state, environment, images, false, *coldOpenMs); },
+               5, 0);
+
+    runner.add("image/open_warm", [environment, images, coldOpenMs](BenchmarkState &state)
+               { openFolder(state, environment, images, true, *coldOpenMs); },
+               5, 0);
+
+    runner.add("image/upload_budget_2k", [environment](BenchmarkState &state)
+               { uploadBudget(state, environment, 2000); },
+               3, 0);
+
+    runner.add("image/watch_copy_1k", [images](BenchmarkState &state)
+               { watchCopy(state, images, 1000); },
+               3, 1);
+}
@@ -0,0 +1,129 @@
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "alloc_counter.h"
+#include "benchmark.h"
+#include "opengl.h"
+
+#ifndef DEMO_SOURCE_DIR
+#define DEMO_SOURCE_DIR "."
+#endif
+
+namespace
+{
+    void printUsage()
+    {
+        std::cout << "Usage: demo_bench [options]\n"
+                  << "  --filter <text>     run only benchmarks whose name contains the text\n"
+                  << "  --iterations <n>    measured iterations of every benchmark\n"
+                  << "  --output <file>     write the results as JSON\n"
+                  << "  --label <text>      free text stored with the results\n"
+                  << "  --assets <dir>      folder with images, videos, fonts and web\n"
+                  << "  --list              list the benchmarks and exit\n";
+    }
+
+    // Hidden window for the upload benchmarks, same context version as the demo
+    GLFWwindow *createHiddenContext()
+    {
+        if (!glfwInit())
+        {
+            return nullptr;
+        }
+
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#ifdef __APPLE__
+        glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+
+        GLFWwindow *window = glfwCreateWindow(64, 64, "demo_bench", nullptr, nullptr);
+        if (window == nullptr)
+        {
+            glfwTerminate();
+            return nullptr;
+        }
+
+        glfwMakeContextCurrent(window);
+        return window;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    BenchmarkOptions options;
+    BenchmarkEnvironment environment;
+    environment.assetDir = DEMO_SOURCE_DIR;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        bool hasValue = i + 1 < argc;
+
+        if (std::strcmp(argv[i], "--filter") == 0 && hasValue)
+        {
+            options.filter = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--iterations") == 0 && hasValue)
+        {
+            options.iterations = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--output") == 0 && hasValue)
+        {
+            options.outputPath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--label") == 0 && hasValue)
+        {
+            options.label = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--assets") == 0 && hasValue)
+        {
+            environment.assetDir = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--list") == 0)
+        {
+            options.list = true;
+        }
+        else
+        {
+            printUsage();
+            return std::strcmp(argv[i], "--help") == 0 ? 0 : 2;
+        }
+    }
+
+    AllocCounter::install();
+
+    GLFWwindow *window = options.list ? nullptr : createHiddenContext();
+    if (window != nullptr)
+    {
+        environment.glAvailable = true;
+        environment.glRenderer = reinterpret_cast<const char *>(glGetString(GL_RENDERER));
+    }
+    else if (!options.list)
+    {
+        std::cerr << "No OpenGL context, the upload benchmarks are skipped." << std::endl;
+    }
+
+    BenchmarkRunner runner;
+    registerImageBenchmarks(runner, environment);
+    registerVideoBenchmarks(runner, environment);
+    registerUiBenchmarks(runner, environment);
+    registerHttpBenchmarks(runner, environment);
+
+    int failedChecks = runner.run(options, environment);
+
+    if (window != nullptr)
+    {
+        glfwDestroyWindow(window);
+        glfwTerminate();
+    }
+
+    if (failedChecks > 0)
+    {
+        std::cerr << failedChecks << " check(s) failed." << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,339 @@
+#include "benchmark.h"
+
+#include <memory>
+
+#include "imgui.h"
+#include "backends/imgui_impl_opengl3.h"
+
+#include "image_grid.h"
+#include "opengl.h"
+#include "qr_code.h"
+#include "sdf_font.h"
+#include "text_layout.h"
+
+namespace
+{
+    const char *slideText = "DEUS ENVIOU\nSEU FILHO AMADO\nPRA PERDOAR\nPRA ME SALVAR";
+    const char *remoteUrl = "http://192.168.0.10:8080/rcontrol/?api_url=http://192.168.0.10:8080/api";
+
+    // ImGui context without a window or renderer, frames are built and discarded
+    class HeadlessImGui
+    {
+    public:
+        HeadlessImGui()
+        {
+            context = ImGui::CreateContext();
+            ImGui::SetCurrentContext(context);
+
+            ImGuiIO &io = ImGui::GetIO();
+            io.IniFilename = nullptr;
+            io.DisplaySize = ImVec2(1920.0f, 1080.0f);
+            io.DeltaTime = 1.0f / 60.0f;
+            io.Fonts->AddFontDefault();
+        }
+
+        ~HeadlessImGui()
+        {
+            ImGui::DestroyContext(context);
+        }
+
+        HeadlessImGui(const HeadlessImGui &) = delete;
+        HeadlessImGui &operator=(const HeadlessImGui &) = delete;
+
+        ImFont *addFont(const std::string &path, float size)
+        {
+            return ImGui::GetIO().Fonts->AddFontFromFileTTF(path.c_str(), size);
+        }
+
+        // Call after adding the fonts
+        void build()
+        {
+            unsigned char *pixels;
+            int width, height;
+            ImGui::GetIO().Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+        }
+
+        void beginFrame()
+        {
+            ImGui::NewFrame();
+            ImGui::SetNextWindowPos(ImVec2(0.0f, 0.0f));
+            ImGui::SetNextWindowSize(ImGui::GetIO().DisplaySize);
+            ImGui::Begin("bench", nullptr, ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoSavedSettings);
+        }
+
+        void endFrame()
+        {
+            ImGui::End();
+            ImGui::Render();
+        }
+
+    private:
+        ImGuiContext *context = nullptr;
+    };
+
+    void emptyFrame(BenchmarkState &state)
+    {
+        HeadlessImGui imgui;
+        imgui.build();
+
+        while (state.next())
+        {
+            imgui.beginFrame();
+            imgui.endFrame();
+        }
+    }
+
+    // Only the visible rows are built, the cost must not grow with the catalog.
+    // The first size that runs records how many cells were visible, the others
+    // must build exactly as many.
+    void grid(BenchmarkState &state, size_t entryCount, int &referenceCells)
+    {
+        HeadlessImGui imgui;
+        imgui.build();
+
+        std::vector<ImageEntry> entries(entryCount);
+        for (size_t i = 0; i < entries.size(); ++i)
+        {
+            entries[i].path = "images/img-" + std::to_string(i) + ".jpg";
+            entries[i].texture = {1, 120, 80};
+            entries[i].state = ImageState::Ready;
+        }
+
+        ImageGridResult result;
+
+        while (state.next())
+        {
+            imgui.beginFrame();
+            result = ImageGrid(entries, ImVec2(120.0f, 80.0f), 10.0f);
+            imgui.endFrame();
+        }
+
+        int visibleCells = result.firstVisible >= 0 ? result.lastVisible - result.firstVisible + 1 : 0;
+        state.setCounter("visible_cells", visibleCells);
+        state.check("visible_cells_built", visibleCells > 0 && static_cast<size_t>(visibleCells) < entryCount);
+
+        if (referenceCells < 0)
+        {
+            referenceCells = visibleCells;
+        }
+        else
+        {
+            state.check("same_visible_cells", visibleCells == referenceCells);
+        }
+
+        state.setCounter("draw_vertices", ImGui::GetDrawData() ? ImGui::GetDrawData()->TotalVtxCount : 0);
+    }
+
+    // The 500 px font the projector text uses, rasterized at startup
+    void fontAtlas(BenchmarkState &state, const BenchmarkEnvironment &environment)
+    {
+        std::string path = environment.asset("fonts/Poppins-Bold.ttf");
+        int width = 0, height = 0;
+
+        while (state.next())
+        {
+            ImFontAtlas atlas;
+            ImFont *font = atlas.AddFontFromFileTTF(path.c_str(), 500.0f);
+            if (font == nullptr)
+            {
+                state.skip("cannot load " + path);
+                return;
+            }
+
+            unsigned char *pixels;
+            atlas.GetTexDataAsRGBA32(&pixels, &width, &height);
+        }
+
+        state.setCounter("atlas_width", width);
+        state.setCounter("atlas_height", height);
+        state.setCounter("atlas_kb", static_cast<double>(width) * height * 4 / 1024);
+    }
+
+    // The distance field the projector text is drawn from at any size
+    void sdfBake(BenchmarkState &state, const BenchmarkEnvironment &environment)
+    {
+        std::string path = environment.asset("fonts/Poppins-Bold.ttf");
+        SdfFont font;
+
+        while (state.next())
+        {
+            if (!font.load(path))
+            {
+                state.skip("cannot load " + path);
+                return;
+            }
+        }
+
+        state.setCounter("atlas_width", font.atlasWidth());
+        state.setCounter("atlas_height", font.atlasHeight());
+        state.setCounter("atlas_kb", static_cast<double>(font.atlasBytes()) / 1024);
+        state.setCounter("glyphs", static_cast<double>(font.glyphCount()));
+    }
+
+    void textLayout(BenchmarkState &state, const BenchmarkEnvironment &environment)
+    {
+        HeadlessImGui imgui;
+        ImFont *font = imgui.addFont(environment.asset("fonts/Poppins-Bold.ttf"), 500.0f);
+        if (font == nullptr)
+        {
+            state.skip("cannot load the font");
+            return;
+        }
+        imgui.build();
+
+        while (state.next())
+        {
+            imgui.beginFrame();
+            TextAutoSizedAndCentered(slideText, font, true);
+            imgui.endFrame();
+        }
+
+        state.setCounter("draw_vertices", ImGui::GetDrawData() ? ImGui::GetDrawData()->TotalVtxCount : 0);
+    }
+
+    // The slide laid out and drawn every frame from the distance field, one
+    // quad per glyph instead of nine AddText calls per line
+    void sdfLayout(BenchmarkState &state, const BenchmarkEnvironment &environment)
+    {
+        SdfFont font;
+        if (!font.load(environment.asset("fonts/Poppins-Bold.ttf")))
+        {
+            state.skip("cannot load the font");
+            return;
+        }
+
+        HeadlessImGui imgui;
+        imgui.build();
+
+        while (state.next())
+        {
+            imgui.beginFrame();
+            TextBlockLayout layout = layoutTextBlock(slideText, font, ImGui::GetIO().DisplaySize);
+            drawTextBlock(ImGui::GetWindowDrawList(), layout, font, layout.origin);
+            imgui.endFrame();
+        }
+
+        state.setCounter("draw_vertices", ImGui::GetDrawData() ? ImGui::GetDrawData()->TotalVtxCount : 0);
+    }
+
+    // The same slide through TextSlide: laid out and rendered once, then one quad per frame
+    void textSlide(BenchmarkState &state, const BenchmarkEnvironment &environment)
+    {
+        if (!environment.glAvailable)
+        {
+            state.skip("no OpenGL context");
+            return;
+        }
+
+        SdfFont font;
+        if (!font.load(environment.asset("fonts/Poppins-Bold.ttf")))
+        {
+            state.skip("cannot load the font");
+            return;
+        }
+
+        HeadlessImGui imgui;
+        imgui.build();
+        ImGui_ImplOpenGL3_Init();
+        font.upload();
+
+        // The first frame draws the block directly, the texture is rendered after it
+        TextSlide slide;
+        ImGui_ImplOpenGL3_NewFrame();
+        imgui.beginFrame();
+        slide.draw(slideText, font);
+        imgui.endFrame();
+        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        slide.renderPending();
+        glFinish();
+
+        while (state.next())
+        {
+            imgui.beginFrame();
+            slide.draw(slideText, font);
+            imgui.endFrame();
+        }
+
+        state.setCounter("draw_vertices", ImGui::GetDrawData() ? ImGui::GetDrawData()->TotalVtxCount : 0);
+        state.setCounter("layouts", static_cast<double>(slide.layouts()));
+        state.check("rendered_once", slide.renders() == 1);
+
+        slide.release();
+        font.release();
+        ImGui_ImplOpenGL3_Shutdown();
+    }
+
+    void qrImage(BenchmarkState &state)
+    {
+        while (state.next())
+        {
+            cv::Mat image = generateQRCodeImage(remoteUrl);
+            state.check("generated", !image.empty());
+        }
+    }
+
+    void qrTexture(BenchmarkState &state, const BenchmarkEnvironment &environment)
+    {
+        if (!environment.glAvailable)
+        {
+            state.skip("no OpenGL context");
+            return;
+        }
+
+        while (state.next())
+        {
+            GLuint texture = generateQRCodeTexture(remoteUrl);
+            glFinish();
+
+            state.pauseTiming();
+            state.check("generated", texture != 0);
+            glDeleteTextures(1, &texture);
+            state.resumeTiming();
+        }
+    }
+}
+
+void registerUiBenchmarks(BenchmarkRunner &runner, const BenchmarkEnvironment &environment)
+{
+    runner.add("ui/empty_frame", emptyFrame, 200, 10);
+
+    auto gridCells = std::make_shared<int>(-1);
+
+    runner.add("grid/build_1k", [gridCells](BenchmarkState &state)
+               { grid(state, 1000, *gridCells); },
+               200, 10);
+
+    runner.add("grid/build_10k", [gridCells](BenchmarkState &state)
+               { grid(state, 10000, *gridCells); },
+               200, 10);
+
+    runner.add("grid/build_100k", [gridCells](BenchmarkState &state)
+               { grid(state, 100000, *gridCells); },
+               200, 10);
+
+    runner.add("text/font_atlas_500px", [environment](BenchmarkState &state)
+               { fontAtlas(state, environment); },
+               5, 1);
+
+    runner.add("text/auto_sized_centered", [environment](BenchmarkState &state)
+               { textLayout(state, environment); },
+               200, 10);
+
+    runner.add("text/sdf_bake", [environment](BenchmarkState &state)
+               { sdfBake(state, environment); },
+               5, 1);
+
+    runner.add("text/sdf_auto_sized", [environment](BenchmarkState &state)
+               { sdfLayout(state, environment); },
+               200, 10);
+
+    runner.add("text/slide_cached", [environment](BenchmarkState &state)
+               { textSlide(state, environment); },
+               200, 10);
+
+    runner.add("qr/generate_image", qrImage, 20);
+
+    runner.add("qr/generate_texture", [environment](BenchmarkState &state)
+               { qrTexture(state, environment); },
+               20);
+}
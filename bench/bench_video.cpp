@@ -0,0 +1,387 @@
+#include "benchmark.h"
+
+#include <thread>
+
+#include <opencv2/imgproc.hpp>
+#include <opencv2/videoio.hpp>
+
+#include "alloc_counter.h"
+#include "mp4_index.h"
+#include "opengl.h"
+#include "streaming_texture.h"
+#include "video_player.h"
+
+namespace
+{
+    using Clock = VideoPlayer::Clock;
+
+    Clock::duration milliseconds(double ms)
+    {
+        return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(ms));
+    }
+
+    // Advances a simulated clock by one frame and waits for the player to present it
+    const VideoFrame *presentNext(VideoPlayer &player, Clock::time_point &now, double frameMs)
+    {
+        now += milliseconds(frameMs);
+        Clock::time_point deadline = Clock::now() + std::chrono::seconds(2);
+
+        while (Clock::now() < deadline)
+        {
+            if (const VideoFrame *frame = player.update(now))
+            {
+                return frame;
+            }
+
+            std::this_thread::yield();
+        }
+
+        return nullptr;
+    }
+
+    // Reads the next frame, rewinding outside the measurement at the end of the file
+    bool readLooped(BenchmarkState &state, cv::VideoCapture &capture, cv::Mat &frame)
+    {
+        if (capture.read(frame))
+        {
+            return true;
+        }
+
+        state.pauseTiming();
+        capture.set(cv::CAP_PROP_POS_FRAMES, 0);
+        bool read = capture.read(frame);
+        state.resumeTiming();
+        return read;
+    }
+
+    void keyframeIndex(BenchmarkState &state, const std::string &path)
+    {
+        KeyframeIndex index;
+
+        while (state.next())
+        {
+            state.check("loaded", index.load(path));
+        }
+
+        state.setCounter("frames", static_cast<double>(index.frameCount()));
+        state.setCounter("keyframes", static_cast<double>(index.keyframes().size()));
+    }
+
+    void decode(BenchmarkState &state, const std::string &path)
+    {
+        cv::VideoCapture capture(path);
+        cv::Mat frame;
+
+        if (!capture.isOpened() || !capture.read(frame))
+        {
+            state.skip("cannot open " + path);
+            return;
+        }
+
+        state.setBytesPerIteration(static_cast<double>(frame.total() * frame.elemSize()));
+        state.setItemsPerIteration(1.0);
+        state.setCounter("width", frame.cols);
+        state.setCounter("height", frame.rows);
+
+        while (state.next())
+        {
+            state.check("read", readLooped(state, capture, frame));
+        }
+    }
+
+    // CPU conversion the render thread used to do before uploading
+    void convertToRgba(BenchmarkState &state, const std::string &path)
+    {
+        cv::VideoCapture capture(path);
+        cv::Mat frame, rgba;
+
+        if (!capture.isOpened() || !capture.read(frame))
+        {
+            state.skip("cannot open " + path);
+            return;
+        }
+
+        state.setBytesPerIteration(static_cast<double>(frame.total() * 4));
+
+        while (state.next())
+        {
+            cv::cvtColor(frame, rgba, cv::COLOR_BGR2RGBA);
+        }
+    }
+
+    // Synthetic RGBA frame, a gradient that changes with the frame number so
+    // the driver cannot skip an identical upload
+    cv::Mat syntheticFrame(int width, int height)
+    {
+        cv::Mat frame(height, width, CV_8UC4);
+        for (int y = 0; y < height; ++y)
+        {
+            cv::Vec4b *row = frame.ptr<cv::Vec4b>(y);
+            for (int x = 0; x < width; ++x)
+            {
+                row[x] = cv::Vec4b(static_cast<uchar>(x), static_cast<uchar>(y), static_cast<uchar>(x + y), 255);
+            }
+        }
+        return frame;
+    }
+
+    // Old path: a new texture image every frame. glFinish so the driver copy
+    // is part of the measurement in both upload paths.
+    void uploadTexImage(BenchmarkState &state, const BenchmarkEnvironment &environment, int width, int height)
+    {
+        if (!environment.glAvailable)
+        {
+            state.skip("no OpenGL context");
+            return;
+        }
+
+        cv::Mat frame = syntheticFrame(width, height);
+        state.setBytesPerIteration(static_cast<double>(frame.total() * 4));
+
+        GLuint texture;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        uchar shade = 0;
+
+        while (state.next())
+        {
+            frame.at<cv::Vec4b>(0, 0)[3] = shade++;
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, frame.data);
+            glFinish();
+        }
+
+        glDeleteTextures(1, &texture);
+        state.check("gl_errors", glGetError() == GL_NO_ERROR);
+    }
+
+    // New path: persistent storage fed through the pixel buffer ring, same RGBA input
+    void uploadStreaming(BenchmarkState &state, const BenchmarkEnvironment &environment, int width, int height)
+    {
+        if (!environment.glAvailable)
+        {
+            state.skip("no OpenGL context");
+            return;
+        }
+
+        cv::Mat frame = syntheticFrame(width, height);
+        state.setBytesPerIteration(static_cast<double>(frame.total() * 4));
+
+        StreamingTexture texture;
+        uchar shade = 0;
+
+        while (state.next())
+        {
+            frame.at<cv::Vec4b>(0, 0)[3] = shade++;
+            texture.update(frame.data, width, height, frame.step, StreamingTexture::Format::RGBA);
+            glFinish();
+        }
+
+        texture.release();
+        state.check("gl_errors", glGetError() == GL_NO_ERROR);
+    }
+
+    // The BGR frames of the decoder, converted by the texture swizzle
+
+    void uploadBgrStreaming(BenchmarkState &state, const BenchmarkEnvironment &environment, const std::string &path)
+    {
+        if (!environment.glAvailable)
+        {
+            state.skip("no OpenGL context");
+            return;
+        }
+
+        cv::VideoCapture capture(path);
+        cv::Mat frame;
+
+        if (!capture.isOpened() || !capture.read(frame))
+        {
+            state.skip("cannot open " + path);
+            return;
+        }
+
+        state.setBytesPerIteration(static_cast<double>(frame.total() * frame.elemSize()));
+
+        StreamingTexture texture;
+
+        while (state.next())
+        {
+            texture.update(frame.data, frame.cols, frame.rows, frame.step, StreamingTexture::Format::BGR);
+            glFinish();
+        }
+
+        texture.release();
+        state.check("gl_errors", glGetError() == GL_NO_ERROR);
+    }
+
+    // Decode thread + frame pool + upload, as fast as the decoder goes. After
+    // a full loop every buffer is in place, so neither presenting a frame nor
+    // looping may allocate. Each iteration is a whole pass, one loop included.
+    void playerFrames(BenchmarkState &state, const BenchmarkEnvironment &environment, const std::string &path)
+    {
+        VideoPlayer player;
+        if (!player.open(path))
+        {
+            state.skip("cannot open " + path);
+            return;
+        }
+
+        double frameMs = 1000.0 / (player.fps() > 0.0 ? player.fps() : 30.0);
+        int64_t frameCount = player.keyframes().frameCount();
+        Clock::time_point now = Clock::now();
+
+        if (frameCount <= 0)
+        {
+            state.skip("no frame count for " + path);
+            return;
+        }
+
+        StreamingTexture texture;
+
+        auto present = [&]()
+        {
+            const VideoFrame *frame = presentNext(player, now, frameMs);
+            if (frame != nullptr && environment.glAvailable)
+            {
+                texture.update(frame->image.data, frame->image.cols, frame->image.rows, frame->image.step, StreamingTexture::Format::BGR);
+            }
+            return frame != nullptr;
+        };
+
+        for (int64_t i = 0; i < frameCount + 10; ++i)
+        {
+            present();
+        }
+
+        // Counted inside the iteration only, the harness itself allocates between them
+        int64_t passFrames = frameCount + 1;
+        uint64_t heapAllocations = 0;
+        uint64_t matAllocations = 0;
+        int64_t frames = 0;
+        bool presentedAll = true;
+        bool looped = true;
+
+        state.setItemsPerIteration(static_cast<double>(passFrames));
+
+        while (state.next())
+        {
+            uint64_t loops = player.statistics().loops;
+            AllocCounter::Counts before = AllocCounter::snapshot();
+
+            for (int64_t i = 0; i < passFrames; ++i)
+            {
+                presentedAll = present() && presentedAll;
+            }
+
+            AllocCounter::Counts after = AllocCounter::snapshot();
+            heapAllocations += after.heap - before.heap;
+            matAllocations += after.mats - before.mats;
+            frames += passFrames;
+            looped = looped && player.statistics().loops > loops;
+        }
+
+        VideoStats stats = player.statistics();
+
+        state.setCounter("heap_allocations_per_frame", frames > 0 ? double(heapAllocations) / frames : 0.0);
+        state.setCounter("mat_allocations", static_cast<double>(matAllocations));
+        state.setCounter("dropped", static_cast<double>(stats.dropped));
+        state.setCounter("loops", static_cast<double>(stats.loops));
+        state.check("presented", presentedAll);
+        state.check("looped", looped);
+        state.check("no_mat_allocations", matAllocations == 0);
+        state.check("no_heap_allocations", heapAllocations == 0);
+
+        player.close();
+        texture.release();
+    }
+
+    // One pass per iteration on the real clock, so a decoder that is late at
+    // the end of the clip shows as a late first frame of the next pass. The
+    // first frame after a loop must reach the screen within one frame interval.
+    void loopGap(BenchmarkState &state, const std::string &path)
+    {
+        VideoPlayer player;
+        if (!player.open(path))
+        {
+            state.skip("cannot open " + path);
+            return;
+        }
+
+        double frameMs = 1000.0 / (player.fps() > 0.0 ? player.fps() : 30.0);
+        bool looped = true;
+
+        while (state.next())
+        {
+            uint64_t loops = player.statistics().loops;
+            Clock::time_point deadline = Clock::now() + std::chrono::seconds(60);
+
+            while (player.statistics().loops == loops && Clock::now() < deadline)
+            {
+                player.update(Clock::now());
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+
+            looped = looped && player.statistics().loops > loops;
+        }
+
+        VideoStats stats = player.statistics();
+        state.setCounter("frame_ms", frameMs);
+        state.setCounter("loop_gap_ms", stats.loopGapMs);
+        state.setCounter("max_loop_gap_ms", stats.maxLoopGapMs);
+        state.setCounter("max_loop_decode_ms", stats.maxLoopDecodeMs);
+        state.setCounter("duplicated", static_cast<double>(stats.duplicated));
+        state.check("looped", looped);
+        state.check("gap_within_frame", stats.maxLoopGapMs <= frameMs);
+
+        player.close();
+    }
+}
+
+void registerVideoBenchmarks(BenchmarkRunner &runner, const BenchmarkEnvironment &environment)
+{
+    std::string video = environment.asset("videos/video1.mp4");
+
+    runner.add("mp4/keyframe_index", [video](BenchmarkState &state)
+               { keyframeIndex(state, video); },
+               50);
+
+    runner.add("video/decode", [video](BenchmarkState &state)
+               { decode(state, video); },
+               120, 5);
+
+    runner.add("video/convert_bgr_to_rgba", [video](BenchmarkState &state)
+               { convertToRgba(state, video); },
+               120, 5);
+
+    const struct
+    {
+        const char *name;
+        int width;
+        int height;
+    } uploadSizes[] = {{"720p", 1280, 720}, {"1080p", 1920, 1080}, {"4k", 3840, 2160}};
+
+    for (const auto &size : uploadSizes)
+    {
+        int width = size.width;
+        int height = size.height;
+
+        runner.add(std::string("video/upload_teximage_") + size.name, [environment, width, height](BenchmarkState &state)
+                   { uploadTexImage(state, environment, width, height); },
+                   120, 5);
+
+        runner.add(std::string("video/upload_streaming_") + size.name, [environment, width, height](BenchmarkState &state)
+                   { uploadStreaming(state, environment, width, height); },
+                   120, 5);
+    }
+
+    runner.add("video/upload_bgr_streaming", [environment, video](BenchmarkState &state)
+               { uploadBgrStreaming(state, environment, video); },
+               120, 5);
+
+    runner.add("video/player_frames", [environment, video](BenchmarkState &state)
+               { playerFrames(state, environment, video); },
+               3, 0);
+
+    runner.add("video/loop_gap", [video](BenchmarkState &state)
+               { loopGap(state, video); },
+               3, 0);
+}
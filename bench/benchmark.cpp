@@ -0,0 +1,322 @@
+#include "benchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <sstream>
+#include <thread>
+
+#include <nlohmann/json.hpp>
+#include <opencv2/core.hpp>
+
+#ifndef DEMO_GIT_COMMIT
+#define DEMO_GIT_COMMIT "unknown"
+#endif
+
+namespace
+{
+    struct Summary
+    {
+        double min = 0.0;
+        double median = 0.0;
+        double mean = 0.0;
+        double p95 = 0.0;
+        double max = 0.0;
+        double stddev = 0.0;
+    };
+
+    Summary summarize(std::vector<double> samples)
+    {
+        Summary summary;
+        if (samples.empty())
+        {
+            return summary;
+        }
+
+        std::sort(samples.begin(), samples.end());
+
+        auto at = [&samples](double fraction)
+        {
+            return samples[static_cast<size_t>(fraction * (samples.size() - 1) + 0.5)];
+        };
+
+        summary.min = samples.front();
+        summary.median = at(0.50);
+        summary.p95 = at(0.95);
+        summary.max = samples.back();
+        summary.mean = std::accumulate(samples.begin(), samples.end(), 0.0) / samples.size();
+
+        double variance = 0.0;
+        for (double sample : samples)
+        {
+            variance += (sample - summary.mean) * (sample - summary.mean);
+        }
+        summary.stddev = std::sqrt(variance / samples.size());
+
+        return summary;
+    }
+
+    std::string utcTimestamp()
+    {
+        std::time_t now = std::time(nullptr);
+        std::tm utc{};
+        gmtime_r(&now, &utc);
+
+        char buffer[32];
+        std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%SZ", &utc);
+        return buffer;
+    }
+}
+
+BenchmarkState::BenchmarkState(int warmup, int iterations)
+    : warmup(warmup), iterations(iterations)
+{
+    sampleMs.reserve(iterations);
+}
+
+bool BenchmarkState::next()
+{
+    Clock::time_point now = Clock::now();
+
+    // Closes the iteration that just ran
+    if (running)
+    {
+        if (!paused)
+        {
+            elapsed += now - resumed;
+        }
+
+        if (done >= warmup)
+        {
+            sampleMs.push_back(std::chrono::duration<double, std::milli>(elapsed).count());
+        }
+
+        done++;
+    }
+
+    if (!skipReason.empty() || done >= warmup + iterations)
+    {
+        running = false;
+        return false;
+    }
+
+    running = true;
+    paused = false;
+    elapsed = Clock::duration::zero();
+    resumed = Clock::now();
+    return true;
+}
+
+void BenchmarkState::pauseTiming()
+{
+    if (!paused)
+    {
+        elapsed += Clock::now() - resumed;
+        paused = true;
+    }
+}
+
+void BenchmarkState::resumeTiming()
+{
+    if (paused)
+    {
+        resumed = Clock::now();
+        paused = false;
+    }
+}
+
+void BenchmarkState::setCounter(const std::string &name, double value)
+{
+    for (auto &counter : counters)
+    {
+        if (counter.first == name)
+        {
+            counter.second = value;
+            return;
+        }
+    }
+
+    counters.emplace_back(name, value);
+}
+
+void BenchmarkState::check(const std::string &name, bool passed)
+{
+    for (auto &entry : checks)
+    {
+        if (entry.first == name)
+        {
+            entry.second = entry.second && passed;
+            return;
+        }
+    }
+
+    checks.emplace_back(name, passed);
+}
+
+void BenchmarkState::skip(const std::string &reason)
+{
+    skipReason = reason.empty() ? "skipped" : reason;
+}
+
+void BenchmarkRunner::add(const std::string &name, Function function, int iterations, int warmup)
+{
+    entries.push_back({name, std::move(function), iterations, warmup});
+}
+
+int BenchmarkRunner::run(const BenchmarkOptions &options, const BenchmarkEnvironment &environment)
+{
+    if (options.list)
+    {
+        for (const Entry &entry : entries)
+        {
+            std::cout << entry.name << std::endl;
+        }
+        return 0;
+    }
+
+    nlohmann::ordered_json results = nlohmann::ordered_json::array();
+    int failedChecks = 0;
+
+    std::cout << std::left << std::setw(36) << "benchmark" << std::right
+              << std::setw(10) << "median" << std::setw(10) << "p95" << std::setw(10) << "min"
+              << std::setw(14) << "throughput" << std::endl;
+
+    for (const Entry &entry : entries)
+    {
+        if (!options.filter.empty() && entry.name.find(options.filter) == std::string::npos)
+        {
+            continue;
+        }
+
+        int iterations = options.iterations > 0 ? options.iterations : entry.iterations;
+        BenchmarkState state(entry.warmup, iterations);
+
+        try
+        {
+            entry.function(state);
+        }
+        catch (const std::exception &e)
+        {
+            state.skip(std::string("exception: ") + e.what());
+        }
+
+        if (state.sampleMs.empty() && state.skipReason.empty())
+        {
+            state.skip("no samples");
+        }
+
+        nlohmann::ordered_json result;
+        result["name"] = entry.name;
+
+        if (!state.skipReason.empty())
+        {
+            std::cout << std::left << std::setw(36) << entry.name << " skipped: " << state.skipReason << std::endl;
+
+            result["skipped"] = true;
+            result["reason"] = state.skipReason;
+            results.push_back(result);
+            continue;
+        }
+
+        Summary summary = summarize(state.sampleMs);
+
+        result["iterations"] = static_cast<int>(state.sampleMs.size());
+        result["warmup"] = entry.warmup;
+        result["ms"] = {
+            {"min", summary.min},
+            {"median", summary.median},
+            {"mean", summary.mean},
+            {"p95", summary.p95},
+            {"max", summary.max},
+            {"stddev", summary.stddev},
+        };
+
+        std::string throughput;
+        double seconds = summary.median / 1000.0;
+
+        if (state.bytesPerIteration > 0.0 && seconds > 0.0)
+        {
+            double bytesPerSecond = state.bytesPerIteration / seconds;
+            result["bytes_per_second"] = bytesPerSecond;
+
+            std::ostringstream text;
+            text << std::fixed << std::setprecision(1) << bytesPerSecond / (1024.0 * 1024.0) << " MB/s";
+            throughput = text.str();
+        }
+
+        if (state.itemsPerIteration > 0.0 && seconds > 0.0)
+        {
+            double itemsPerSecond = state.itemsPerIteration / seconds;
+            result["items_per_second"] = itemsPerSecond;
+
+            if (throughput.empty())
+            {
+                std::ostringstream text;
+                text << std::fixed << std::setprecision(1) << itemsPerSecond << " /s";
+                throughput = text.str();
+            }
+        }
+
+        nlohmann::ordered_json counters = nlohmann::ordered_json::object();
+        for (const auto &counter : state.counters)
+        {
+            counters[counter.first] = counter.second;
+        }
+        result["counters"] = counters;
+
+        nlohmann::ordered_json checks = nlohmann::ordered_json::object();
+        for (const auto &check : state.checks)
+        {
+            checks[check.first] = check.second;
+            failedChecks += check.second ? 0 : 1;
+        }
+        result["checks"] = checks;
+
+        results.push_back(result);
+
+        std::cout << std::left << std::setw(36) << entry.name << std::right << std::fixed << std::setprecision(3)
+                  << std::setw(10) << summary.median << std::setw(10) << summary.p95 << std::setw(10) << summary.min
+                  << std::setw(14) << throughput << std::endl;
+
+        for (const auto &check : state.checks)
+        {
+            if (!check.second)
+            {
+                std::cout << "    check failed: " << check.first << std::endl;
+            }
+        }
+    }
+
+    if (!options.outputPath.empty())
+    {
+        nlohmann::ordered_json document;
+        document["schema"] = 1;
+        document["commit"] = DEMO_GIT_COMMIT;
+        document["label"] = options.label;
+        document["timestamp"] = utcTimestamp();
+        document["system"] = {
+            {"hardware_threads", std::thread::hardware_concurrency()},
+            {"opencv", CV_VERSION},
+            {"gl_renderer", environment.glAvailable ? environment.glRenderer : std::string()},
+        };
+        document["benchmarks"] = results;
+
+        std::ofstream file(options.outputPath);
+        file << document.dump(2) << std::endl;
+
+        if (!file)
+        {
+            std::cerr << "Error writing " << options.outputPath << std::endl;
+        }
+        else
+        {
+            std::cout << "Results written to " << options.outputPath << std::endl;
+        }
+    }
+
+    return failedChecks;
+}
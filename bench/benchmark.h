@@ -0,0 +1,112 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Assets and capabilities shared by every benchmark
+struct BenchmarkEnvironment
+{
+    std::string assetDir;     // Folder with images/, videos/, fonts/ and web/
+    bool glAvailable = false; // A hidden window with a current context
+    std::string glRenderer;
+
+    std::string asset(const std::string &relativePath) const { return assetDir + "/" + relativePath; }
+};
+
+// Timing loop handed to each benchmark, the body runs once per iteration:
+//
+//     while (state.next())
+//     {
+//         work();
+//     }
+//
+// The first iterations are warmup and are not recorded.
+class BenchmarkState
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    BenchmarkState(int warmup, int iterations);
+
+    bool next();
+
+    // Keeps per-iteration setup out of the measurement
+    void pauseTiming();
+    void resumeTiming();
+
+    bool warmingUp() const { return done < warmup; }
+
+    // Work done by one iteration, reported as throughput of the median
+    void setBytesPerIteration(double bytes) { bytesPerIteration = bytes; }
+    void setItemsPerIteration(double items) { itemsPerIteration = items; }
+
+    void setCounter(const std::string &name, double value);
+
+    // A failed check is reported and makes the run exit with an error
+    void check(const std::string &name, bool passed);
+
+    // Ends the benchmark without results, the body should return right after
+    void skip(const std::string &reason);
+
+    const std::vector<double> &samples() const { return sampleMs; }
+
+private:
+    friend class BenchmarkRunner;
+
+    int warmup;
+    int iterations;
+    int done = 0;
+    bool running = false;
+    bool paused = false;
+    Clock::time_point resumed;
+    Clock::duration elapsed{};
+
+    std::vector<double> sampleMs;
+    double bytesPerIteration = 0.0;
+    double itemsPerIteration = 0.0;
+    std::vector<std::pair<std::string, double>> counters;
+    std::vector<std::pair<std::string, bool>> checks;
+    std::string skipReason;
+};
+
+struct BenchmarkOptions
+{
+    std::string filter;     // Substring of the names to run, all when empty
+    int iterations = 0;     // Overrides the iterations of every benchmark when > 0
+    std::string outputPath; // JSON results, nothing written when empty
+    std::string label;      // Free text stored with the results, e.g. the machine
+    bool list = false;
+};
+
+// Runs the registered benchmarks in order, prints a table and writes the
+// results as JSON so runs on different commits can be compared.
+class BenchmarkRunner
+{
+public:
+    using Function = std::function<void(BenchmarkState &)>;
+
+    void add(const std::string &name, Function function, int iterations = 20, int warmup = 2);
+
+    // Returns the number of failed checks
+    int run(const BenchmarkOptions &options, const BenchmarkEnvironment &environment);
+
+private:
+    struct Entry
+    {
+        std::string name;
+        Function function;
+        int iterations;
+        int warmup;
+    };
+
+    std::vector<Entry> entries;
+};
+
+// Registration of each area, one file each
+void registerImageBenchmarks(BenchmarkRunner &runner, const BenchmarkEnvironment &environment);
+void registerVideoBenchmarks(BenchmarkRunner &runner, const BenchmarkEnvironment &environment);
+void registerUiBenchmarks(BenchmarkRunner &runner, const BenchmarkEnvironment &environment);
+void registerHttpBenchmarks(BenchmarkRunner &runner, const BenchmarkEnvironment &environment);
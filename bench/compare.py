@@ -0,0 +1,57 @@
+#!/usr/bin/env python3
+"""Compares two demo_bench result files by median time.
+
+    python3 bench/compare.py before.json after.json [--threshold 5]
+"""
+
+import argparse
+import json
+import sys
+
+
+def load(path):
+    with open(path) as file:
+        document = json.load(file)
+    results = {}
+    for entry in document["benchmarks"]:
+        if not entry.get("skipped"):
+            results[entry["name"]] = entry
+    return document, results
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("before")
+    parser.add_argument("after")
+    parser.add_argument("--threshold", type=float, default=5.0, help="percent change reported as a regression")
+    args = parser.parse_args()
+
+    before_doc, before = load(args.before)
+    after_doc, after = load(args.after)
+
+    print(f"{before_doc.get('commit', '?')} -> {after_doc.get('commit', '?')}")
+    print(f"{'benchmark':36}{'before':>12}{'after':>12}{'change':>10}")
+
+    regressions = 0
+    for name, entry in after.items():
+        if name not in before:
+            print(f"{name:36}{'-':>12}{entry['ms']['median']:12.3f}{'new':>10}")
+            continue
+
+        old = before[name]["ms"]["median"]
+        new = entry["ms"]["median"]
+        change = (new - old) / old * 100.0 if old > 0 else 0.0
+        marker = ""
+        if change > args.threshold:
+            marker = "  slower"
+            regressions += 1
+        elif change < -args.threshold:
+            marker = "  faster"
+
+        print(f"{name:36}{old:12.3f}{new:12.3f}{change:+9.1f}%{marker}")
+
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,356 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <Poco/Exception.h>
+#include <Poco/Net/HTTPClientSession.h>
+#include <Poco/Net/HTTPRequest.h>
+#include <Poco/Net/HTTPResponse.h>
+#include <Poco/Net/HTTPServer.h>
+#include <Poco/Net/ServerSocket.h>
+#include <Poco/NullStream.h>
+#include <Poco/StreamCopier.h>
+#include <Poco/ThreadPool.h>
+
+#include <nlohmann/json.hpp>
+
+#include "web_server.h"
+
+#ifndef DEMO_SOURCE_DIR
+#define DEMO_SOURCE_DIR "."
+#endif
+
+#ifndef DEMO_GIT_COMMIT
+#define DEMO_GIT_COMMIT "unknown"
+#endif
+
+using json = nlohmann::ordered_json;
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct LoadOptions
+    {
+        std::string host = "127.0.0.1";
+        int port = 8080;
+        int connections = 16;
+        double duration = 10.0; // Seconds
+        std::vector<std::string> paths;
+        std::string outputPath;
+        std::string webRoot = DEMO_SOURCE_DIR "/web";
+        bool self = false;
+        ServerSettings server;
+    };
+
+    // Latencies of one connection, merged after the run so the workers never share a lock
+    struct PathResults
+    {
+        std::vector<float> latencies; // Microseconds
+        uint64_t errors = 0;
+    };
+
+    struct Summary
+    {
+        uint64_t requests = 0;
+        uint64_t errors = 0;
+        double requestsPerSecond = 0.0;
+        double p50 = 0.0;
+        double p90 = 0.0;
+        double p99 = 0.0;
+        double p999 = 0.0;
+        double max = 0.0;
+    };
+
+    void printUsage()
+    {
+        std::cout << "Usage: demo_loadgen [options]\n"
+                  << "  --host <address>      server address (default 127.0.0.1)\n"
+                  << "  --port <n>            server port (default 8080)\n"
+                  << "  --connections <n>     concurrent keep-alive connections (default 16)\n"
+                  << "  --duration <s>        seconds to run (default 10)\n"
+                  << "  --path <uri>          request path, repeatable (default /rcontrol/ and /api)\n"
+                  << "  --output <file>       write the results as JSON\n"
+                  << "  --self                start the demo server in process on a free port\n"
+                  << "  --web <dir>           web root of the --self server\n"
+                  << "  --threads <n>         worker threads of the --self server\n"
+                  << "  --queued <n>          max queued connections of the --self server\n";
+    }
+
+    // One request and the whole response body, false on transport errors and 5xx
+    bool fetch(Poco::Net::HTTPClientSession &session, const std::string &path)
+    {
+        Poco::Net::HTTPRequest request(Poco::Net::HTTPRequest::HTTP_GET, path, Poco::Net::HTTPMessage::HTTP_1_1);
+        request.setKeepAlive(true);
+        session.sendRequest(request);
+
+        Poco::Net::HTTPResponse response;
+        std::istream &body = session.receiveResponse(response);
+        Poco::NullOutputStream discard;
+        Poco::StreamCopier::copyStream(body, discard);
+
+        return response.getStatus() < Poco::Net::HTTPResponse::HTTP_INTERNAL_SERVER_ERROR;
+    }
+
+    // Requests the paths in turn until the deadline, reconnecting after errors
+    void runConnection(const LoadOptions &options, Clock::time_point deadline, std::vector<PathResults> &results)
+    {
+        Poco::Net::HTTPClientSession session(options.host, static_cast<Poco::UInt16>(options.port));
+        session.setKeepAlive(true);
+        session.setTimeout(Poco::Timespan(10, 0));
+
+        size_t next = 0;
+
+        while (Clock::now() < deadline)
+        {
+            size_t index = next;
+            next = (next + 1) % options.paths.size();
+
+            Clock::time_point start = Clock::now();
+            bool ok = false;
+
+            try
+            {
+                ok = fetch(session, options.paths[index]);
+            }
+            catch (Poco::Exception &)
+            {
+                session.reset();
+            }
+
+            if (ok)
+            {
+                float us = std::chrono::duration<float, std::micro>(Clock::now() - start).count();
+                results[index].latencies.push_back(us);
+            }
+            else
+            {
+                results[index].errors++;
+            }
+        }
+    }
+
+    Summary summarize(std::vector<float> &latencies, uint64_t errors, double seconds)
+    {
+        Summary summary;
+        summary.requests = latencies.size() + errors;
+        summary.errors = errors;
+        summary.requestsPerSecond = seconds > 0.0 ? latencies.size() / seconds : 0.0;
+
+        if (latencies.empty())
+        {
+            return summary;
+        }
+
+        std::sort(latencies.begin(), latencies.end());
+
+        auto at = [&latencies](double fraction)
+        {
+            size_t index = static_cast<size_t>(fraction * (latencies.size() - 1) + 0.5);
+            return latencies[index] / 1000.0;
+        };
+
+        summary.p50 = at(0.50);
+        summary.p90 = at(0.90);
+        summary.p99 = at(0.99);
+        summary.p999 = at(0.999);
+        summary.max = latencies.back() / 1000.0;
+        return summary;
+    }
+
+    json toJson(const Summary &summary)
+    {
+        return {
+            {"requests", summary.requests},
+            {"errors", summary.errors},
+            {"requests_per_second", summary.requestsPerSecond},
+            {"p50_ms", summary.p50},
+            {"p90_ms", summary.p90},
+            {"p99_ms", summary.p99},
+            {"p999_ms", summary.p999},
+            {"max_ms", summary.max},
+        };
+    }
+
+    void printSummary(const std::string &name, const Summary &summary)
+    {
+        std::cout << std::left << std::setw(24) << name << std::right << std::fixed << std::setprecision(2)
+                  << std::setw(10) << summary.requestsPerSecond << " req/s"
+                  << "  p50 " << summary.p50
+                  << "  p90 " << summary.p90
+                  << "  p99 " << summary.p99
+                  << "  p99.9 " << summary.p999
+                  << "  max " << summary.max << " ms"
+                  << "  errors " << summary.errors << std::endl;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    LoadOptions options;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        bool hasValue = i + 1 < argc;
+
+        if (std::strcmp(argv[i], "--host") == 0 && hasValue)
+        {
+            options.host = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--port") == 0 && hasValue)
+        {
+            options.port = std::atoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--connections") == 0 && hasValue)
+        {
+            options.connections = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--duration") == 0 && hasValue)
+        {
+            options.duration = std::atof(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--path") == 0 && hasValue)
+        {
+            options.paths.push_back(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--output") == 0 && hasValue)
+        {
+            options.outputPath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--self") == 0)
+        {
+            options.self = true;
+        }
+        else if (std::strcmp(argv[i], "--web") == 0 && hasValue)
+        {
+            options.webRoot = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--threads") == 0 && hasValue)
+        {
+            options.server.threads = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--queued") == 0 && hasValue)
+        {
+            options.server.maxQueued = std::atoi(argv[++i]);
+        }
+        else
+        {
+            printUsage();
+            return std::strcmp(argv[i], "--help") == 0 ? 0 : 2;
+        }
+    }
+
+    if (options.paths.empty())
+    {
+        options.paths = {"/rcontrol/", "/api"};
+    }
+
+    // Same factory and parameters as the demo, on a loopback port picked by the system
+    std::unique_ptr<Poco::ThreadPool> threadPool;
+    std::unique_ptr<Poco::Net::HTTPServer> server;
+
+    if (options.self)
+    {
+        threadPool.reset(new Poco::ThreadPool(std::min(2, options.server.threads), options.server.threads));
+        server.reset(new Poco::Net::HTTPServer(new RequestHandlerFactory(options.webRoot), *threadPool,
+                                               Poco::Net::ServerSocket(Poco::Net::SocketAddress("127.0.0.1", Poco::UInt16(0))),
+                                               WebServer::createParams(options.server)));
+        server->start();
+
+        options.host = "127.0.0.1";
+        options.port = server->port();
+    }
+
+    std::cout << options.connections << " connections for " << options.duration << " s against "
+              << options.host << ":" << options.port << std::endl;
+
+    std::vector<std::vector<PathResults>> connectionResults(options.connections, std::vector<PathResults>(options.paths.size()));
+    std::vector<std::thread> workers;
+
+    Clock::time_point start = Clock::now();
+    Clock::time_point deadline = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.duration));
+
+    for (int i = 0; i < options.connections; ++i)
+    {
+        workers.emplace_back(runConnection, std::cref(options), deadline, std::ref(connectionResults[i]));
+    }
+
+    for (std::thread &worker : workers)
+    {
+        worker.join();
+    }
+
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    if (server)
+    {
+        server->stopAll(true);
+        server.reset();
+        threadPool->joinAll();
+    }
+
+    std::vector<float> allLatencies;
+    uint64_t allErrors = 0;
+    json paths = json::object();
+
+    for (size_t p = 0; p < options.paths.size(); ++p)
+    {
+        std::vector<float> latencies;
+        uint64_t errors = 0;
+
+        for (const std::vector<PathResults> &results : connectionResults)
+        {
+            latencies.insert(latencies.end(), results[p].latencies.begin(), results[p].latencies.end());
+            errors += results[p].errors;
+        }
+
+        allLatencies.insert(allLatencies.end(), latencies.begin(), latencies.end());
+        allErrors += errors;
+
+        Summary summary = summarize(latencies, errors, seconds);
+        printSummary(options.paths[p], summary);
+        paths[options.paths[p]] = toJson(summary);
+    }
+
+    Summary total = summarize(allLatencies, allErrors, seconds);
+    printSummary("total", total);
+
+    if (!options.outputPath.empty())
+    {
+        json result = {
+            {"schema", 1},
+            {"commit", DEMO_GIT_COMMIT},
+            {"host", options.host},
+            {"port", options.port},
+            {"self", options.self},
+            {"connections", options.connections},
+            {"duration_s", seconds},
+            {"server", {
+                {"threads", options.server.threads},
+                {"maxQueued", options.server.maxQueued},
+            }},
+            {"total", toJson(total)},
+            {"paths", paths},
+        };
+
+        std::ofstream file(options.outputPath);
+        file << result.dump(2) << std::endl;
+
+        if (!file)
+        {
+            std::cerr << "Could not write " << options.outputPath << std::endl;
+            return 1;
+        }
+    }
+
+    return total.errors > 0 ? 1 : 0;
+}
@@ -3,26 +3,36 @@
 #include <chrono>
 #include <filesystem>
 #include <algorithm>
+#include <future>
 
 #include "imgui.h"
 #include "backends/imgui_impl_glfw.h"
 #include "backends/imgui_impl_opengl3.h"
 #include "misc/freetype/imgui_freetype.h"
-#include <GLFW/glfw3.h>
-
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
+#include "opengl.h"
 
 #include <opencv2/opencv.hpp>
-#include <opencv2/objdetect.hpp>
 
-namespace fs = std::filesystem;
+#include <Poco/URI.h>
 
-struct ImageTexture
-{
-    GLuint textureID;
-    int width, height;
-};
+#include "cue_list.h"
+#include "folder_watcher.h"
+#include "frame_profiler.h"
+#include "image_grid.h"
+#include "headless.h"
+#include "image_library.h"
+#include "network_monitor.h"
+#include "preview_capture.h"
+#include "projector.h"
+#include "qr_code.h"
+#include "sdf_font.h"
+#include "startup_trace.h"
+#include "streaming_texture.h"
+#include "text_layout.h"
+#include "video_player.h"
+#include "web_server.h"
+
+namespace fs = std::filesystem;
 
 // dialog
 #include "portable-file-dialogs/portable-file-dialogs.h"
@@ -31,276 +41,31 @@ struct ImageTexture
 #include <nlohmann/json.hpp>
 using json = nlohmann::json;
 
-// HTTP
-#include <Poco/Net/ServerSocket.h>
-#include <Poco/Net/HTTPServer.h>
-#include <Poco/Net/HTTPRequestHandler.h>
-#include <Poco/Net/HTTPRequestHandlerFactory.h>
-#include <Poco/Net/HTTPServerRequest.h>
-#include <Poco/Net/HTTPServerResponse.h>
-#include <Poco/Util/ServerApplication.h>
-#include <Poco/Net/NetworkInterface.h>
-#include <Poco/URI.h>
-#include <Poco/Path.h>
-#include <Poco/File.h>
 #include <fstream>
 
-using namespace Poco::Net;
-using namespace Poco::Util;
-using namespace std;
-
-class FileRequestHandler : public HTTPRequestHandler
+// Caminho local de uma mídia enviada pelo controle remoto, as URLs do
+// próprio servidor em /media/ apontam para a pasta do projeto
+std::string resolveRemoteSource(const std::string &src, const std::string &projectPath)
 {
-public:
-    void handleRequest(HTTPServerRequest &req, HTTPServerResponse &resp) override
+    size_t mediaStart = src.find("/media/");
+    if (mediaStart != std::string::npos)
     {
-        // Exemplo: http://localhost:8080/rcontrol/?api_url=http://localhost:8080/api
-
-        // O diretório base onde os arquivos estão localizados
-        const std::string basePath = "./web"; // Assegura que aponta para a pasta 'web' no diretório atual
-
-        // Extrai o caminho do URI da solicitação e forma o caminho do arquivo
-        std::string requestedPath = req.getURI();
-
-        // Remove os parâmetros de consulta (tudo após '?')
-        size_t queryStart = requestedPath.find('?');
-        if (queryStart != std::string::npos)
-        {
-            requestedPath = requestedPath.substr(0, queryStart);
-        }
-
-        // Prevenção simples contra Directory Traversal Attack
-        if (requestedPath.find("..") != std::string::npos)
-        {
-            resp.setStatus(HTTPResponse::HTTP_FORBIDDEN);
-            resp.send() << "403 - Forbidden";
-            return;
-        }
-
-        if (requestedPath.back() == '/')
-        {
-            requestedPath += "index.html";
-        }
-        else if (requestedPath == "/")
-        { // Se nenhum caminho for especificado, usar '/index.html'
-            requestedPath = "/index.html";
-        }
-
-        // Constrói o caminho final do arquivo solicitado
-        std::string fullPath = basePath + requestedPath;
-
-        Poco::File file(fullPath);
-
-        if (file.exists())
-        {
-            if (file.isDirectory())
-            {
-                fullPath = Poco::Path(fullPath).append("index.html").toString();
-                file = Poco::File(fullPath);
-            }
-        }
-
-        if (file.exists() && file.isFile())
-        {
-            // Determina o tipo de conteúdo baseado na extensão do arquivo
-            std::string contentType = "text/plain"; // Default content type
-            if (fullPath.find(".html") != std::string::npos)
-            {
-                contentType = "text/html";
-            }
-            else if (fullPath.find(".js") != std::string::npos)
-            {
-                contentType = "application/javascript";
-            }
-            else if (fullPath.find(".css") != std::string::npos)
-            {
-                contentType = "text/css";
-            }
-            else if (fullPath.find(".png") != std::string::npos)
-            {
-                contentType = "image/png";
-            }
-            else if (fullPath.find(".jpg") != std::string::npos || fullPath.find(".jpeg") != std::string::npos)
-            {
-                contentType = "image/jpeg";
-            }
-
-            // Lê e envia o arquivo
-            std::ifstream fileStream(fullPath, std::ifstream::binary);
-            std::ostringstream ss;
-            ss << fileStream.rdbuf(); // Lê todo o conteúdo do arquivo
-            std::string content = ss.str();
-
-            resp.setStatus(HTTPResponse::HTTP_OK);
-            resp.setContentType(contentType);
-            std::ostream &out = resp.send();
-            out << content;
-        }
-        else
-        {
-            // Arquivo não encontrado
-            resp.setStatus(HTTPResponse::HTTP_NOT_FOUND);
-            resp.send() << "404 - Not Found";
-        }
+        std::string relativePath;
+        Poco::URI::decode(src.substr(mediaStart + std::string("/media/").size()), relativePath);
+        return relativePath.find("..") == std::string::npos ? projectPath + "/" + relativePath : std::string();
     }
-};
 
-class APIRequestHandler : public HTTPRequestHandler
-{
-public:
-    void handleRequest(HTTPServerRequest &req, HTTPServerResponse &resp) override
+    // Outras URLs não são baixadas
+    if (src.find("://") != std::string::npos)
     {
-        resp.setStatus(HTTPResponse::HTTP_OK);
-        resp.setContentType("application/json");
-
-        ostream &out = resp.send();
-        out << R"({"message": "This is a JSON response from API"})";
-        out.flush();
-    }
-};
-
-class RequestHandlerFactory : public HTTPRequestHandlerFactory
-{
-public:
-    HTTPRequestHandler *createRequestHandler(const HTTPServerRequest &request) override
-    {
-        Poco::URI uri(request.getURI());
-        if (uri.getPath().find("/api") == 0)
-        {
-            return new APIRequestHandler;
-        }
-        else
-        {
-            return new FileRequestHandler;
-        }
-    }
-};
-
-class WebServer
-{
-public:
-    bool serverRunning = false;
-    HTTPServer *server = nullptr;
-
-    WebServer() : server(nullptr) {}
-
-    void start(const std::string &host, int port)
-    {
-        if (host.empty())
-        {
-            return;
-        }
-
-        if (port <= 0)
-        {
-            return;
-        }
-
-        if (serverRunning)
-        {
-            return; // Impede iniciar múltiplas vezes
-        }
-
-        try
-        {
-            Poco::Net::SocketAddress sa(host, port);
-            server = new HTTPServer(new RequestHandlerFactory, ServerSocket(sa), new HTTPServerParams);
-            server->start();
-            std::cout << "Server started on " << host << ":" << port << "." << std::endl;
-            serverRunning = true;
-        }
-        catch (Poco::Exception &e)
-        {
-            std::cerr << "Error: " << e.displayText() << std::endl;
-        }
-    }
-
-    void stop()
-    {
-        if (!serverRunning)
-            return; // Impede parar se não estiver rodando
-        try
-        {
-            if (server)
-            {
-                server->stop();
-                delete server;
-                server = nullptr;
-                std::cout << "Server stopped." << std::endl;
-                serverRunning = false;
-            }
-        }
-        catch (Poco::Exception &e)
-        {
-            std::cerr << "Error: " << e.displayText() << std::endl;
-        }
-    }
-
-    std::string getLocalIPAddress()
-    {
-        // Obtém todas as interfaces de rede
-        Poco::Net::NetworkInterface::Map map = Poco::Net::NetworkInterface::map();
-        std::string localIP = "127.0.0.1"; // Endereço padrão caso não encontre uma interface externa
-
-        for (const auto &m : map)
-        {
-            // Procura por uma interface de rede IPv4 que não seja loopback (127.0.0.1), esteja ativa e não seja um gateway
-            if (!m.second.isLoopback() && m.second.supportsIPv4() && m.second.isUp())
-            {
-                const auto &ips = m.second.addressList();
-                for (const auto &ipa : ips)
-                {
-                    if (ipa.get<0>().family() == Poco::Net::AddressFamily::IPv4)
-                    {
-                        Poco::Net::IPAddress ip = ipa.get<0>();
-                        if (!ip.isLoopback() && !ip.isWildcard() && ip.isUnicast() && !ip.isBroadcast())
-                        {
-                            localIP = ip.toString();
-                            // Retorna o primeiro endereço IP válido encontrado que não é um gateway
-                            return localIP;
-                        }
-                    }
-                }
-            }
-        }
-
-        // Retorna o endereço loopback caso não encontre um endereço externo válido
-        return localIP;
+        return std::string();
     }
 
-    std::vector<std::string> getAvailableIPAddresses()
-    {
-        std::vector<std::string> ipAddresses;
-        Poco::Net::NetworkInterface::Map map = Poco::Net::NetworkInterface::map();
-        for (const auto &m : map)
-        {
-            if (!m.second.isLoopback() && m.second.supportsIPv4() && m.second.isUp())
-            {
-                const auto &ips = m.second.addressList();
-                for (const auto &ipa : ips)
-                {
-                    if (ipa.get<0>().family() == Poco::Net::AddressFamily::IPv4)
-                    {
-                        Poco::Net::IPAddress ip = ipa.get<0>();
-                        if (!ip.isLoopback() && ip.isUnicast())
-                        {
-                            ipAddresses.push_back(ip.toString());
-                        }
-                    }
-                }
-            }
-        }
-        // Inclui o loopback caso não encontre endereços externos
-        if (ipAddresses.empty())
-        {
-            ipAddresses.push_back("127.0.0.1");
-        }
-        return ipAddresses;
-    }
-};
+    return fs::path(src).is_absolute() ? src : projectPath + "/" + src;
+}
 
 // Função para carregar as configurações
-void loadSettings(std::string &projectPath, int &port)
+void loadSettings(std::string &projectPath, int &port, int &textureBudgetMB, ServerSettings &serverSettings, PreviewSettings &previewSettings)
 {
     // Define o caminho do arquivo de configuração
     std::string configPath = "config.json";
@@ -315,6 +80,28 @@ void loadSettings(std::string &projectPath, int &port)
         // Carrega a pasta do projeto e a porta do arquivo JSON
         projectPath = j["projectPath"];
         port = j.value("port", 8080);
+        textureBudgetMB = j.value("textureBudgetMB", 256);
+
+        // Concorrência do servidor, valores ausentes ficam com o padrão
+        if (j.contains("server"))
+        {
+            const json &server = j["server"];
+            serverSettings.threads = server.value("threads", serverSettings.threads);
+            serverSettings.maxQueued = server.value("maxQueued", serverSettings.maxQueued);
+            serverSettings.keepAlive = server.value("keepAlive", serverSettings.keepAlive);
+            serverSettings.maxKeepAliveRequests = server.value("maxKeepAliveRequests", serverSettings.maxKeepAliveRequests);
+            serverSettings.keepAliveTimeoutMs = server.value("keepAliveTimeoutMs", serverSettings.keepAliveTimeoutMs);
+            serverSettings.timeoutMs = server.value("timeoutMs", serverSettings.timeoutMs);
+        }
+
+        // Prévia ao vivo do projetor em /api/preview.mjpeg
+        if (j.contains("preview"))
+        {
+            const json &preview = j["preview"];
+            previewSettings.fps = preview.value("fps", previewSettings.fps);
+            previewSettings.width = preview.value("width", previewSettings.width);
+            previewSettings.quality = preview.value("quality", previewSettings.quality);
+        }
 
         configFile.close();
     }
@@ -323,11 +110,12 @@ void loadSettings(std::string &projectPath, int &port)
         // Valores padrão caso o arquivo de configuração não exista
         projectPath = "";
         port = 8080;
+        textureBudgetMB = 256;
     }
 }
 
 // Função para salvar as configurações
-void saveSettings(const std::string &projectPath, int port)
+void saveSettings(const std::string &projectPath, int port, int textureBudgetMB, const ServerSettings &serverSettings, const PreviewSettings &previewSettings)
 {
     // Define o caminho do arquivo de configuração
     std::string configPath = "config.json";
@@ -337,6 +125,20 @@ void saveSettings(const std::string &projectPath, int port)
     json j;
     j["projectPath"] = projectPath;
     j["port"] = port;
+    j["textureBudgetMB"] = textureBudgetMB;
+    j["server"] = {
+        {"threads", serverSettings.threads},
+        {"maxQueued", serverSettings.maxQueued},
+        {"keepAlive", serverSettings.keepAlive},
+        {"maxKeepAliveRequests", serverSettings.maxKeepAliveRequests},
+        {"keepAliveTimeoutMs", serverSettings.keepAliveTimeoutMs},
+        {"timeoutMs", serverSettings.timeoutMs},
+    };
+    j["preview"] = {
+        {"fps", previewSettings.fps},
+        {"width", previewSettings.width},
+        {"quality", previewSettings.quality},
+    };
 
     // Salva no arquivo
     configFile << j.dump(4); // Indentação de 4 espaços para melhor leitura
@@ -344,180 +146,6 @@ void saveSettings(const std::string &projectPath, int port)
     configFile.close();
 }
 
-// Function to generate QRCode
-GLuint generateQRCodeTexture(const std::string &data)
-{
-    cv::QRCodeEncoder::Params params;
-    params.mode = cv::QRCodeEncoder::EncodeMode::MODE_BYTE; // Modo de codificação do QR Code
-    cv::Ptr<cv::QRCodeEncoder> encoder = cv::QRCodeEncoder::create(params);
-
-    std::vector<cv::Mat> qrcodes;
-
-    // Gera o QR Code
-    encoder->encodeStructuredAppend(data, qrcodes);
-    if (qrcodes.empty())
-        return 0; // Verifica se a geração foi bem-sucedida
-
-    // Considerando apenas o primeiro QR Code para a textura
-    cv::Mat qrCode = qrcodes.front();
-
-    // Redimensiona o QR Code para uma resolução mais alta
-    cv::Mat qrCodeHighRes;
-    int newSize = 1024; // Nova dimensão quadrada para a imagem
-    cv::resize(qrCode, qrCodeHighRes, cv::Size(newSize, newSize), 0, 0, cv::INTER_NEAREST);
-
-    // Converte para RGBA
-    cv::Mat qrCodeRGBA;
-    cvtColor(qrCodeHighRes, qrCodeRGBA, cv::COLOR_BGR2RGBA);
-
-    // Gera uma textura OpenGL a partir da imagem RGBA
-    GLuint textureID;
-    glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_2D, textureID);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, qrCodeRGBA.cols, qrCodeRGBA.rows, 0, GL_RGBA, GL_UNSIGNED_BYTE, qrCodeRGBA.data);
-
-    return textureID;
-}
-
-// Function to load texture from image
-ImageTexture LoadTextureFromImage(const char *imagePath)
-{
-    ImageTexture imgTexture = {0, 0, 0};
-    int width, height, channels;
-    unsigned char *data = stbi_load(imagePath, &width, &height, &channels, 0);
-    if (data == nullptr)
-    {
-        std::cerr << "Error loading image: " << imagePath << std::endl;
-        return imgTexture;
-    }
-
-    glGenTextures(1, &imgTexture.textureID);
-    glBindTexture(GL_TEXTURE_2D, imgTexture.textureID);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, channels == 4 ? GL_RGBA : GL_RGB, GL_UNSIGNED_BYTE, data);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-    stbi_image_free(data);
-
-    imgTexture.width = width;
-    imgTexture.height = height;
-
-    return imgTexture;
-}
-
-void TextAutoSizedAndCentered(const std::string &text, ImFont *font, bool useDisplaySize)
-{
-    ImGuiIO &io = ImGui::GetIO();
-
-    // Define padding
-    float paddingX = 20.0f; // Horizontal padding
-    float paddingY = 20.0f; // Vertical padding
-
-    ImVec2 baseSize; // Initialize base size
-    ImVec2 basePos;  // Initialize base position
-
-    if (useDisplaySize)
-    {
-        if (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable)
-        {
-            // When viewports are enabled, use the main viewport's size and position
-            ImGuiViewport *mainViewport = ImGui::GetMainViewport();
-            baseSize = mainViewport->Size;
-            basePos = mainViewport->Pos;
-        }
-        else
-        {
-            // If viewports are not enabled, use the display size and position (0, 0)
-            baseSize = io.DisplaySize;
-            basePos = ImVec2(0, 0);
-        }
-    }
-    else
-    {
-        // When not using display size, use the current window's size and position
-        baseSize = ImGui::GetWindowSize();
-        basePos = ImGui::GetWindowPos();
-    }
-
-    // Ensure there's a minimum size for drawing text
-    baseSize.x = (std::max)(baseSize.x, 1.0f); // Minimum width
-    baseSize.y = (std::max)(baseSize.y, 1.0f); // Minimum height
-
-    // Calculates available area considering padding
-    float availableWidth = baseSize.x - 2 * paddingX;
-    float availableHeight = baseSize.y - 2 * paddingY;
-
-    // Finds the required width for the text and the number of lines
-    float maxLineWidth = 0.0f;
-    int lineCount = 0;
-    std::istringstream stream(text);
-    std::string line;
-    while (std::getline(stream, line))
-    {
-        ImVec2 lineSize = font->CalcTextSizeA(font->FontSize, FLT_MAX, 0.0f, line.c_str());
-        if (lineSize.x > maxLineWidth)
-        {
-            maxLineWidth = lineSize.x;
-        }
-        lineCount++;
-    }
-
-    // Adjusts the font size if the longest line is wider than the available space
-    float scaleFactor = (maxLineWidth > availableWidth) ? (availableWidth / maxLineWidth) : 1.0f;
-    float fontSize = font->FontSize * scaleFactor;
-
-    // Ensures the text block fits vertically within the available height
-    float totalTextHeight = fontSize * lineCount;
-    if (totalTextHeight > availableHeight)
-    {
-        fontSize *= availableHeight / totalTextHeight;
-    }
-
-    // Prepares to draw the text
-    ImDrawList *drawList = ImGui::GetForegroundDrawList();
-
-    // Text and outline colors
-    ImU32 textColor = IM_COL32(255, 255, 255, 255);
-    ImU32 outlineColor = IM_COL32(0, 0, 0, 255);
-
-    // Resets the stream to draw the text
-    stream.clear();
-    stream.seekg(0, std::ios::beg);
-
-    // Calculates the starting y position to center the text block vertically
-    float textPosY = basePos.y + paddingY + (availableHeight - fontSize * lineCount) / 2.0f;
-
-    // Draws the text line by line
-    while (std::getline(stream, line))
-    {
-        ImVec2 lineSize = font->CalcTextSizeA(fontSize, FLT_MAX, 0.0f, line.c_str());
-
-        // Centers each line of text
-        float textPosX = basePos.x + paddingX + (availableWidth - lineSize.x) / 2.0f;
-
-        // Draws the outline
-        float outlineThickness = 1.0f;
-        for (int x = -outlineThickness; x <= outlineThickness; ++x)
-        {
-            for (int y = -outlineThickness; y <= outlineThickness; ++y)
-            {
-                if (x != 0 || y != 0)
-                {
-                    drawList->AddText(font, fontSize, ImVec2(textPosX + x, textPosY + y), outlineColor, line.c_str());
-                }
-            }
-        }
-
-        // Draws the line of text
-        drawList->AddText(font, fontSize, ImVec2(textPosX, textPosY), textColor, line.c_str());
-
-        // Moves to the next line
-        textPosY += fontSize;
-    }
-}
-
 void windowCloseCallback(GLFWwindow *window)
 {
     glfwDestroyWindow(window);
@@ -534,8 +162,20 @@ void windowKeyCallback(GLFWwindow *window, int key, int scancode, int action, in
     }
 }
 
-int main()
+int main(int argc, char **argv)
 {
+    // Offscreen projector output driven by a script, needs no window or display
+    if (argc >= 3 && std::string(argv[1]) == "--headless")
+    {
+        std::string outputPath = argc >= 5 && std::string(argv[3]) == "--output" ? argv[4] : "";
+        return runHeadless(argv[2], outputPath);
+    }
+
+    // Nothing but the window and the UI fonts is loaded before the first
+    // frame, the rest completes in the background in priority order
+    StartupTrace startupTrace;
+    int startupPhase = startupTrace.begin("Window");
+
     if (!glfwInit())
     {
         std::cerr << "Error initializing GLFW." << std::endl;
@@ -562,6 +202,8 @@ int main()
     glfwMakeContextCurrent(window);
     glfwSwapInterval(1); // Enable vsync
 
+    startupTrace.end(startupPhase);
+
     // Video window
     GLFWwindow *videoWindow = nullptr;
 
@@ -578,6 +220,7 @@ int main()
     */
 
     // ImGui initialization
+    startupPhase = startupTrace.begin("ImGui and UI fonts");
     IMGUI_CHECKVERSION();
     ImGui::CreateContext();
     ImGuiIO &io = ImGui::GetIO();
@@ -615,128 +258,376 @@ int main()
         std::cerr << "Error while load font." << std::endl;
     }
 
-    ImFont *fontPlayerText = io.Fonts->AddFontFromFileTTF("fonts/Poppins-Bold.ttf", 500, &fontConfig, io.Fonts->GetGlyphRangesDefault());
-
-    if (!fontPlayerText)
-    {
-        std::cerr << "Error while load font." << std::endl;
-    }
-
     // Load implementations for ImGui
     ImGui_ImplGlfw_InitForOpenGL(window, true);
     ImGui_ImplOpenGL3_Init();
 
+    startupTrace.end(startupPhase);
+
+    // Projector text, baked once as a distance field instead of a 500 px atlas.
+    // The bake runs in the background, the texture is uploaded when it is done
+    SdfFont fontPlayerText;
+    bool fontPlayerTextReady = false;
+    int fontPlayerTextPhase = -1;
+    std::future<bool> fontPlayerTextLoad;
+
     // Load settings
     std::string selectedProjectPath;
     int serverPort;
+    int textureBudgetMB;
+    ServerSettings serverSettings;
+    PreviewSettings previewSettings;
+
+    startupPhase = startupTrace.begin("Settings");
+    loadSettings(selectedProjectPath, serverPort, textureBudgetMB, serverSettings, previewSettings);
+    startupTrace.end(startupPhase);
 
-    loadSettings(selectedProjectPath, serverPort);
+    // Owns the image textures and keeps them under the configured budget
+    TextureManager textureManager(static_cast<size_t>(textureBudgetMB) * 1024 * 1024);
 
-    // Load images from directory
-    std::vector<ImageTexture> textures;
+    // Fixed size for grid cells, thumbnails are generated to fit it
+    const ImVec2 cellSize(120.0f, 80.0f);
+
+    // Load images from directory, decoding happens on the pool threads
+    ImageLibrary imageLibrary(textureManager, "cache/thumbnails", static_cast<int>(cellSize.x), static_cast<int>(cellSize.y));
     std::string pathToImages;
 
+    // Time the render thread may spend uploading decoded images per frame
+    const double imageUploadBudgetMs = 4.0;
+
     if (!selectedProjectPath.empty())
     {
         pathToImages = selectedProjectPath + "/images";
     }
 
-    if (fs::is_directory(pathToImages))
+    // Files added, changed or removed later reach the catalog one by one.
+    // Watched before the listing so no change falls in between.
+    FolderWatcher imageWatcher;
+    std::vector<FolderChange> imageChanges;
+    imageWatcher.watch(pathToImages);
+
+    // Only the folder listing blocks, thumbnails are decoded on the pool
+    startupPhase = startupTrace.begin("Image catalog");
+    imageLibrary.open(pathToImages);
+    startupTrace.end(startupPhase);
+
+    int thumbnailsPhase = startupTrace.begin("Image thumbnails", true);
+    bool thumbnailsLoading = true;
+
+    // Projector cues, the next one is loaded ahead so go switches within a frame
+    CueList cueList(textureManager);
+
+    // Opened on the player thread once it is its turn, frames are decoded there
+    // too. A missing video leaves the media area empty instead of ending the program
+    const std::string videoPath = "videos/video1.mp4";
+    VideoPlayer videoPlayer;
+    int videoPhase = -1;
+    bool videoOpening = false;
+
+    // Background loading in priority order: the thumbnails the operator picks
+    // from, then the video, then the projector font. Each stage starts once the
+    // previous one is in, or has had a moment to itself when it takes longer.
+    enum class StartupStage
     {
-        for (const auto &entry : fs::directory_iterator(pathToImages))
-        {
-            if (entry.is_regular_file())
-            {
-                textures.push_back(LoadTextureFromImage(entry.path().string().c_str()));
-            }
-        }
-    }
+        Thumbnails,
+        Video,
+        Started
+    };
 
-    // Open video file
-    cv::VideoCapture video("videos/video1.mp4");
-    if (!video.isOpened())
-    {
-        std::cerr << "Error opening video." << std::endl;
-        return -1;
-    }
+    StartupStage startupStage = StartupStage::Thumbnails;
+    auto startupStageStart = std::chrono::steady_clock::now();
+    const std::chrono::milliseconds startupStageDelay(500);
 
-    cv::Mat frame;
+    StreamingTexture videoStream;
     GLuint videoTexture = 0;
 
     int videoWidth = 0;
     int videoHeight = 0;
+    double videoPositionMs = 0.0;
     int videoStartFlags = ImGuiWindowFlags_NoScrollbar | ImGuiWindowFlags_NoScrollWithMouse | ImGuiWindowFlags_HorizontalScrollbar | ImGuiWindowFlags_NoFocusOnAppearing;
     bool isVideoPlaying = true;
 
-    GLuint selectedImageTexture = 0;
-    int selectedImageWidth = 0, selectedImageHeight = 0;
-
     int monitorsCount;
 
-    double fps = video.get(cv::CAP_PROP_FPS);
-    auto frameDuration = std::chrono::milliseconds(static_cast<int>(1000 / fps));
-    std::chrono::steady_clock::time_point lastFrameTime = std::chrono::steady_clock::now();
-
     bool starting = true;
 
+    // Projector screen, set from the panel and the remote control
+    ProjectorMode projectorMode = ProjectorMode::Default;
+    bool projectorVisible = true;
+    std::string projectorText = "DEUS ENVIOU\nSEU FILHO AMADO\nPRA PERDOAR\nPRA ME SALVAR";
+    uint64_t cueSwitches = 0;
+    GLuint selectedTexture = 0;
+    uint64_t catalogVersion = 0;
+    std::string selectedImagePath;
+    PlayerState publishedState; // Last state sent to the remote controls
+
     // server
     WebServer webServer;
+    webServer.setMediaRoot(selectedProjectPath); // Project files under /media/
+    webServer.preview().configure(previewSettings);
+
+    // Projector output for /api/preview.mjpeg, only captured while someone watches
+    PreviewCapture previewCapture;
+
+    // Projector text, laid out and rendered again only when the slide changes
+    TextSlide projectorSlide;
+    ImDrawList *projectorDrawList = nullptr;
+    ImVec2 projectorPos;
+    ImVec2 projectorSize;
+
+    // Puts a project image on the projector, from the grid or the remote control
+    auto showImage = [&](size_t index)
+    {
+        isVideoPlaying = false;                 // Para a reprodução do vídeo
+        videoTexture = 0;                       // Reseta a textura do vídeo se necessário
+        cueList.stop();                         // A seleção direta substitui as cues
+        projectorMode = ProjectorMode::Default; // Volta para a tela padrão
+        selectedImagePath = imageLibrary.entries()[index].path;
+        imageLibrary.selectImage(index); // Carrega a imagem em resolução completa
+    };
+
+    // Remote control functions, they run on this thread from rpc().drain()
+    RpcDispatcher &rpc = webServer.rpc();
+
+    rpc.addCommand("modules.player.show", [&](const json &)
+                   {
+        projectorVisible = true;
+        return true; });
+
+    rpc.addCommand("modules.player.hide", [&](const json &)
+                   {
+        projectorVisible = false;
+        return true; });
+
+    rpc.addCommand("modules.player.update_data", [&](const json &params)
+                   {
+        std::string type = params.value("type", "");
+
+        if (type == "text")
+        {
+            projectorText = params.value("text", "");
+            projectorMode = ProjectorMode::Text;
+            return true;
+        }
+
+        if (type == "black")
+        {
+            projectorMode = ProjectorMode::Black;
+            return true;
+        }
+
+        if (type != "image" && type != "video")
+        {
+            std::cerr << "Remote: unknown type " << type << "." << std::endl;
+            return true;
+        }
+
+        std::string path = resolveRemoteSource(params.value("src", ""), selectedProjectPath);
+        if (path.empty())
+        {
+            std::cerr << "Remote: only project media can be shown." << std::endl;
+            return true;
+        }
+
+        // Loaded as a single cue, the change is on screen when the cue switches
+        isVideoPlaying = false;
+        videoTexture = 0;
+        cueList.clear();
+        cueList.add(type == "image" ? CueType::Image : CueType::Video, path);
+        cueList.go(0);
+        projectorMode = ProjectorMode::Media;
+        return false; });
+
+    rpc.addCommand("modules.images.select", [&](const json &params)
+                   {
+        // Ids of an older listing may point to another image
+        uint64_t generation = params.value("generation", webServer.images().snapshot()->generation);
+        size_t id = params.value("id", imageLibrary.size());
+
+        if (generation != webServer.images().snapshot()->generation || id >= imageLibrary.size())
+        {
+            return true;
+        }
+
+        showImage(id);
+        return false; });
+
+    rpc.addQuery("modules.system.get_settings", [&](const json &)
+                 { return json{
+                       {"projectPath", selectedProjectPath},
+                       {"port", serverPort},
+                       {"mediaUrl", "/media/"},
+                       {"eventsUrl", "/api/events"},
+                       {"visible", projectorVisible},
+                       {"text", projectorText},
+                   }; });
+
+    // Interfaces are enumerated off the render thread, the Settings tab reads the last snapshot
+    NetworkMonitor networkMonitor;
+    std::string selectedAddress; // Endereço escolhido para o servidor, vazio usa o primeiro
 
     GLuint qrCodeTexture = 0; // ID da textura OpenGL para o QR Code
     std::string lastUrl;      // Última URL usada para gerar o QR Code
+    uint64_t qrNetworkVersion = 0;
+    int qrPort = 0;
+    std::string qrAddress;
+
+    // Per-stage frame timings, F3 toggles the overlay
+    FrameProfiler profiler(60.0);
+    const int stageEvents = profiler.addStage("Events");
+    const int stageImageUploads = profiler.addStage("Image uploads");
+    const int stageVideoDecode = profiler.addStage("Video decode (thread)");
+    const int stageVideoUpload = profiler.addStage("Video upload");
+    const int stageCues = profiler.addStage("Cues");
+    const int stageBuild = profiler.addStage("UI build");
+    const int stageRender = profiler.addStage("Main render");
+    const int stagePreview = profiler.addStage("Preview capture");
+    const int stagePlatform = profiler.addStage("Platform windows");
+    const int stageSwap = profiler.addStage("Swap");
+    bool showProfiler = false;
 
     while (!glfwWindowShouldClose(window))
     {
+        profiler.beginFrame();
+
+        profiler.begin(stageEvents);
         glfwPollEvents();
 
-        // Get video frame
-        auto currentTime = std::chrono::steady_clock::now();
-        if (isVideoPlaying)
+        // Remote control calls queued by the HTTP threads since the last frame
+        rpc.drain();
+        profiler.end(stageEvents);
+
+        // Uploads and timer queries belong to the main context
+        glfwMakeContextCurrent(window);
+
+        // Next background startup stage
+        bool startupStageWaited = std::chrono::steady_clock::now() - startupStageStart >= startupStageDelay;
+
+        if (startupStage == StartupStage::Thumbnails && (!thumbnailsLoading || startupStageWaited))
+        {
+            videoPlayer.openAsync(videoPath);
+            videoPhase = startupTrace.begin("Video open", true);
+            videoOpening = true;
+
+            startupStage = StartupStage::Video;
+            startupStageStart = std::chrono::steady_clock::now();
+        }
+        else if (startupStage == StartupStage::Video && (!videoOpening || startupStageWaited))
+        {
+            fontPlayerTextPhase = startupTrace.begin("Projector font", true);
+            fontPlayerTextLoad = std::async(std::launch::async, [&]()
+                                            {
+                bool loaded = fontPlayerText.load("fonts/Poppins-Bold.ttf");
+                startupTrace.end(fontPlayerTextPhase);
+                return loaded; });
+
+            startupStage = StartupStage::Started;
+        }
+
+        // Background startup work that finished since the last frame
+        if (fontPlayerTextLoad.valid() && fontPlayerTextLoad.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
         {
-            if (std::chrono::duration_cast<std::chrono::milliseconds>(currentTime - lastFrameTime) >= frameDuration)
+            if (fontPlayerTextLoad.get() && fontPlayerText.upload())
             {
-                if (video.read(frame))
-                {
-                    // Convert BGR to RGBA
-                    cv::Mat frameRGBA;
-                    cv::cvtColor(frame, frameRGBA, cv::COLOR_BGR2RGBA);
+                fontPlayerTextReady = true;
+                std::cout << "Projector font: " << fontPlayerText.glyphCount() << " glyphs, " << fontPlayerText.atlasWidth() << "x" << fontPlayerText.atlasHeight() << " atlas, " << fontPlayerText.atlasBytes() / 1024 << " KB, baked in " << fontPlayerText.bakeMs() << " ms." << std::endl;
+            }
+            else
+            {
+                std::cerr << "Error while load font." << std::endl;
+            }
+        }
 
-                    // Update video texture
-                    if (videoTexture == 0)
-                    {
-                        glGenTextures(1, &videoTexture);
-                        glBindTexture(GL_TEXTURE_2D, videoTexture);
-                        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-                        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-                    }
+        if (videoOpening && (videoPlayer.frameReady() || videoPlayer.failed()))
+        {
+            videoOpening = false;
+            startupTrace.end(videoPhase);
 
-                    glBindTexture(GL_TEXTURE_2D, videoTexture);
-                    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, frameRGBA.cols, frameRGBA.rows, 0, GL_RGBA, GL_UNSIGNED_BYTE, frameRGBA.data);
+            if (videoPlayer.failed())
+            {
+                std::cerr << "Error opening video." << std::endl;
+            }
+        }
 
-                    if (videoWidth == 0 || videoHeight == 0)
-                    {
-                        videoWidth = frame.cols;
-                        videoHeight = frame.rows;
-                    }
+        // Upload images decoded since the last frame
+        profiler.begin(stageImageUploads);
+        if (imageWatcher.poll(imageChanges))
+        {
+            imageLibrary.applyChanges(imageChanges);
+        }
 
-                    lastFrameTime = currentTime;
-                }
-                else
-                {
-                    // Restart video playback when reaching the end
-                    video.set(cv::CAP_PROP_POS_FRAMES, 0);
-                }
+        profiler.beginGpu(stageImageUploads);
+        imageLibrary.processUploads(imageUploadBudgetMs);
+        profiler.endGpu(stageImageUploads);
+        profiler.end(stageImageUploads);
+
+        if (thumbnailsLoading && imageLibrary.pendingCount() == 0)
+        {
+            thumbnailsLoading = false;
+            startupTrace.end(thumbnailsPhase);
+        }
+
+        // Get video frame due at this time, if it changed
+        videoPlayer.setPaused(!isVideoPlaying);
+
+        if (const VideoFrame *videoFrame = videoPlayer.update())
+        {
+            const cv::Mat &frame = videoFrame->image;
+            profiler.addSample(stageVideoDecode, videoFrame->decodeMs);
+
+            // Update video texture with the BGR frame, storage is reused and the copy goes through a pixel buffer
+            profiler.begin(stageVideoUpload);
+            profiler.beginGpu(stageVideoUpload);
+            videoStream.update(frame.data, frame.cols, frame.rows, frame.step, StreamingTexture::Format::BGR);
+            profiler.endGpu(stageVideoUpload);
+            profiler.end(stageVideoUpload);
+            videoTexture = videoStream.id();
+            videoPositionMs = videoFrame->pts;
+
+            if (videoWidth == 0 || videoHeight == 0)
+            {
+                videoWidth = frame.cols;
+                videoHeight = frame.rows;
+            }
+        }
+
+        // Present the live cue and load the next one
+        profiler.begin(stageCues);
+        cueList.update(imageUploadBudgetMs); // Its own budget, the next cue does not wait behind the thumbnails
+        profiler.end(stageCues);
+
+        // Remote media calls are on screen once their cue switched or the image loaded
+        if (cueList.statistics().switches != cueSwitches || imageLibrary.selectedImage().textureID != selectedTexture)
+        {
+            cueSwitches = cueList.statistics().switches;
+            selectedTexture = imageLibrary.selectedImage().textureID;
+            rpc.release();
+        }
+
+        // Remote catalog follows the library, sizes are filled in as the images decode
+        if (imageLibrary.catalogVersion() != catalogVersion)
+        {
+            catalogVersion = imageLibrary.catalogVersion();
+
+            std::vector<CatalogImage> catalogImages;
+            catalogImages.reserve(imageLibrary.size());
+
+            for (const ImageEntry &entry : imageLibrary.entries())
+            {
+                catalogImages.push_back({entry.path, entry.sourceWidth, entry.sourceHeight, entry.revision});
             }
+
+            webServer.images().publish(std::move(catalogImages));
         }
 
         // Main window
-        glfwMakeContextCurrent(window);
+        profiler.begin(stageBuild);
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplGlfw_NewFrame();
         ImGui::NewFrame();
 
         // Draw center text
-        // TextAutoSizedAndCentered("DEUS ENVIOU\nSEU FILHO AMADO\nPRA PERDOAR\nPRA ME SALVAR", fontPlayerText, true);
+        // TextAutoSizedAndCentered("DEUS ENVIOU\nSEU FILHO AMADO\nPRA PERDOAR\nPRA ME SALVAR", fontMain, true);
 
         // Render tabs
         ImGui::PushFont(fontMain);
@@ -773,22 +664,13 @@ int main()
                         // strncpy(folderPathBuffer, selectedFolder.c_str(), sizeof(folderPathBuffer));
                         selectedProjectPath = selectedFolder;
 
-                        // Limpa a lista de texturas existentes
-                        textures.clear();
                         // Define o novo caminho para as imagens
                         pathToImages = selectedProjectPath + "/images";
 
-                        // Recarrega as texturas
-                        if (fs::is_directory(pathToImages))
-                        {
-                            for (const auto &entry : fs::directory_iterator(pathToImages))
-                            {
-                                if (entry.is_regular_file())
-                                {
-                                    textures.push_back(LoadTextureFromImage(entry.path().string().c_str()));
-                                }
-                            }
-                        }
+                        // Libera as texturas atuais e agenda a decodificação das novas
+                        imageWatcher.watch(pathToImages);
+                        imageLibrary.open(pathToImages);
+                        webServer.setMediaRoot(selectedProjectPath);
                     }
                 }
 
@@ -810,14 +692,17 @@ int main()
                 ImGui::SameLine();
                 if (ImGui::Button("Black Screen"))
                 {
-                    // Implement logic to set the screen to black
+                    projectorMode = ProjectorMode::Black;
                 }
                 ImGui::SameLine();
                 if (ImGui::Button("Default Screen"))
                 {
-                    // Implement logic to set the screen to default
+                    projectorMode = ProjectorMode::Default;
+                    projectorVisible = true;
                 }
 
+                ImGui::Checkbox("Show Frame Timings (F3)", &showProfiler);
+
                 ImGui::Dummy(ImVec2(0, 10));
                 ImGui::Separator();
                 ImGui::Dummy(ImVec2(0, 10));
@@ -842,8 +727,18 @@ int main()
                 ImGui::Text("REMOTE CONTROL SETTINGS");
                 ImGui::PopFont();
 
-                std::vector<std::string> ipAddresses = webServer.getAvailableIPAddresses();
-                static int selectedIPIndex = 0;
+                std::shared_ptr<const NetworkSnapshot> network = networkMonitor.snapshot();
+                const std::vector<std::string> &ipAddresses = network->addresses;
+
+                // A escolha segue o endereço, não a posição, quando as interfaces mudam
+                int selectedIPIndex = 0;
+                for (int i = 0; i < ipAddresses.size(); i++)
+                {
+                    if (ipAddresses[i] == selectedAddress)
+                    {
+                        selectedIPIndex = i;
+                    }
+                }
 
                 if (ImGui::BeginCombo("IP Address", ipAddresses[selectedIPIndex].c_str()))
                 {
@@ -853,6 +748,7 @@ int main()
                         if (ImGui::Selectable(ipAddresses[i].c_str(), isSelected))
                         {
                             selectedIPIndex = i;
+                            selectedAddress = ipAddresses[i];
                         }
 
                         // Define o item inicialmente selecionado para ser mostrado
@@ -874,8 +770,13 @@ int main()
                         webServer.stop();
                     }
 
-                    // Gera o QR Code apenas se a porta do servidor mudou
-                    std::string currentUrl = "http://" + ipAddresses[selectedIPIndex] + ":" + std::to_string(serverPort) + "/rcontrol/?api_url=http://" + ipAddresses[selectedIPIndex] + ":" + std::to_string(serverPort) + "/api";
+                    // Gera o QR Code apenas se a rede, o endereço ou a porta mudaram
+                    bool qrInputsChanged = qrCodeTexture == 0 || network->version != qrNetworkVersion || serverPort != qrPort || ipAddresses[selectedIPIndex] != qrAddress;
+                    std::string currentUrl = qrInputsChanged ? "http://" + ipAddresses[selectedIPIndex] + ":" + std::to_string(serverPort) + "/rcontrol/?api_url=http://" + ipAddresses[selectedIPIndex] + ":" + std::to_string(serverPort) + "/api" : lastUrl;
+                    qrNetworkVersion = network->version;
+                    qrPort = serverPort;
+                    qrAddress = ipAddresses[selectedIPIndex];
+
                     if (currentUrl != lastUrl)
                     {
                         // Se já tiver uma textura de QR Code, deleta a antiga
@@ -898,12 +799,19 @@ int main()
                         ImGui::Text("QR Code:");
                         ImGui::Image((void *)(intptr_t)qrCodeTexture, ImVec2(200, 200)); // Exibe o QR Code com tamanho 200x200
                     }
+
+                    // Remote call latency, from the HTTP request to the frame showing the change
+                    RpcStats rpcStats = rpc.statistics();
+                    ImGui::TextDisabled("%llu calls, queue p50 %.2f p99 %.2f ms, on screen p50 %.2f p99 %.2f max %.2f ms", static_cast<unsigned long long>(rpcStats.executed), rpcStats.queueP50, rpcStats.queueP99, rpcStats.presentP50, rpcStats.presentP99, rpcStats.presentMax);
+
+                    PreviewStats previewStats = webServer.preview().statistics();
+                    ImGui::TextDisabled("Preview: %zu viewers, %llu frames, encode %.2f ms", previewStats.clients, static_cast<unsigned long long>(previewStats.encoded), previewStats.lastEncodeMs);
                 }
                 else
                 {
                     if (ImGui::Button("Start Server"))
                     {
-                        webServer.start(ipAddresses[selectedIPIndex], serverPort);
+                        webServer.start(ipAddresses[selectedIPIndex], serverPort, serverSettings);
                     }
                 }
 
@@ -912,7 +820,7 @@ int main()
 
             if (ImGui::BeginTabItem("Images"))
             {
-                if (textures.empty())
+                if (imageLibrary.empty())
                 {
                     ImGui::SetCursorPosX((ImGui::GetContentRegionAvail().x - ImGui::CalcTextSize("No project selected").x) * 0.5f);
                     ImGui::SetCursorPosY((ImGui::GetContentRegionAvail().y - ImGui::CalcTextSize("No project selected").y) * 0.5f);
@@ -920,66 +828,112 @@ int main()
                 }
                 else
                 {
-                    const ImVec2 cellSize(120.0f, 80.0f); // Fixed size for cells
-                    float windowWidth = ImGui::GetContentRegionAvail().x;
                     const float paddingBetweenImages = 8.0f; // Define padding between images
 
-                    // Calculate the total width used by each image, including padding
-                    float totalCellWidth = cellSize.x + paddingBetweenImages;
+                    // Texture residency for monitoring
+                    const TextureManager::Stats &textureStats = textureManager.statistics();
+                    ImGui::TextDisabled("%zu images, %zu textures (%.1f / %.1f MB), %llu evictions", imageLibrary.size(), textureStats.residentCount, textureStats.residentBytes / (1024.0 * 1024.0), textureStats.budgetBytes / (1024.0 * 1024.0), static_cast<unsigned long long>(textureStats.evictionCount));
 
-                    // Adjust calculation for imagesPerRow to include padding, subtracting 1 padding since there's no padding after the last image in a row
-                    int imagesPerRow = static_cast<int>((windowWidth + paddingBetweenImages) / totalCellWidth);
+                    ImageGridResult grid = ImageGrid(imageLibrary.entries(), cellSize, paddingBetweenImages);
 
-                    for (int i = 0; i < textures.size(); ++i)
+                    // Visible cells are decoded first
+                    for (int i = grid.firstVisible; i >= 0 && i <= grid.lastVisible; ++i)
                     {
-                        // If it's not the first image and reached the end of the row, start a new row
-                        if (i > 0 && i % imagesPerRow == 0)
-                        {
-                            ImGui::NewLine();
-                        }
+                        imageLibrary.requestVisible(i);
+                    }
+
+                    if (grid.activated >= 0)
+                    {
+                        // Assume que esta é a condição para selecionar uma imagem após o clique duplo
+                        showImage(grid.activated);
+                    }
+                }
 
-                        // Calculate the aspect ratio and size of the image to fit in the cell
-                        float aspectRatio = static_cast<float>(textures[i].width) / textures[i].height;
-                        ImVec2 imageSize = (aspectRatio > 1.0f) ? ImVec2(cellSize.x, cellSize.x / aspectRatio) : ImVec2(cellSize.y * aspectRatio, cellSize.y);
+                ImGui::EndTabItem();
+            }
 
-                        // Calculate padding to center the image in the cell
-                        float paddingX = (cellSize.x - imageSize.x) / 2.0f;
-                        float paddingY = (cellSize.y - imageSize.y) / 2.0f;
+            if (ImGui::BeginTabItem("Cues"))
+            {
+                if (ImGui::Button("Add Images"))
+                {
+                    auto files = pfd::open_file("Add Image Cues", pathToImages.empty() ? "." : pathToImages, {"Images", "*.png *.jpg *.jpeg *.bmp"}, pfd::opt::multiselect).result();
 
-                        // Calculate position for the cell's top-left corner
-                        ImVec2 cellPos = ImGui::GetCursorScreenPos();
+                    for (const auto &file : files)
+                    {
+                        cueList.add(CueType::Image, file);
+                    }
+                }
+                ImGui::SameLine();
+                if (ImGui::Button("Add Videos"))
+                {
+                    auto files = pfd::open_file("Add Video Cues", ".", {"Videos", "*.mp4 *.mov *.mkv *.avi"}, pfd::opt::multiselect).result();
 
-                        // Adjust cursor position for padding and center the image
-                        ImGui::SetCursorPosX(ImGui::GetCursorPosX() + paddingX);
-                        ImGui::SetCursorPosY(ImGui::GetCursorPosY() + paddingY);
+                    for (const auto &file : files)
+                    {
+                        cueList.add(CueType::Video, file);
+                    }
+                }
+                ImGui::SameLine();
+                if (ImGui::Button("Go (Space)"))
+                {
+                    cueList.go();
+                }
+                ImGui::SameLine();
+                if (ImGui::Button("Stop"))
+                {
+                    cueList.stop();
+                }
+                ImGui::SameLine();
+                if (ImGui::Button("Clear"))
+                {
+                    cueList.clear();
+                }
 
-                        // Draw the image
-                        ImGui::Image((void *)(intptr_t)textures[i].textureID, imageSize);
+                // Switch latency, from the go command to the cue on the output
+                const CueStats &cueStats = cueList.statistics();
+                ImGui::TextDisabled("%llu switches (%llu pre-rolled), last %.2f ms in %d frame(s), max %.2f ms", static_cast<unsigned long long>(cueStats.switches), static_cast<unsigned long long>(cueStats.prerolledSwitches), cueStats.lastSwitchMs, cueStats.lastSwitchFrames, cueStats.maxSwitchMs);
 
-                        if (ImGui::IsItemHovered() && ImGui::IsMouseDoubleClicked(0))
-                        {
-                            // Assume que esta é a condição para selecionar uma imagem após o clique duplo
-                            isVideoPlaying = false;                       // Para a reprodução do vídeo
-                            videoTexture = 0;                             // Reseta a textura do vídeo se necessário
-                            selectedImageTexture = textures[i].textureID; // Atualiza a textura selecionada
-                            selectedImageWidth = textures[i].width;       // Atualiza a largura da imagem selecionada
-                            selectedImageHeight = textures[i].height;     // Atualiza a altura da imagem selecionada
-                        }
+                const std::vector<Cue> &cues = cueList.cues();
+                int removeCue = -1;
+
+                for (int i = 0; i < static_cast<int>(cues.size()); ++i)
+                {
+                    const char *marker = "";
+                    if (i == cueList.liveIndex())
+                    {
+                        marker = "LIVE";
+                    }
+                    else if (i == cueList.nextIndex())
+                    {
+                        marker = cueList.nextReady() ? "NEXT" : "LOADING";
+                    }
 
-                        // Draw rectangle around the cell
-                        ImDrawList *drawList = ImGui::GetWindowDrawList();
-                        drawList->AddRect(cellPos, ImVec2(cellPos.x + cellSize.x, cellPos.y + cellSize.y), IM_COL32(255, 255, 255, 255));
+                    std::string label = std::to_string(i + 1) + ". [" + (cues[i].type == CueType::Image ? "Image" : "Video") + "] " + fs::path(cues[i].path).filename().string();
 
-                        // If it's not the end of the row, continue on the same line
-                        if ((i + 1) % imagesPerRow != 0 && (i + 1) < textures.size())
-                        {
-                            ImGui::SameLine();
+                    ImGui::PushID(i);
+                    ImGui::TextUnformatted(marker);
+                    ImGui::SameLine(80.0f);
+
+                    // Double click puts the cue on the output
+                    if (ImGui::Selectable(label.c_str(), i == cueList.liveIndex(), ImGuiSelectableFlags_AllowDoubleClick) && ImGui::IsMouseDoubleClicked(0))
+                    {
+                        cueList.go(i);
+                    }
 
-                            // Reset cursor position to the left edge and prepare for the next image or row
-                            ImGui::SetCursorPosX(ImGui::GetCursorPosX() + paddingX);
-                            ImGui::SetCursorPosY(ImGui::GetCursorPosY() - paddingY);
+                    if (ImGui::BeginPopupContextItem())
+                    {
+                        if (ImGui::MenuItem("Remove"))
+                        {
+                            removeCue = i;
                         }
+                        ImGui::EndPopup();
                     }
+                    ImGui::PopID();
+                }
+
+                if (removeCue >= 0)
+                {
+                    cueList.remove(removeCue);
                 }
 
                 ImGui::EndTabItem();
@@ -990,6 +944,22 @@ int main()
 
         ImGui::End();
 
+        // Space triggers the next cue unless a text field has focus
+        if (ImGui::IsKeyPressed(ImGuiKey_Space, false) && !io.WantTextInput)
+        {
+            cueList.go();
+        }
+
+        if (ImGui::IsKeyPressed(ImGuiKey_F3, false))
+        {
+            showProfiler = !showProfiler;
+        }
+
+        if (showProfiler)
+        {
+            FrameProfilerOverlay(profiler, &showProfiler);
+        }
+
         // Render image grid
 
         // Render video
@@ -1045,78 +1015,80 @@ int main()
         ImGui::SetWindowPos(videoWinPos);
         ImGui::SetWindowSize(videoWinSize);
 
-        TextAutoSizedAndCentered("DEUS ENVIOU\nSEU FILHO AMADO\nPRA PERDOAR\nPRA ME SALVAR", fontPlayerText, false);
-
-        if (videoTexture != 0)
-        {
-            // Get total window dimensions from ImGui
-            ImVec2 windowSize = ImGui::GetContentRegionAvail();
-
-            // Calculate video aspect ratio
-            float videoAspectRatio = (float)videoWidth / (float)videoHeight;
-            float windowAspectRatio = windowSize.x / windowSize.y;
-
-            // Calculate image size based on video and window aspect ratio
-            ImVec2 imageSize;
-            ImVec2 imagePos;
+        ProjectorContent projector;
+        PlayerState playerState;
+        playerState.mode = projectorModeName(projectorMode);
+        playerState.visible = projectorVisible;
+        playerState.text = projectorText;
 
-            if (videoAspectRatio > windowAspectRatio)
-            {
-                // Imagem é mais larga que a área disponível
-                imageSize.x = windowSize.y * videoAspectRatio;    // Ajusta a largura baseado na altura da janela
-                imageSize.y = windowSize.y;                       // Altura preenche a janela
-                imagePos.x = (windowSize.x - imageSize.x) * 0.5f; // Centraliza horizontalmente
-                imagePos.y = 0;                                   // Começa do topo da janela
-            }
-            else
-            {
-                // Imagem é mais alta que a área disponível
-                imageSize.x = windowSize.x;                       // Largura preenche a janela
-                imageSize.y = windowSize.x / videoAspectRatio;    // Ajusta a altura baseado na largura da janela
-                imagePos.x = 0;                                   // Começa da lateral esquerda da janela
-                imagePos.y = (windowSize.y - imageSize.y) * 0.5f; // Centraliza verticalmente
-            }
+        bool showText = projectorVisible && (projectorMode == ProjectorMode::Default || projectorMode == ProjectorMode::Text);
+        bool showMedia = projectorVisible && (projectorMode == ProjectorMode::Default || projectorMode == ProjectorMode::Media);
 
-            // Apply calculated position
-            ImGui::SetCursorPos(imagePos);
+        if (showText)
+        {
+            projector.text = projectorText.c_str();
+            projector.font = fontPlayerTextReady ? &fontPlayerText : nullptr;
+            projector.slide = &projectorSlide;
+        }
 
-            // Render video image with adjusted size and position
-            ImGui::Image((void *)(intptr_t)videoTexture, imageSize);
+        if (cueList.active())
+        {
+            // Cue output, the previous cue stays up until the next one has a frame
+            const CueOutput &cueOutput = cueList.output();
+            projector.textureID = cueOutput.textureID;
+            projector.width = cueOutput.width;
+            projector.height = cueOutput.height;
+
+            const Cue &cue = cueList.cues()[cueList.liveIndex()];
+            playerState.media = cue.path;
+            playerState.mediaType = cue.type == CueType::Video ? "video" : "image";
+            playerState.playing = cue.type == CueType::Video;
+            playerState.positionMs = cueOutput.positionMs;
+        }
+        else if (videoTexture != 0)
+        {
+            projector.textureID = videoTexture;
+            projector.width = videoWidth;
+            projector.height = videoHeight;
+
+            playerState.media = videoPath;
+            playerState.mediaType = "video";
+            playerState.playing = isVideoPlaying;
+            playerState.positionMs = videoPositionMs;
         }
-        else if (selectedImageTexture != 0)
+        else if (imageLibrary.selectedImage().textureID != 0)
         {
-            ImVec2 windowSize = ImGui::GetContentRegionAvail(); // Tamanho disponível na janela
+            const ImageTexture &selectedImage = imageLibrary.selectedImage();
+            projector.textureID = selectedImage.textureID;
+            projector.width = selectedImage.width;
+            projector.height = selectedImage.height;
 
-            // Presumindo que você tem acesso às dimensões originais da imagem
-            float imageAspectRatio = static_cast<float>(selectedImageWidth) / selectedImageHeight;
-            float windowAspectRatio = windowSize.x / windowSize.y;
+            playerState.media = selectedImagePath;
+            playerState.mediaType = "image";
+        }
 
-            ImVec2 imageSize;
-            ImVec2 imagePos;
+        if (!showMedia)
+        {
+            projector.textureID = 0;
+            playerState.media.clear();
+            playerState.mediaType.clear();
+            playerState.playing = false;
+            playerState.positionMs = 0.0;
+        }
 
-            if (imageAspectRatio > windowAspectRatio)
-            {
-                // Imagem é mais larga que a área disponível
-                imageSize.x = windowSize.y * imageAspectRatio;    // Ajusta a largura baseado na altura da janela
-                imageSize.y = windowSize.y;                       // Altura preenche a janela
-                imagePos.x = (windowSize.x - imageSize.x) * 0.5f; // Centraliza horizontalmente
-                imagePos.y = 0;                                   // Começa do topo da janela
-            }
-            else
-            {
-                // Imagem é mais alta que a área disponível
-                imageSize.x = windowSize.x;                       // Largura preenche a janela
-                imageSize.y = windowSize.x / imageAspectRatio;    // Ajusta a altura baseado na largura da janela
-                imagePos.x = 0;                                   // Começa da lateral esquerda da janela
-                imagePos.y = (windowSize.y - imageSize.y) * 0.5f; // Centraliza verticalmente
-            }
+        // Remote controls get every change, the playback position at most every 250 ms
+        if (!playerState.same(publishedState, 250.0))
+        {
+            webServer.events().publish(playerState.toJson());
+            publishedState = playerState;
+        }
 
-            // Aplica a posição calculada
-            ImGui::SetCursorPos(imagePos);
+        ProjectorView(projector);
 
-            // Renderiza a imagem com o tamanho e posição ajustados
-            ImGui::Image((void *)(intptr_t)selectedImageTexture, imageSize);
-        }
+        // Valid until the next frame starts, the preview renders it again after this one
+        projectorDrawList = ImGui::GetWindowDrawList();
+        projectorPos = ImGui::GetWindowPos();
+        projectorSize = ImGui::GetWindowSize();
 
         ImGui::End();
 
@@ -1125,45 +1097,101 @@ int main()
 
         // Render ImGui
         ImGui::Render();
+        profiler.end(stageBuild);
+
+        profiler.begin(stageRender);
+        profiler.beginGpu(stageRender);
         int displayW, displayH;
         glfwGetFramebufferSize(window, &displayW, &displayH);
         glViewport(0, 0, displayW, displayH);
         glClearColor(0.45f, 0.55f, 0.60f, 1.00f);
         glClear(GL_COLOR_BUFFER_BIT);
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        projectorSlide.renderPending();
+        profiler.endGpu(stageRender);
+        profiler.end(stageRender);
+
+        // Readbacks finished in earlier frames go to the encoder, a new one is queued at the preview rate
+        profiler.begin(stagePreview);
+        profiler.beginGpu(stagePreview);
+        previewCapture.collect(webServer.preview());
+        if (webServer.preview().wanted())
+        {
+            previewCapture.capture(projectorDrawList, projectorPos, projectorSize, webServer.preview().settings().width);
+        }
+        profiler.endGpu(stagePreview);
+        profiler.end(stagePreview);
 
+        // Other viewports render in their own contexts, only CPU time is measured
+        profiler.begin(stagePlatform);
         if (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable)
         {
             ImGui::UpdatePlatformWindows();
             ImGui::RenderPlatformWindowsDefault();
         }
+        profiler.end(stagePlatform);
 
+        // Platform windows leave their own context current
+        profiler.begin(stageSwap);
+        glfwMakeContextCurrent(window);
         glfwSwapBuffers(window);
+        profiler.end(stageSwap);
+
+        // Remote calls executed this frame and the cue switched in it are now on screen
+        rpc.presented();
+        cueList.presented();
+
+        // Interactive once the projector font, the thumbnails and the video are in
+        startupTrace.markFirstFrame();
+        if (!startupTrace.interactive() && startupStage == StartupStage::Started && !fontPlayerTextLoad.valid() && !thumbnailsLoading && !videoOpening)
+        {
+            startupTrace.markInteractive();
+            std::cout << "Startup:" << std::endl;
+            startupTrace.print(std::cout);
+        }
 
         starting = false;
     }
 
     // Antes de fechar o servidor e terminar a aplicação
-    saveSettings(selectedProjectPath, serverPort);
+    saveSettings(selectedProjectPath, serverPort, textureBudgetMB, serverSettings, previewSettings);
 
     // stop server
     webServer.stop();
 
-    // Cleanup
-    if (videoTexture != 0)
-    {
-        glDeleteTextures(1, &videoTexture);
-    }
+    // Playback counters, used to verify pacing over long runs
+    VideoStats videoStats = videoPlayer.statistics();
+    std::cout << "Video: " << videoStats.presented << " frames presented, " << videoStats.dropped << " dropped, " << videoStats.duplicated << " duplicated, drift " << videoStats.driftMs << " ms." << std::endl;
+    std::cout << "Video: " << videoStats.loops << " loops, last gap " << videoStats.loopGapMs << " ms, max gap " << videoStats.maxLoopGapMs << " ms, max loop decode " << videoStats.maxLoopDecodeMs << " ms." << std::endl;
+    videoPlayer.close();
 
-    for (auto &texture : textures)
-    {
-        glDeleteTextures(1, &texture.textureID);
-    }
+    const CueStats &cueStats = cueList.statistics();
+    RpcStats rpcStats = rpc.statistics();
+    std::cout << "Remote: " << rpcStats.executed << " calls, on screen p50 " << rpcStats.presentP50 << " ms, p99 " << rpcStats.presentP99 << " ms, max " << rpcStats.presentMax << " ms." << std::endl;
 
-    if (selectedImageTexture != 0)
-    {
-        glDeleteTextures(1, &selectedImageTexture);
-    }
+    PreviewStats previewStats = webServer.preview().statistics();
+    std::cout << "Preview: " << previewStats.encoded << " frames encoded, " << previewStats.skipped << " skipped, max encode " << previewStats.maxEncodeMs << " ms." << std::endl;
+
+    std::cout << "Cues: " << cueStats.switches << " switches, last " << cueStats.lastSwitchMs << " ms, max " << cueStats.maxSwitchMs << " ms." << std::endl;
+
+    FolderWatchStats watchStats = imageWatcher.statistics();
+    std::cout << "Images folder: " << watchStats.events << " events in " << watchStats.batches << " batches, " << watchStats.changes << " changes, " << watchStats.rescans << " rescans, " << imageLibrary.thumbnailRequests() << " thumbnail jobs." << std::endl;
+
+    std::cout << "Startup: first frame at " << startupTrace.firstFrameMs() << " ms, interactive at " << startupTrace.interactiveMs() << " ms." << std::endl;
+
+    FrameProfiler::Percentiles frameTimes = profiler.framePercentiles();
+    std::cout << "Frames: p50 " << frameTimes.p50 << " ms, p95 " << frameTimes.p95 << " ms, p99 " << frameTimes.p99 << " ms, " << profiler.missedFrames() << " of " << profiler.frameCount() << " missed." << std::endl;
+
+    // Cleanup
+    glfwMakeContextCurrent(window);
+    profiler.releaseQueries();
+    previewCapture.release();
+    projectorSlide.release();
+    fontPlayerText.release();
+    videoStream.release();
+    cueList.clear();
+    imageLibrary.clear();
+    textureManager.releaseAll();
 
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
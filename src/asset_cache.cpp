@@ -0,0 +1,224 @@
+#include "asset_cache.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+
+#include <Poco/DeflatingStream.h>
+
+#include "thumbnail_cache.h"
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    bool isCompressible(const std::string &contentType)
+    {
+        return contentType.compare(0, 5, "text/") == 0 || contentType == "application/javascript" || contentType == "application/json" || contentType == "image/svg+xml";
+    }
+
+    std::string gzip(const std::string &data)
+    {
+        std::ostringstream compressed;
+        Poco::DeflatingOutputStream deflater(compressed, Poco::DeflatingStreamBuf::STREAM_GZIP, 9);
+        deflater.write(data.data(), static_cast<std::streamsize>(data.size()));
+        deflater.close();
+        return compressed.str();
+    }
+
+    std::string quotedHash(const std::string &data, const char *suffix)
+    {
+        char text[40];
+        std::snprintf(text, sizeof(text), "\"%016llx%s\"", static_cast<unsigned long long>(ThumbnailCache::hashBytes(reinterpret_cast<const unsigned char *>(data.data()), data.size())), suffix);
+        return text;
+    }
+
+    bool statFile(const std::string &path, int64_t &modified, uint64_t &size)
+    {
+        std::error_code error;
+        if (!fs::is_regular_file(path, error))
+        {
+            return false;
+        }
+
+        fs::file_time_type time = fs::last_write_time(path, error);
+        uintmax_t bytes = fs::file_size(path, error);
+        if (error)
+        {
+            return false;
+        }
+
+        modified = static_cast<int64_t>(time.time_since_epoch().count());
+        size = static_cast<uint64_t>(bytes);
+        return true;
+    }
+}
+
+AssetCache::AssetCache(const std::string &root, std::chrono::milliseconds checkInterval)
+    : rootPath(root), checkInterval(checkInterval)
+{
+}
+
+void AssetCache::preload()
+{
+    std::error_code error;
+
+    for (fs::recursive_directory_iterator it(rootPath, error), end; !error && it != end; it.increment(error))
+    {
+        if (it->is_regular_file(error))
+        {
+            find(fs::relative(it->path(), rootPath, error).generic_string());
+        }
+    }
+}
+
+std::shared_ptr<const Asset> AssetCache::find(const std::string &relativePath)
+{
+    Clock::time_point now = Clock::now();
+    std::shared_ptr<const Asset> cached;
+
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        auto it = entries.find(relativePath);
+
+        if (it != entries.end())
+        {
+            if (now - it->second.checked < checkInterval)
+            {
+                return it->second.asset;
+            }
+
+            cached = it->second.asset;
+        }
+    }
+
+    // Due for a check: reuse the loaded asset while the file is unchanged
+    int64_t modified;
+    uint64_t size;
+    std::string path = rootPath + "/" + relativePath;
+
+    if (!statFile(path, modified, size))
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        entries.erase(relativePath);
+        return nullptr;
+    }
+
+    if (cached && cached->modified == modified && cached->fileSize == size)
+    {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        entries[relativePath].checked = now;
+        return cached;
+    }
+
+    std::shared_ptr<const Asset> asset = load(relativePath);
+
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    if (asset)
+    {
+        entries[relativePath] = {asset, now};
+    }
+    else
+    {
+        entries.erase(relativePath);
+    }
+
+    return asset;
+}
+
+std::shared_ptr<const Asset> AssetCache::load(const std::string &relativePath)
+{
+    auto asset = std::make_shared<Asset>();
+    asset->path = rootPath + "/" + relativePath;
+
+    if (!statFile(asset->path, asset->modified, asset->fileSize) || asset->fileSize > maxAssetSize)
+    {
+        return nullptr;
+    }
+
+    std::ifstream file(asset->path, std::ios::binary);
+    asset->body.resize(static_cast<size_t>(asset->fileSize));
+
+    if (!file.read(&asset->body[0], static_cast<std::streamsize>(asset->body.size())))
+    {
+        return nullptr;
+    }
+
+    asset->contentType = contentTypeFor(relativePath);
+    asset->immutable = isHashedName(relativePath);
+    asset->etag = quotedHash(asset->body, "");
+
+    // Only worth it when it saves at least a tenth
+    if (isCompressible(asset->contentType) && asset->body.size() > 256)
+    {
+        std::string compressed = gzip(asset->body);
+        if (compressed.size() < asset->body.size() - asset->body.size() / 10)
+        {
+            asset->gzipBody = std::move(compressed);
+            asset->gzipEtag = quotedHash(asset->body, "-gz");
+        }
+    }
+
+    loadCount++;
+    return asset;
+}
+
+std::string AssetCache::contentTypeFor(const std::string &path)
+{
+    std::string extension = fs::path(path).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c)
+                   { return static_cast<char>(std::tolower(c)); });
+
+    static const std::unordered_map<std::string, std::string> types = {
+        {".html", "text/html"},
+        {".htm", "text/html"},
+        {".js", "application/javascript"},
+        {".css", "text/css"},
+        {".json", "application/json"},
+        {".map", "application/json"},
+        {".png", "image/png"},
+        {".jpg", "image/jpeg"},
+        {".jpeg", "image/jpeg"},
+        {".gif", "image/gif"},
+        {".svg", "image/svg+xml"},
+        {".ico", "image/x-icon"},
+        {".woff", "font/woff"},
+        {".woff2", "font/woff2"},
+        {".ttf", "font/ttf"},
+        {".mp4", "video/mp4"},
+    };
+
+    auto it = types.find(extension);
+    return it != types.end() ? it->second : "text/plain";
+}
+
+bool AssetCache::isHashedName(const std::string &path)
+{
+    // name.<8 or more hex digits>.ext, as written by the bundler
+    std::string name = fs::path(path).filename().string();
+    size_t start = name.find('.');
+
+    while (start != std::string::npos)
+    {
+        size_t end = name.find('.', start + 1);
+        if (end == std::string::npos)
+        {
+            return false; // The extension
+        }
+
+        std::string part = name.substr(start + 1, end - start - 1);
+        if (part.size() >= 8 && std::all_of(part.begin(), part.end(), [](unsigned char c)
+                                            { return std::isxdigit(c) != 0; }))
+        {
+            return true;
+        }
+
+        start = end;
+    }
+
+    return false;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+// A file of the web folder ready to be sent: the body is read once, text
+// types also keep a gzip variant when it is smaller
+struct Asset
+{
+    std::string path;
+    std::string contentType;
+    std::string body;
+    std::string gzipBody; // Empty when the type is not compressible or gzip does not help
+    std::string etag;     // Quoted, from the content hash
+    std::string gzipEtag;
+    bool immutable = false; // Hashed file name, e.g. app.a8c14a02.js
+
+    int64_t modified = 0;
+    uint64_t fileSize = 0;
+};
+
+// In-memory copy of the web folder shared by the request handlers. Assets are
+// loaded on first use (or by preload) and reloaded when the file changes, the
+// file is checked at most once per checkInterval.
+class AssetCache
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Files above maxAssetSize are not kept in memory
+    static constexpr uint64_t maxAssetSize = 16 * 1024 * 1024;
+
+    explicit AssetCache(const std::string &root, std::chrono::milliseconds checkInterval = std::chrono::milliseconds(1000));
+
+    AssetCache(const AssetCache &) = delete;
+    AssetCache &operator=(const AssetCache &) = delete;
+
+    // Loads every file below the root
+    void preload();
+
+    // Asset for a path relative to the root (no query, no ".."), nullptr when
+    // the file does not exist or is too large to cache
+    std::shared_ptr<const Asset> find(const std::string &relativePath);
+
+    const std::string &root() const { return rootPath; }
+
+    static std::string contentTypeFor(const std::string &path);
+    static bool isHashedName(const std::string &path);
+
+    uint64_t loads() const { return loadCount.load(); }
+
+private:
+    struct Entry
+    {
+        std::shared_ptr<const Asset> asset;
+        Clock::time_point checked;
+    };
+
+    std::shared_ptr<const Asset> load(const std::string &relativePath);
+
+    std::string rootPath;
+    std::chrono::milliseconds checkInterval;
+
+    std::shared_mutex mutex;
+    std::unordered_map<std::string, Entry> entries;
+
+    std::atomic<uint64_t> loadCount{0};
+};
@@ -0,0 +1,334 @@
+#include "cue_list.h"
+
+#include <algorithm>
+
+namespace
+{
+    double millisecondsBetween(CueList::Clock::time_point start, CueList::Clock::time_point end)
+    {
+        return std::chrono::duration<double, std::milli>(end - start).count();
+    }
+}
+
+CueList::CueList(TextureManager &textures)
+    : textures(textures)
+{
+}
+
+CueList::~CueList()
+{
+    unload(slots[0]);
+    unload(slots[1]);
+}
+
+void CueList::add(CueType type, const std::string &path)
+{
+    items.push_back({type, path});
+
+    if (!switching && !pendingUnload)
+    {
+        preloadNext();
+    }
+}
+
+void CueList::remove(size_t index)
+{
+    if (index >= items.size())
+    {
+        return;
+    }
+
+    if (static_cast<int>(index) == live)
+    {
+        stop();
+    }
+
+    items.erase(items.begin() + index);
+
+    if (live > static_cast<int>(index))
+    {
+        live--;
+    }
+
+    for (Slot &slot : slots)
+    {
+        if (slot.cue == static_cast<int>(index))
+        {
+            unload(slot);
+        }
+        else if (slot.cue > static_cast<int>(index))
+        {
+            slot.cue--;
+        }
+    }
+
+    // The cue being switched to is gone
+    if (switching && slots[1 - liveSlot].cue < 0)
+    {
+        switching = false;
+        live = slots[liveSlot].cue;
+    }
+
+    if (!switching && !pendingUnload)
+    {
+        preloadNext();
+    }
+}
+
+void CueList::clear()
+{
+    stop();
+    items.clear();
+    unload(slots[0]);
+    unload(slots[1]);
+}
+
+void CueList::go()
+{
+    int next = nextIndex();
+    if (next >= 0)
+    {
+        go(static_cast<size_t>(next));
+    }
+}
+
+void CueList::go(size_t index)
+{
+    if (index >= items.size())
+    {
+        return;
+    }
+
+    Slot &next = slots[1 - liveSlot];
+
+    // Usually the cue is already loaded, otherwise the switch waits for it
+    if (next.cue != static_cast<int>(index))
+    {
+        load(next, static_cast<int>(index));
+    }
+
+    switchPrerolled = next.ready;
+    switching = true;
+    switchFrames = 0;
+    goTime = Clock::now();
+    live = static_cast<int>(index);
+}
+
+void CueList::stop()
+{
+    switching = false;
+    pendingUnload = false;
+    switchPresenting = false;
+
+    unload(slots[0]);
+    unload(slots[1]);
+
+    liveSlot = 0;
+    live = -1;
+    currentOutput = CueOutput();
+
+    preloadNext();
+}
+
+int CueList::nextIndex() const
+{
+    int next = live + 1;
+    return next < static_cast<int>(items.size()) ? next : -1;
+}
+
+bool CueList::nextReady() const
+{
+    const Slot &next = slots[1 - liveSlot];
+    return next.cue >= 0 && next.cue == nextIndex() && next.ready;
+}
+
+void CueList::update(double uploadBudgetMs, Clock::time_point now)
+{
+    receiveImages();
+    uploadImages(uploadBudgetMs, Clock::now());
+
+    Slot &other = slots[1 - liveSlot];
+
+    // A video cue is ready once its first frames are buffered
+    if (other.cue >= 0 && items[other.cue].type == CueType::Video)
+    {
+        other.ready = other.player.failed() || other.player.frameReady();
+    }
+
+    bool switched = false;
+
+    if (switching)
+    {
+        switchFrames++;
+
+        if (other.ready)
+        {
+            slots[liveSlot].player.setPaused(true);
+            liveSlot = 1 - liveSlot;
+
+            Slot &current = slots[liveSlot];
+            current.player.setPaused(false);
+            currentOutput = current.output;
+
+            switching = false;
+            switched = true;
+        }
+    }
+    else if (pendingUnload)
+    {
+        // A frame after the switch, so the switch itself never waits for a decoder to stop
+        unload(other);
+        pendingUnload = false;
+        preloadNext();
+    }
+
+    Slot &current = slots[liveSlot];
+
+    if (current.player.isOpen())
+    {
+        if (const VideoFrame *frame = current.player.update(now))
+        {
+            const cv::Mat &image = frame->image;
+            current.videoTexture.update(image.data, image.cols, image.rows, image.step, StreamingTexture::Format::BGR);
+            current.output = {current.videoTexture.id(), image.cols, image.rows, frame->pts};
+            currentOutput = current.output;
+        }
+    }
+
+    if (switched)
+    {
+        stats.switches++;
+        stats.prerolledSwitches += switchPrerolled ? 1 : 0;
+        stats.lastSwitchFrames = switchFrames;
+
+        // Timed by presented(), a later go() must not move the start
+        switchPresenting = true;
+        switchGoTime = goTime;
+
+        pendingUnload = true;
+    }
+}
+
+void CueList::presented(Clock::time_point now)
+{
+    if (!switchPresenting)
+    {
+        return;
+    }
+
+    double switchMs = millisecondsBetween(switchGoTime, now);
+
+    stats.lastSwitchMs = switchMs;
+    stats.maxSwitchMs = std::max(stats.maxSwitchMs, switchMs);
+
+    switchPresenting = false;
+}
+
+void CueList::load(Slot &slot, int cue)
+{
+    unload(slot);
+    slot.cue = cue;
+
+    const Cue &item = items[cue];
+
+    if (item.type == CueType::Image)
+    {
+        slot.request = nextRequest++;
+        imagePool.submit(slot.request, item.path);
+    }
+    else
+    {
+        // Paused so the buffered frames wait for go()
+        slot.player.openAsync(item.path);
+        slot.player.setPaused(true);
+    }
+}
+
+void CueList::unload(Slot &slot)
+{
+    slot.player.close();
+    slot.videoTexture.release();
+
+    if (slot.imageKey != 0)
+    {
+        textures.release(slot.imageKey);
+        slot.imageKey = 0;
+    }
+
+    slot.cue = -1;
+    slot.request = -1;
+    slot.image = DecodedImage();
+    slot.uploadedRows = 0;
+    slot.output = CueOutput();
+    slot.ready = false;
+}
+
+void CueList::receiveImages()
+{
+    DecodedImage image;
+
+    while (imagePool.popResult(image))
+    {
+        for (Slot &slot : slots)
+        {
+            if (slot.request != image.id)
+            {
+                continue;
+            }
+
+            slot.request = -1;
+
+            // A file that fails to decode still switches, to an empty output
+            if (image.failed())
+            {
+                slot.ready = true;
+                break;
+            }
+
+            // Storage now, the rows follow in strips from uploadImages()
+            slot.imageKey = textures.create(image.width, image.height, false);
+            slot.image = std::move(image);
+            slot.uploadedRows = 0;
+            break;
+        }
+    }
+}
+
+void CueList::uploadImages(double budgetMs, Clock::time_point start)
+{
+    // The cue being switched to, or the next one, is the only one normally uploading
+    for (Slot *slot : {&slots[1 - liveSlot], &slots[liveSlot]})
+    {
+        if (slot->image.failed())
+        {
+            continue;
+        }
+
+        if (millisecondsBetween(start, Clock::now()) >= budgetMs)
+        {
+            break;
+        }
+
+        if (uploader.upload(textures.texture(slot->imageKey), slot->image, slot->uploadedRows, budgetMs, start))
+        {
+            slot->output = {textures.texture(slot->imageKey), slot->image.width, slot->image.height};
+            slot->image = DecodedImage();
+            slot->ready = true;
+        }
+    }
+}
+
+void CueList::preloadNext()
+{
+    int next = nextIndex();
+    Slot &other = slots[1 - liveSlot];
+
+    if (next < 0)
+    {
+        unload(other);
+    }
+    else if (other.cue != next)
+    {
+        load(other, next);
+    }
+}
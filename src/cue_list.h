@@ -0,0 +1,133 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "opengl.h"
+
+#include "image_decode_pool.h"
+#include "row_uploader.h"
+#include "streaming_texture.h"
+#include "texture_manager.h"
+#include "video_player.h"
+
+enum class CueType
+{
+    Image,
+    Video
+};
+
+struct Cue
+{
+    CueType type;
+    std::string path;
+};
+
+struct CueOutput
+{
+    GLuint textureID = 0;
+    int width = 0;
+    int height = 0;
+    double positionMs = 0.0; // Pts of the video frame, keeps increasing across loops
+};
+
+struct CueStats
+{
+    uint64_t switches = 0;
+    uint64_t prerolledSwitches = 0; // Switches where the cue was already loaded when go() was called
+    double lastSwitchMs = 0.0;      // From go() to the first presented frame showing the cue
+    double maxSwitchMs = 0.0;
+    int lastSwitchFrames = 0;       // Updates between go() and the switch, 1 when it happened in the same frame
+};
+
+// Ordered images and videos for the projector. The cue after the live one is
+// loaded ahead of time, images decoded and uploaded in row strips over a few
+// frames, videos opened with their first frames buffered, so go() switches the
+// output on the next update.
+class CueList
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit CueList(TextureManager &textures);
+    ~CueList();
+
+    CueList(const CueList &) = delete;
+    CueList &operator=(const CueList &) = delete;
+
+    void add(CueType type, const std::string &path);
+    void remove(size_t index);
+    void clear();
+
+    // Puts the next cue, or the given one, on the output
+    void go();
+    void go(size_t index);
+
+    // Takes the output down, the next go() starts from the first cue again
+    void stop();
+
+    // Render thread, once per frame: presents video frames and loads the next
+    // cue, uploading image rows for at most uploadBudgetMs
+    void update(double uploadBudgetMs, Clock::time_point now = Clock::now());
+
+    // Render thread, after the buffers are swapped: a switch is timed until
+    // the first frame showing the new cue is on screen
+    void presented(Clock::time_point now = Clock::now());
+
+    const std::vector<Cue> &cues() const { return items; }
+    int liveIndex() const { return live; }
+    int nextIndex() const;
+    bool nextReady() const;
+    bool active() const { return live >= 0; }
+
+    // Last frame of the live cue, stays up until the next cue has one
+    const CueOutput &output() const { return currentOutput; }
+    const CueStats &statistics() const { return stats; }
+
+private:
+    struct Slot
+    {
+        int cue = -1;
+        int request = -1; // Decode job of an image cue
+        VideoPlayer player;
+        StreamingTexture videoTexture;
+        TextureKey imageKey = 0;
+        DecodedImage image; // Decoded pixels until all rows are uploaded
+        int uploadedRows = 0;
+        CueOutput output;
+        bool ready = false;
+    };
+
+    void load(Slot &slot, int cue);
+    void unload(Slot &slot);
+    void receiveImages();
+    void uploadImages(double budgetMs, Clock::time_point start);
+    void preloadNext();
+
+    TextureManager &textures;
+    ImageDecodePool imagePool{ImageDecodePool::decodeFile, 1};
+    RowUploader uploader;
+
+    std::vector<Cue> items;
+    Slot slots[2];
+    int liveSlot = 0;
+    int live = -1;
+    int nextRequest = 0;
+
+    CueOutput currentOutput;
+
+    // Switch in progress
+    bool switching = false;
+    Clock::time_point goTime;
+    int switchFrames = 0;
+    bool switchPrerolled = false;
+    bool pendingUnload = false; // Previous live cue, released on the update after the switch
+
+    // Switch done, waiting for its frame to be presented
+    bool switchPresenting = false;
+    Clock::time_point switchGoTime;
+
+    CueStats stats;
+};
@@ -0,0 +1,264 @@
+#include "file_streamer.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <sys/sendfile.h>
+#elif defined(__APPLE__)
+#include <sys/socket.h>
+#include <sys/uio.h>
+#endif
+
+#include <Poco/Net/HTTPServerRequestImpl.h>
+#include <Poco/Net/StreamSocket.h>
+
+using namespace Poco::Net;
+
+namespace
+{
+    // Closes the descriptor when the request ends
+    class FileDescriptor
+    {
+    public:
+        explicit FileDescriptor(int fd) : fd(fd) {}
+        ~FileDescriptor()
+        {
+            if (fd >= 0)
+            {
+                ::close(fd);
+            }
+        }
+
+        FileDescriptor(const FileDescriptor &) = delete;
+        FileDescriptor &operator=(const FileDescriptor &) = delete;
+
+        int get() const { return fd; }
+
+    private:
+        int fd;
+    };
+
+    bool parseNumber(const std::string &text, uint64_t &value)
+    {
+        if (text.empty() || text.find_first_not_of("0123456789") != std::string::npos || text.size() > 19)
+        {
+            return false;
+        }
+
+        value = std::strtoull(text.c_str(), nullptr, 10);
+        return true;
+    }
+
+    // Copies count bytes from the file at offset to the socket, false when the client went away
+    bool copyToSocket(int fileFd, StreamSocket &socket, uint64_t offset, uint64_t count)
+    {
+#if defined(__linux__)
+        int socketFd = socket.impl()->sockfd();
+        off_t position = static_cast<off_t>(offset);
+
+        while (count > 0)
+        {
+            size_t chunk = static_cast<size_t>(std::min<uint64_t>(count, 1u << 30));
+            ssize_t sent = ::sendfile(socketFd, fileFd, &position, chunk);
+
+            if (sent < 0 && errno == EINTR)
+            {
+                continue;
+            }
+
+            // EAGAIN is the send timeout of the blocking socket
+            if (sent <= 0)
+            {
+                return false;
+            }
+
+            count -= static_cast<uint64_t>(sent);
+        }
+
+        return true;
+#elif defined(__APPLE__)
+        int socketFd = socket.impl()->sockfd();
+
+        while (count > 0)
+        {
+            off_t length = static_cast<off_t>(count);
+            int result = ::sendfile(fileFd, socketFd, static_cast<off_t>(offset), &length, nullptr, 0);
+
+            // On error length still holds what was sent before it
+            offset += static_cast<uint64_t>(length);
+            count -= static_cast<uint64_t>(length);
+
+            if (result < 0 && errno != EINTR && errno != EAGAIN)
+            {
+                return false;
+            }
+
+            if (result < 0 && errno == EAGAIN && length == 0)
+            {
+                return false;
+            }
+        }
+
+        return true;
+#else
+        // No sendfile, copied through one small buffer
+        std::vector<char> buffer(64 * 1024);
+
+        while (count > 0)
+        {
+            size_t chunk = static_cast<size_t>(std::min<uint64_t>(count, buffer.size()));
+            ssize_t bytes = ::pread(fileFd, buffer.data(), chunk, static_cast<off_t>(offset));
+
+            if (bytes <= 0 || socket.sendBytes(buffer.data(), static_cast<int>(bytes)) != bytes)
+            {
+                return false;
+            }
+
+            offset += static_cast<uint64_t>(bytes);
+            count -= static_cast<uint64_t>(bytes);
+        }
+
+        return true;
+#endif
+    }
+}
+
+RangeRequest parseRange(const std::string &header, uint64_t fileSize, ByteRange &range)
+{
+    const std::string unit = "bytes=";
+
+    if (header.compare(0, unit.size(), unit) != 0 || header.find(',') != std::string::npos)
+    {
+        return RangeRequest::None;
+    }
+
+    std::string spec = header.substr(unit.size());
+    size_t dash = spec.find('-');
+    if (dash == std::string::npos)
+    {
+        return RangeRequest::None;
+    }
+
+    std::string firstText = spec.substr(0, dash);
+    std::string lastText = spec.substr(dash + 1);
+    uint64_t first = 0;
+    uint64_t last = 0;
+
+    if (firstText.empty())
+    {
+        // Suffix: the last n bytes
+        uint64_t suffix;
+        if (!parseNumber(lastText, suffix))
+        {
+            return RangeRequest::None;
+        }
+
+        if (suffix == 0 || fileSize == 0)
+        {
+            return RangeRequest::Unsatisfiable;
+        }
+
+        range.first = fileSize - std::min(suffix, fileSize);
+        range.last = fileSize - 1;
+        return RangeRequest::Satisfiable;
+    }
+
+    if (!parseNumber(firstText, first) || (!lastText.empty() && !parseNumber(lastText, last)))
+    {
+        return RangeRequest::None;
+    }
+
+    if (!lastText.empty() && last < first)
+    {
+        return RangeRequest::None; // Invalid, ignored
+    }
+
+    if (first >= fileSize)
+    {
+        return RangeRequest::Unsatisfiable;
+    }
+
+    range.first = first;
+    range.last = lastText.empty() ? fileSize - 1 : std::min(last, fileSize - 1);
+    return RangeRequest::Satisfiable;
+}
+
+void sendFileStreamed(HTTPServerRequest &req, HTTPServerResponse &resp, const std::string &path, const std::string &contentType)
+{
+    FileDescriptor file(::open(path.c_str(), O_RDONLY));
+    struct stat info;
+
+    if (file.get() < 0 || ::fstat(file.get(), &info) != 0 || !S_ISREG(info.st_mode))
+    {
+        resp.setStatus(HTTPResponse::HTTP_NOT_FOUND);
+        resp.send() << "404 - Not Found";
+        return;
+    }
+
+    uint64_t fileSize = static_cast<uint64_t>(info.st_size);
+
+    // Changes with the file, lets a client resume a download only of the same version
+    char etag[48];
+    std::snprintf(etag, sizeof(etag), "\"%llx-%llx\"", static_cast<unsigned long long>(fileSize), static_cast<unsigned long long>(info.st_mtime));
+
+    resp.set("Accept-Ranges", "bytes");
+    resp.set("ETag", etag);
+
+    ByteRange range{0, fileSize > 0 ? fileSize - 1 : 0};
+    RangeRequest rangeRequest = RangeRequest::None;
+
+    if (req.has("Range") && (!req.has("If-Range") || req.get("If-Range") == etag))
+    {
+        rangeRequest = parseRange(req.get("Range"), fileSize, range);
+    }
+
+    if (rangeRequest == RangeRequest::Unsatisfiable)
+    {
+        resp.setStatus(HTTPResponse::HTTP_REQUESTED_RANGE_NOT_SATISFIABLE);
+        resp.set("Content-Range", "bytes */" + std::to_string(fileSize));
+        resp.setContentLength(0);
+        resp.send();
+        return;
+    }
+
+    uint64_t length = fileSize > 0 ? range.length() : 0;
+
+    if (rangeRequest == RangeRequest::Satisfiable)
+    {
+        resp.setStatus(HTTPResponse::HTTP_PARTIAL_CONTENT);
+        resp.set("Content-Range", "bytes " + std::to_string(range.first) + "-" + std::to_string(range.last) + "/" + std::to_string(fileSize));
+    }
+    else
+    {
+        resp.setStatus(HTTPResponse::HTTP_OK);
+    }
+
+    resp.setContentType(contentType);
+    resp.setContentLength64(static_cast<Poco::Int64>(length));
+
+    // Headers only, the body below is written to the socket directly
+    std::ostream &out = resp.send();
+    out.flush();
+
+    if (req.getMethod() == HTTPRequest::HTTP_HEAD || length == 0)
+    {
+        return;
+    }
+
+    StreamSocket &socket = static_cast<HTTPServerRequestImpl &>(req).socket();
+
+    if (!copyToSocket(file.get(), socket, range.first, length))
+    {
+        // The response is cut short, the connection cannot be reused
+        resp.setKeepAlive(false);
+        socket.shutdown();
+    }
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include <Poco/Net/HTTPServerRequest.h>
+#include <Poco/Net/HTTPServerResponse.h>
+
+// Inclusive byte range of a file
+struct ByteRange
+{
+    uint64_t first = 0;
+    uint64_t last = 0;
+
+    uint64_t length() const { return last - first + 1; }
+};
+
+enum class RangeRequest
+{
+    None, // No header, another unit or several ranges: the whole file is sent
+    Satisfiable,
+    Unsatisfiable
+};
+
+// Parses "bytes=first-last", "bytes=first-" and "bytes=-suffix"
+RangeRequest parseRange(const std::string &header, uint64_t fileSize, ByteRange &range);
+
+// Sends a file, or the range asked for, with a fixed amount of memory per
+// connection: the headers go through Poco, then the kernel copies the body
+// from the file to the socket with sendfile. Supports Range, If-Range and HEAD.
+void sendFileStreamed(Poco::Net::HTTPServerRequest &req, Poco::Net::HTTPServerResponse &resp, const std::string &path, const std::string &contentType);
@@ -0,0 +1,486 @@
+#include "folder_watcher.h"
+
+#include <algorithm>
+#include <filesystem>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <unordered_set>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    // A batch is published once the folder has been quiet this long, or at
+    // the latest this long after its first event so a long copy shows progress
+    const std::chrono::milliseconds quietPeriod(200);
+    const std::chrono::milliseconds maxBatchDelay(1000);
+
+    // Without inotify
+    const std::chrono::seconds pollInterval(2);
+
+    struct FileStamp
+    {
+        int64_t mtime = 0;
+        uintmax_t size = 0;
+
+        bool operator!=(const FileStamp &other) const { return mtime != other.mtime || size != other.size; }
+    };
+
+    std::map<std::string, FileStamp> listFolder(const std::string &folder)
+    {
+        std::map<std::string, FileStamp> listing;
+        std::error_code error;
+
+        for (const auto &entry : fs::directory_iterator(folder, error))
+        {
+            if (!entry.is_regular_file(error))
+            {
+                continue;
+            }
+
+            FileStamp stamp;
+            stamp.mtime = static_cast<int64_t>(entry.last_write_time(error).time_since_epoch().count());
+            stamp.size = entry.file_size(error);
+            listing[entry.path().string()] = stamp;
+        }
+
+        return listing;
+    }
+}
+
+FolderWatcher::FolderWatcher()
+{
+#if defined(__linux__)
+    wakeEvent = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+#endif
+}
+
+FolderWatcher::~FolderWatcher()
+{
+    stop();
+
+#if defined(__linux__)
+    if (wakeEvent >= 0)
+    {
+        close(wakeEvent);
+    }
+#endif
+}
+
+void FolderWatcher::watch(const std::string &folder)
+{
+    stop();
+
+    if (folder.empty())
+    {
+        return;
+    }
+
+    pending.clear();
+    rescanPending = false;
+    unpublishedEvents = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        published.clear(); // Changes of the previous folder
+        running = true;
+    }
+
+    thread = std::thread(&FolderWatcher::run, this, folder);
+}
+
+void FolderWatcher::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+
+    stopRequested.notify_all();
+
+#if defined(__linux__)
+    if (wakeEvent >= 0)
+    {
+        uint64_t one = 1;
+        ssize_t written = write(wakeEvent, &one, sizeof(one));
+        (void)written;
+    }
+#endif
+
+    if (thread.joinable())
+    {
+        thread.join();
+    }
+
+#if defined(__linux__)
+    // Left set when the thread had already stopped
+    if (wakeEvent >= 0)
+    {
+        uint64_t value = 0;
+        ssize_t readBytes = read(wakeEvent, &value, sizeof(value));
+        (void)readBytes;
+    }
+#endif
+}
+
+bool FolderWatcher::poll(std::vector<FolderChange> &changes)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    changes.clear();
+    changes.swap(published);
+    return !changes.empty();
+}
+
+FolderWatchStats FolderWatcher::statistics() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
+
+void FolderWatcher::run(std::string folder)
+{
+#if defined(__linux__)
+    if (runInotify(folder))
+    {
+        return;
+    }
+#endif
+
+    runPolling(folder);
+}
+
+void FolderWatcher::record(FolderChangeType type, const std::string &path, const std::string &oldPath)
+{
+    Clock::time_point now = Clock::now();
+    if (pending.empty() && !rescanPending)
+    {
+        firstEvent = now;
+    }
+
+    lastEvent = now;
+    unpublishedEvents++;
+
+    if (type == FolderChangeType::Rescan)
+    {
+        pending.clear();
+        rescanPending = true;
+        return;
+    }
+
+    // The rescan covers everything that happens until it is published
+    if (rescanPending)
+    {
+        return;
+    }
+
+    auto previous = pending.find(path);
+
+    switch (type)
+    {
+    case FolderChangeType::Added:
+    case FolderChangeType::Modified:
+        if (previous == pending.end())
+        {
+            pending[path] = {type, path, std::string()};
+        }
+        else if (previous->second.type == FolderChangeType::Removed)
+        {
+            previous->second.type = FolderChangeType::Modified; // Replaced within the batch
+        }
+        else if (previous->second.type == FolderChangeType::Renamed)
+        {
+            // New content under the new name, the old thumbnail cannot be kept
+            pending[previous->second.oldPath] = {FolderChangeType::Removed, previous->second.oldPath, std::string()};
+            previous->second = {FolderChangeType::Added, path, std::string()};
+        }
+        break;
+
+    case FolderChangeType::Removed:
+        if (previous == pending.end())
+        {
+            pending[path] = {type, path, std::string()};
+        }
+        else if (previous->second.type == FolderChangeType::Added)
+        {
+            pending.erase(previous); // Never reached the catalog
+        }
+        else if (previous->second.type == FolderChangeType::Modified)
+        {
+            previous->second.type = FolderChangeType::Removed;
+        }
+        else if (previous->second.type == FolderChangeType::Renamed)
+        {
+            std::string original = previous->second.oldPath;
+            pending.erase(previous);
+
+            auto replaced = pending.find(original);
+            if (replaced != pending.end() && replaced->second.type == FolderChangeType::Added)
+            {
+                replaced->second.type = FolderChangeType::Modified;
+            }
+            else
+            {
+                pending[original] = {FolderChangeType::Removed, original, std::string()};
+            }
+        }
+        break;
+
+    case FolderChangeType::Renamed:
+    {
+        FolderChange moved = {FolderChangeType::Renamed, path, oldPath};
+
+        auto old = pending.find(oldPath);
+        if (old != pending.end())
+        {
+            if (old->second.type == FolderChangeType::Renamed)
+            {
+                moved.oldPath = old->second.oldPath; // Renamed twice
+                pending.erase(old);
+            }
+            else if (old->second.type != FolderChangeType::Removed)
+            {
+                // The catalog may not have the old name yet, so it is loaded again
+                old->second = {FolderChangeType::Removed, oldPath, std::string()};
+                moved = {FolderChangeType::Added, path, std::string()};
+            }
+        }
+
+        pending[path] = moved;
+        break;
+    }
+
+    case FolderChangeType::Rescan:
+        break;
+    }
+}
+
+bool FolderWatcher::settled(Clock::time_point now) const
+{
+    if (pending.empty() && !rescanPending)
+    {
+        return false;
+    }
+
+    return now - lastEvent >= quietPeriod || now - firstEvent >= maxBatchDelay;
+}
+
+int FolderWatcher::settleTimeoutMs(Clock::time_point now) const
+{
+    if (pending.empty() && !rescanPending)
+    {
+        return -1;
+    }
+
+    auto remaining = (std::min)(quietPeriod - (now - lastEvent), maxBatchDelay - (now - firstEvent));
+    return static_cast<int>((std::max)(std::chrono::ceil<std::chrono::milliseconds>(remaining).count(), static_cast<std::chrono::milliseconds::rep>(0)));
+}
+
+void FolderWatcher::publish()
+{
+    std::vector<FolderChange> batch;
+
+    if (rescanPending)
+    {
+        batch.push_back({FolderChangeType::Rescan, std::string(), std::string()});
+    }
+    else
+    {
+        batch.reserve(pending.size());
+        for (auto &change : pending)
+        {
+            batch.push_back(std::move(change.second));
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        published.insert(published.end(), std::make_move_iterator(batch.begin()), std::make_move_iterator(batch.end()));
+        stats.events += unpublishedEvents;
+        stats.batches++;
+        stats.changes += batch.size();
+        stats.rescans += rescanPending ? 1 : 0;
+    }
+
+    pending.clear();
+    rescanPending = false;
+    unpublishedEvents = 0;
+}
+
+void FolderWatcher::runPolling(const std::string &folder)
+{
+    std::map<std::string, FileStamp> listing = listFolder(folder);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!stopRequested.wait_for(lock, pollInterval, [&]()
+                                   { return !running; }))
+    {
+        lock.unlock();
+
+        // Files written during the interval may still be growing, they show up as modified later
+        std::map<std::string, FileStamp> next = listFolder(folder);
+
+        for (const auto &file : next)
+        {
+            auto known = listing.find(file.first);
+            if (known == listing.end())
+            {
+                record(FolderChangeType::Added, file.first);
+            }
+            else if (known->second != file.second)
+            {
+                record(FolderChangeType::Modified, file.first);
+            }
+        }
+
+        for (const auto &file : listing)
+        {
+            if (next.count(file.first) == 0)
+            {
+                record(FolderChangeType::Removed, file.first);
+            }
+        }
+
+        // The interval already spaces the batches
+        if (!pending.empty())
+        {
+            publish();
+        }
+
+        listing = std::move(next);
+        lock.lock();
+    }
+}
+
+#if defined(__linux__)
+bool FolderWatcher::runInotify(const std::string &folder)
+{
+    int inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify < 0 || wakeEvent < 0)
+    {
+        if (inotify >= 0)
+        {
+            close(inotify);
+        }
+        return false;
+    }
+
+    // Files are only reported once closed after writing, so a copy in progress is never decoded
+    uint32_t mask = IN_CREATE | IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+    if (inotify_add_watch(inotify, folder.c_str(), mask) < 0)
+    {
+        close(inotify);
+        return false;
+    }
+
+    pollfd fds[2] = {{inotify, POLLIN, 0}, {wakeEvent, POLLIN, 0}};
+    std::unordered_set<std::string> created; // Created but not closed yet
+    alignas(inotify_event) char buffer[16384];
+
+    while (true)
+    {
+        int ready = ::poll(fds, 2, settleTimeoutMs(Clock::now()));
+        if (ready < 0 && errno != EINTR)
+        {
+            break;
+        }
+
+        if (fds[1].revents != 0)
+        {
+            break;
+        }
+
+        if (ready > 0 && (fds[0].revents & POLLIN) != 0)
+        {
+            // A move out of the folder has no IN_MOVED_TO, it is a removal
+            std::string movedFrom;
+            uint32_t movedCookie = 0;
+
+            ssize_t length;
+            while ((length = read(inotify, buffer, sizeof(buffer))) > 0)
+            {
+                for (char *next = buffer; next < buffer + length;)
+                {
+                    const inotify_event *event = reinterpret_cast<const inotify_event *>(next);
+                    next += sizeof(inotify_event) + event->len;
+
+                    if ((event->mask & IN_Q_OVERFLOW) != 0)
+                    {
+                        record(FolderChangeType::Rescan, std::string());
+                        continue;
+                    }
+
+                    if ((event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) != 0)
+                    {
+                        // Nothing more will come for this folder, only the stop request is waited for
+                        record(FolderChangeType::Rescan, std::string());
+                        fds[0].fd = -1;
+                        continue;
+                    }
+
+                    if ((event->mask & IN_ISDIR) != 0 || event->len == 0)
+                    {
+                        continue;
+                    }
+
+                    std::string path = folder + "/" + event->name;
+
+                    if ((event->mask & IN_CREATE) != 0)
+                    {
+                        created.insert(path);
+                    }
+                    else if ((event->mask & IN_CLOSE_WRITE) != 0)
+                    {
+                        record(created.erase(path) != 0 ? FolderChangeType::Added : FolderChangeType::Modified, path);
+                    }
+                    else if ((event->mask & IN_MOVED_FROM) != 0)
+                    {
+                        if (!movedFrom.empty())
+                        {
+                            record(FolderChangeType::Removed, movedFrom);
+                        }
+
+                        movedFrom = path;
+                        movedCookie = event->cookie;
+                    }
+                    else if ((event->mask & IN_MOVED_TO) != 0)
+                    {
+                        if (!movedFrom.empty() && event->cookie == movedCookie)
+                        {
+                            record(FolderChangeType::Renamed, path, movedFrom);
+                            movedFrom.clear();
+                        }
+                        else
+                        {
+                            record(FolderChangeType::Added, path);
+                        }
+                    }
+                    else if ((event->mask & IN_DELETE) != 0)
+                    {
+                        created.erase(path);
+                        record(FolderChangeType::Removed, path);
+                    }
+                }
+            }
+
+            if (!movedFrom.empty())
+            {
+                record(FolderChangeType::Removed, movedFrom);
+            }
+        }
+
+        if (settled(Clock::now()))
+        {
+            publish();
+        }
+    }
+
+    close(inotify);
+    return true;
+}
+#endif
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum class FolderChangeType
+{
+    Added,
+    Modified,
+    Removed,
+    Renamed,
+    Rescan // Events were lost or the folder itself went away, compare the whole listing
+};
+
+struct FolderChange
+{
+    FolderChangeType type = FolderChangeType::Rescan;
+    std::string path;    // The new path of a rename
+    std::string oldPath; // Renamed only
+};
+
+struct FolderWatchStats
+{
+    uint64_t events = 0;  // Raw notifications, or listing differences when polling
+    uint64_t batches = 0; // Published after the folder went quiet
+    uint64_t changes = 0; // Left after coalescing
+    uint64_t rescans = 0;
+};
+
+// Watches the files of one folder, not its subfolders, on its own thread. On
+// Linux the thread sleeps on inotify and only sees files once they are closed
+// after writing, elsewhere it compares listings every few seconds. Events are
+// coalesced per file and published as one batch once the folder has been
+// quiet for a moment, so a bulk copy ends in a few batches.
+class FolderWatcher
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    FolderWatcher();
+    ~FolderWatcher();
+
+    FolderWatcher(const FolderWatcher &) = delete;
+    FolderWatcher &operator=(const FolderWatcher &) = delete;
+
+    // Replaces the watched folder, an empty path only stops watching
+    void watch(const std::string &folder);
+    void stop();
+
+    // Render thread, takes the batches published since the last call
+    bool poll(std::vector<FolderChange> &changes);
+
+    FolderWatchStats statistics() const;
+
+private:
+    void run(std::string folder);
+    void runPolling(const std::string &folder);
+#if defined(__linux__)
+    bool runInotify(const std::string &folder);
+#endif
+
+    // Watcher thread only
+    void record(FolderChangeType type, const std::string &path, const std::string &oldPath = std::string());
+    void publish();
+    bool settled(Clock::time_point now) const;
+    int settleTimeoutMs(Clock::time_point now) const;
+
+    std::map<std::string, FolderChange> pending; // By path, published in name order
+    bool rescanPending = false;
+    uint64_t unpublishedEvents = 0;
+    Clock::time_point firstEvent;
+    Clock::time_point lastEvent;
+
+    mutable std::mutex mutex;
+    std::vector<FolderChange> published;
+    FolderWatchStats stats;
+
+    std::condition_variable stopRequested;
+    bool running = false;
+
+#if defined(__linux__)
+    int wakeEvent = -1;
+#endif
+
+    std::thread thread;
+};
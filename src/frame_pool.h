@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "spsc_queue.h"
+
+// Fixed set of frames recycled between one producer and one consumer thread.
+// Only slot indices travel through the queues and the frames keep their
+// buffers, so once every slot has been filled at the current resolution no
+// more heap memory is requested.
+template <typename T>
+class FramePool
+{
+public:
+    explicit FramePool(size_t count)
+        : items(count), freeSlots(count), readySlots(count)
+    {
+        reset();
+    }
+
+    FramePool(const FramePool &) = delete;
+    FramePool &operator=(const FramePool &) = delete;
+
+    // Producer side, the same slot is returned until it is published
+    T *acquire()
+    {
+        if (producing == none && !freeSlots.pop(producing))
+        {
+            producing = none;
+            return nullptr;
+        }
+
+        return &items[producing];
+    }
+
+    bool canAcquire() const { return producing != none || !freeSlots.empty(); }
+
+    void publish()
+    {
+        readySlots.push(size_t(producing));
+        producing = none;
+    }
+
+    // Consumer side, the oldest published frame or nullptr
+    T *peek()
+    {
+        size_t *slot = readySlots.front();
+        return slot != nullptr ? &items[*slot] : nullptr;
+    }
+
+    // Consumer side, makes the oldest published frame the held one and
+    // recycles the frame held before
+    T *take()
+    {
+        size_t slot = none;
+        if (!readySlots.pop(slot))
+        {
+            return nullptr;
+        }
+
+        releaseHeld();
+        held = slot;
+        return &items[held];
+    }
+
+    void releaseHeld()
+    {
+        if (held != none)
+        {
+            freeSlots.push(size_t(held));
+            held = none;
+        }
+    }
+
+    // Only while neither side is running, buffers stay allocated
+    void reset()
+    {
+        size_t slot = 0;
+        while (readySlots.pop(slot))
+        {
+        }
+        while (freeSlots.pop(slot))
+        {
+        }
+
+        for (size_t i = 0; i < items.size(); ++i)
+        {
+            freeSlots.push(size_t(i));
+        }
+
+        producing = none;
+        held = none;
+    }
+
+    size_t size() const { return items.size(); }
+
+private:
+    static constexpr size_t none = static_cast<size_t>(-1);
+
+    std::vector<T> items;
+    SpscQueue<size_t> freeSlots;  // Consumer to producer
+    SpscQueue<size_t> readySlots; // Producer to consumer
+    size_t producing = none;      // Producer only
+    size_t held = none;           // Consumer only
+};
@@ -0,0 +1,233 @@
+#include "frame_profiler.h"
+
+#include <algorithm>
+#include <iterator>
+
+#include "imgui.h"
+
+namespace
+{
+    double millisecondsBetween(FrameProfiler::Clock::time_point from, FrameProfiler::Clock::time_point to)
+    {
+        return std::chrono::duration<double, std::milli>(to - from).count();
+    }
+}
+
+void FrameProfiler::Samples::add(float value)
+{
+    values[next] = value;
+    next = (next + 1) % historySize;
+    count = std::min(count + 1, historySize);
+}
+
+FrameProfiler::FrameProfiler(double targetHz)
+    : targetHz(targetHz)
+{
+    sorted.reserve(historySize);
+}
+
+FrameProfiler::~FrameProfiler()
+{
+    releaseQueries();
+}
+
+int FrameProfiler::addStage(const std::string &name)
+{
+    stages.push_back(Stage());
+    stages.back().name = name;
+    return static_cast<int>(stages.size()) - 1;
+}
+
+void FrameProfiler::beginFrame(Clock::time_point now)
+{
+    if (frameStarted)
+    {
+        double frameMs = millisecondsBetween(frameStart, now);
+        frames.add(static_cast<float>(frameMs));
+
+        frameTotal++;
+        if (frameMs > targetMs() * 1.5)
+        {
+            missedTotal++;
+        }
+    }
+
+    frameStart = now;
+    frameStarted = true;
+
+    collectQueries();
+}
+
+void FrameProfiler::begin(int stage)
+{
+    stages[stage].start = Clock::now();
+}
+
+void FrameProfiler::end(int stage)
+{
+    Stage &entry = stages[stage];
+    entry.cpu.add(static_cast<float>(millisecondsBetween(entry.start, Clock::now())));
+}
+
+void FrameProfiler::addSample(int stage, double ms)
+{
+    stages[stage].cpu.add(static_cast<float>(ms));
+}
+
+void FrameProfiler::beginGpu(int stage)
+{
+    Stage &entry = stages[stage];
+
+    if (entry.queries[0] == 0)
+    {
+        glGenQueries(queryFrames, entry.queries);
+    }
+
+    // Every query still in flight, skip this sample rather than wait
+    int index = entry.nextQuery;
+    if (entry.queryPending[index])
+    {
+        entry.activeQuery = -1;
+        return;
+    }
+
+    glBeginQuery(GL_TIME_ELAPSED, entry.queries[index]);
+    entry.activeQuery = index;
+    entry.nextQuery = (index + 1) % queryFrames;
+}
+
+void FrameProfiler::endGpu(int stage)
+{
+    Stage &entry = stages[stage];
+
+    if (entry.activeQuery < 0)
+    {
+        return;
+    }
+
+    glEndQuery(GL_TIME_ELAPSED);
+    entry.queryPending[entry.activeQuery] = true;
+    entry.activeQuery = -1;
+}
+
+void FrameProfiler::collectQueries()
+{
+    for (Stage &entry : stages)
+    {
+        for (int i = 0; i < queryFrames; ++i)
+        {
+            if (!entry.queryPending[i])
+            {
+                continue;
+            }
+
+            GLint available = 0;
+            glGetQueryObjectiv(entry.queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available)
+            {
+                continue;
+            }
+
+            GLuint64 elapsed = 0;
+            glGetQueryObjectui64v(entry.queries[i], GL_QUERY_RESULT, &elapsed);
+            entry.gpu.add(static_cast<float>(elapsed / 1.0e6));
+            entry.queryPending[i] = false;
+        }
+    }
+}
+
+void FrameProfiler::releaseQueries()
+{
+    for (Stage &entry : stages)
+    {
+        if (entry.queries[0] != 0)
+        {
+            glDeleteQueries(queryFrames, entry.queries);
+            std::fill(std::begin(entry.queries), std::end(entry.queries), 0u);
+            std::fill(std::begin(entry.queryPending), std::end(entry.queryPending), false);
+        }
+    }
+}
+
+FrameProfiler::Percentiles FrameProfiler::percentiles(const Samples &samples) const
+{
+    Percentiles result;
+    if (samples.count == 0)
+    {
+        return result;
+    }
+
+    sorted.assign(samples.values.begin(), samples.values.begin() + samples.count);
+    std::sort(sorted.begin(), sorted.end());
+
+    auto at = [this](double fraction)
+    {
+        size_t index = static_cast<size_t>(fraction * (sorted.size() - 1) + 0.5);
+        return sorted[index];
+    };
+
+    result.p50 = at(0.50);
+    result.p95 = at(0.95);
+    result.p99 = at(0.99);
+    result.max = sorted.back();
+    result.count = samples.count;
+    return result;
+}
+
+void FrameProfilerOverlay(const FrameProfiler &profiler, bool *open)
+{
+    ImGui::SetNextWindowBgAlpha(0.85f);
+    if (!ImGui::Begin("Frame Timings", open, ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoFocusOnAppearing))
+    {
+        ImGui::End();
+        return;
+    }
+
+    FrameProfiler::Percentiles frame = profiler.framePercentiles();
+    ImGui::Text("Frame p50 %.2f  p95 %.2f  p99 %.2f  max %.2f ms (target %.2f ms)", frame.p50, frame.p95, frame.p99, frame.max, profiler.targetMs());
+    ImGui::Text("%llu frames, %llu missed", static_cast<unsigned long long>(profiler.frameCount()), static_cast<unsigned long long>(profiler.missedFrames()));
+
+    ImGui::PlotLines("##frames", profiler.frameHistory(), FrameProfiler::historySize, profiler.historyOffset(), nullptr, 0.0f, static_cast<float>(profiler.targetMs() * 2.0), ImVec2(420.0f, 60.0f));
+
+    if (ImGui::BeginTable("stages", 7, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+    {
+        ImGui::TableSetupColumn("Stage");
+        ImGui::TableSetupColumn("CPU p50");
+        ImGui::TableSetupColumn("CPU p95");
+        ImGui::TableSetupColumn("CPU p99");
+        ImGui::TableSetupColumn("GPU p50");
+        ImGui::TableSetupColumn("GPU p95");
+        ImGui::TableSetupColumn("GPU p99");
+        ImGui::TableHeadersRow();
+
+        for (int i = 0; i < profiler.stageCount(); ++i)
+        {
+            FrameProfiler::Percentiles cpu = profiler.cpuPercentiles(i);
+            FrameProfiler::Percentiles gpu = profiler.gpuPercentiles(i);
+
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(profiler.stageName(i).c_str());
+
+            for (const FrameProfiler::Percentiles *values : {&cpu, &gpu})
+            {
+                for (float value : {values->p50, values->p95, values->p99})
+                {
+                    ImGui::TableNextColumn();
+                    if (values->count > 0)
+                    {
+                        ImGui::Text("%.2f", value);
+                    }
+                    else
+                    {
+                        ImGui::TextDisabled("-");
+                    }
+                }
+            }
+        }
+
+        ImGui::EndTable();
+    }
+
+    ImGui::End();
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "opengl.h"
+
+// Per-stage frame timings. CPU stages are timed with a steady clock, GPU
+// stages with GL_TIME_ELAPSED queries that are read back a few frames later
+// so the render thread never waits for the GPU. Each stage keeps a rolling
+// window of samples for percentiles.
+class FrameProfiler
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr int historySize = 600; // Ten seconds at 60 Hz
+
+    struct Percentiles
+    {
+        float p50 = 0.0f;
+        float p95 = 0.0f;
+        float p99 = 0.0f;
+        float max = 0.0f;
+        int count = 0;
+    };
+
+    explicit FrameProfiler(double targetHz = 60.0);
+    ~FrameProfiler();
+
+    FrameProfiler(const FrameProfiler &) = delete;
+    FrameProfiler &operator=(const FrameProfiler &) = delete;
+
+    int addStage(const std::string &name);
+
+    // Marks the start of a frame, the interval since the previous one is the frame time
+    void beginFrame(Clock::time_point now = Clock::now());
+
+    void begin(int stage);
+    void end(int stage);
+    void addSample(int stage, double ms);
+
+    // GPU stages must not overlap, only one timer query can be active at a time
+    void beginGpu(int stage);
+    void endGpu(int stage);
+
+    // Releases the queries, needs the context that created them
+    void releaseQueries();
+
+    int stageCount() const { return static_cast<int>(stages.size()); }
+    const std::string &stageName(int stage) const { return stages[stage].name; }
+
+    Percentiles cpuPercentiles(int stage) const { return percentiles(stages[stage].cpu); }
+    Percentiles gpuPercentiles(int stage) const { return percentiles(stages[stage].gpu); }
+    Percentiles framePercentiles() const { return percentiles(frames); }
+
+    // Frame times in ms, oldest first starting at historyOffset()
+    const float *frameHistory() const { return frames.values.data(); }
+    int historyOffset() const { return frames.next; }
+
+    double targetMs() const { return 1000.0 / targetHz; }
+    uint64_t frameCount() const { return frameTotal; }
+    uint64_t missedFrames() const { return missedTotal; } // Frames longer than 1.5 target intervals
+
+private:
+    static constexpr int queryFrames = 4;
+
+    struct Samples
+    {
+        std::vector<float> values = std::vector<float>(historySize, 0.0f);
+        int next = 0;
+        int count = 0;
+
+        void add(float value);
+    };
+
+    struct Stage
+    {
+        std::string name;
+        Samples cpu;
+        Samples gpu;
+        Clock::time_point start;
+
+        GLuint queries[queryFrames] = {};
+        bool queryPending[queryFrames] = {};
+        int nextQuery = 0;
+        int activeQuery = -1;
+    };
+
+    Percentiles percentiles(const Samples &samples) const;
+    void collectQueries();
+
+    std::vector<Stage> stages;
+    Samples frames;
+    mutable std::vector<float> sorted; // Scratch for percentiles
+
+    double targetHz;
+    bool frameStarted = false;
+    Clock::time_point frameStart;
+    uint64_t frameTotal = 0;
+    uint64_t missedTotal = 0;
+};
+
+// Window with the percentile table and the frame time graph
+void FrameProfilerOverlay(const FrameProfiler &profiler, bool *open);
@@ -0,0 +1,415 @@
+#include "headless.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+
+#include <nlohmann/json.hpp>
+
+#include "imgui.h"
+#include "backends/imgui_impl_opengl3.h"
+#include "opengl.h"
+
+#include "image_decode_pool.h"
+#include "projector.h"
+#include "sdf_font.h"
+#include "streaming_texture.h"
+#include "thumbnail_cache.h"
+#include "video_player.h"
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double millisecondsBetween(Clock::time_point from, Clock::time_point to)
+    {
+        return std::chrono::duration<double, std::milli>(to - from).count();
+    }
+
+    struct FrameTiming
+    {
+        int frame;
+        int step;
+        double mediaMs;
+        double updateMs;   // Image decode and upload or video frame upload
+        double buildMs;    // ImGui frame
+        double renderMs;   // Draw calls until glFinish returns
+        double readbackMs; // Only with hashing
+        double totalMs;
+        uint64_t hash;
+    };
+
+    struct ContextAttempt
+    {
+        int platform;
+        int api;
+        const char *name;
+    };
+
+    // Prefers a context without any window system, falls back to a hidden window
+    GLFWwindow *createOffscreenContext()
+    {
+        const ContextAttempt attempts[] = {
+#if defined(GLFW_PLATFORM_NULL)
+            {GLFW_PLATFORM_NULL, GLFW_EGL_CONTEXT_API, "null platform, EGL"},
+            {GLFW_PLATFORM_NULL, GLFW_OSMESA_CONTEXT_API, "null platform, OSMesa"},
+            {GLFW_ANY_PLATFORM, GLFW_NATIVE_CONTEXT_API, "hidden window"},
+#else
+            {0, 0, "hidden window"},
+#endif
+        };
+
+        for (const ContextAttempt &attempt : attempts)
+        {
+#if defined(GLFW_PLATFORM_NULL)
+            glfwInitHint(GLFW_PLATFORM, attempt.platform);
+#endif
+            if (!glfwInit())
+            {
+                continue;
+            }
+
+            glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+            glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+            glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
+            glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#if defined(GLFW_PLATFORM_NULL)
+            glfwWindowHint(GLFW_CONTEXT_CREATION_API, attempt.api);
+#endif
+#ifdef __APPLE__
+            glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+
+            // The window is only there for the context, frames go to a framebuffer object
+            if (GLFWwindow *window = glfwCreateWindow(16, 16, "Headless", nullptr, nullptr))
+            {
+                glfwMakeContextCurrent(window);
+                std::cout << "Headless: " << attempt.name << ", " << glGetString(GL_RENDERER) << "." << std::endl;
+                return window;
+            }
+
+            glfwTerminate();
+        }
+
+        return nullptr;
+    }
+
+    // Color target the projector is rendered into
+    class OffscreenTarget
+    {
+    public:
+        OffscreenTarget(int width, int height)
+        {
+            glGenTextures(1, &colorTexture);
+            glBindTexture(GL_TEXTURE_2D, colorTexture);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+            glGenFramebuffers(1, &framebuffer);
+            glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0);
+            complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+        }
+
+        ~OffscreenTarget()
+        {
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            glDeleteFramebuffers(1, &framebuffer);
+            glDeleteTextures(1, &colorTexture);
+        }
+
+        OffscreenTarget(const OffscreenTarget &) = delete;
+        OffscreenTarget &operator=(const OffscreenTarget &) = delete;
+
+        bool isComplete() const { return complete; }
+
+    private:
+        GLuint framebuffer = 0;
+        GLuint colorTexture = 0;
+        bool complete = false;
+    };
+
+    double percentile(std::vector<double> values, double fraction)
+    {
+        if (values.empty())
+        {
+            return 0.0;
+        }
+
+        std::sort(values.begin(), values.end());
+        return values[static_cast<size_t>(fraction * (values.size() - 1) + 0.5)];
+    }
+
+    void writeTimings(const std::string &path, const std::vector<FrameTiming> &timings, bool hashed)
+    {
+        std::ofstream file(path);
+        file << "frame,step,media_ms,update_ms,build_ms,render_ms,readback_ms,total_ms" << (hashed ? ",hash" : "") << "\n";
+        file << std::fixed << std::setprecision(3);
+
+        for (const FrameTiming &timing : timings)
+        {
+            file << timing.frame << "," << timing.step << "," << timing.mediaMs << "," << timing.updateMs << "," << timing.buildMs << ","
+                 << timing.renderMs << "," << timing.readbackMs << "," << timing.totalMs;
+
+            if (hashed)
+            {
+                file << "," << std::hex << std::setw(16) << std::setfill('0') << timing.hash << std::dec << std::setfill(' ');
+            }
+
+            file << "\n";
+        }
+
+        if (!file)
+        {
+            std::cerr << "Error writing " << path << std::endl;
+        }
+    }
+}
+
+bool loadHeadlessScript(const std::string &path, HeadlessScript &script, std::string &error)
+{
+    std::ifstream file(path);
+    if (!file.is_open())
+    {
+        error = "cannot open " + path;
+        return false;
+    }
+
+    try
+    {
+        nlohmann::json j;
+        file >> j;
+
+        script.width = j.value("width", script.width);
+        script.height = j.value("height", script.height);
+        script.fps = j.value("fps", script.fps);
+        script.hash = j.value("hash", script.hash);
+        script.output = j.value("output", script.output);
+
+        for (const nlohmann::json &item : j.at("steps"))
+        {
+            HeadlessStep step;
+            step.image = item.value("image", "");
+            step.video = item.value("video", "");
+            step.text = item.value("text", "");
+            step.frames = item.value("frames", step.frames);
+            script.steps.push_back(step);
+        }
+    }
+    catch (const nlohmann::json::exception &e)
+    {
+        error = e.what();
+        return false;
+    }
+
+    if (script.width <= 0 || script.height <= 0 || script.fps <= 0.0)
+    {
+        error = "width, height and fps must be positive";
+        return false;
+    }
+
+    return true;
+}
+
+int runHeadless(const std::string &scriptPath, const std::string &outputPath)
+{
+    HeadlessScript script;
+    std::string error;
+
+    if (!loadHeadlessScript(scriptPath, script, error))
+    {
+        std::cerr << "Error loading headless script: " << error << std::endl;
+        return 1;
+    }
+
+    GLFWwindow *window = createOffscreenContext();
+    if (window == nullptr)
+    {
+        std::cerr << "Error creating an offscreen OpenGL context." << std::endl;
+        return 1;
+    }
+
+    int result = 0;
+
+    {
+        OffscreenTarget target(script.width, script.height);
+        if (!target.isComplete())
+        {
+            std::cerr << "Error creating the offscreen framebuffer." << std::endl;
+            glfwDestroyWindow(window);
+            glfwTerminate();
+            return 1;
+        }
+
+        // No platform backend: display size and time step are set by hand, there is no input
+        IMGUI_CHECKVERSION();
+        ImGui::CreateContext();
+        ImGuiIO &io = ImGui::GetIO();
+        io.IniFilename = nullptr;
+        io.DisplaySize = ImVec2(static_cast<float>(script.width), static_cast<float>(script.height));
+        io.DeltaTime = static_cast<float>(1.0 / script.fps);
+        ImGui::StyleColorsDark();
+
+        io.Fonts->AddFontDefault();
+        ImGui_ImplOpenGL3_Init();
+
+        SdfFont fontPlayerText;
+
+        if (!fontPlayerText.load("fonts/Poppins-Bold.ttf") || !fontPlayerText.upload())
+        {
+            std::cerr << "Error while load font." << std::endl;
+        }
+
+        StreamingTexture imageTexture;
+        StreamingTexture videoTexture;
+        TextSlide slide;
+        VideoPlayer player;
+
+        std::vector<FrameTiming> timings;
+        std::vector<unsigned char> pixels(script.hash ? static_cast<size_t>(script.width) * script.height * 4 : 0);
+
+        // The simulated clock advances exactly one frame interval per frame
+        const Clock::duration frameInterval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / script.fps));
+        Clock::time_point mediaTime;
+        int frame = 0;
+
+        for (size_t stepIndex = 0; stepIndex < script.steps.size() && result == 0; ++stepIndex)
+        {
+            const HeadlessStep &step = script.steps[stepIndex];
+            ProjectorContent content;
+
+            for (int stepFrame = 0; stepFrame < step.frames; ++stepFrame, ++frame, mediaTime += frameInterval)
+            {
+                FrameTiming timing = {};
+                timing.frame = frame;
+                timing.step = static_cast<int>(stepIndex);
+                timing.mediaMs = millisecondsBetween(Clock::time_point(), mediaTime);
+
+                Clock::time_point frameStart = Clock::now();
+
+                if (stepFrame == 0)
+                {
+                    player.close();
+                    content = ProjectorContent();
+
+                    if (!step.text.empty())
+                    {
+                        content.text = step.text.c_str();
+                        content.font = &fontPlayerText;
+                        content.slide = &slide;
+                    }
+
+                    if (!step.image.empty())
+                    {
+                        DecodedImage image = ImageDecodePool::decodeFile(step.image);
+                        if (image.failed())
+                        {
+                            std::cerr << "Error loading image " << step.image << "." << std::endl;
+                            result = 1;
+                            break;
+                        }
+
+                        imageTexture.update(image.pixels.get(), image.width, image.height, static_cast<size_t>(image.width) * 4);
+                        content.textureID = imageTexture.id();
+                        content.width = image.width;
+                        content.height = image.height;
+                    }
+
+                    if (!step.video.empty() && !player.open(step.video))
+                    {
+                        std::cerr << "Error opening video " << step.video << "." << std::endl;
+                        result = 1;
+                        break;
+                    }
+                }
+
+                if (player.isOpen())
+                {
+                    if (const VideoFrame *videoFrame = player.updateSynchronous(mediaTime))
+                    {
+                        const cv::Mat &image = videoFrame->image;
+                        videoTexture.update(image.data, image.cols, image.rows, image.step, StreamingTexture::Format::BGR);
+                        content.textureID = videoTexture.id();
+                        content.width = image.cols;
+                        content.height = image.rows;
+                    }
+                }
+
+                Clock::time_point updateEnd = Clock::now();
+
+                // Same view as the projector window, covering the whole target
+                ImGui_ImplOpenGL3_NewFrame();
+                ImGui::NewFrame();
+
+                ImGui::SetNextWindowPos(ImVec2(0.0f, 0.0f));
+                ImGui::SetNextWindowSize(io.DisplaySize);
+                ImGui::PushStyleVar(ImGuiStyleVar_WindowPadding, ImVec2(0.0f, 0.0f));
+                ImGui::Begin("Projector", nullptr, ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoSavedSettings | ImGuiWindowFlags_NoBackground);
+                ProjectorView(content);
+                ImGui::End();
+                ImGui::PopStyleVar();
+
+                ImGui::Render();
+                Clock::time_point buildEnd = Clock::now();
+
+                glViewport(0, 0, script.width, script.height);
+                glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+                glClear(GL_COLOR_BUFFER_BIT);
+                ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+                slide.renderPending();
+                glFinish();
+                Clock::time_point renderEnd = Clock::now();
+
+                if (script.hash)
+                {
+                    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+                    glReadPixels(0, 0, script.width, script.height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+                    timing.hash = ThumbnailCache::hashBytes(pixels.data(), pixels.size());
+                }
+
+                Clock::time_point frameEnd = Clock::now();
+
+                timing.updateMs = millisecondsBetween(frameStart, updateEnd);
+                timing.buildMs = millisecondsBetween(updateEnd, buildEnd);
+                timing.renderMs = millisecondsBetween(buildEnd, renderEnd);
+                timing.readbackMs = millisecondsBetween(renderEnd, frameEnd);
+                timing.totalMs = millisecondsBetween(frameStart, frameEnd);
+                timings.push_back(timing);
+            }
+        }
+
+        player.close();
+
+        std::string path = !outputPath.empty() ? outputPath : (!script.output.empty() ? script.output : "headless_frames.csv");
+        writeTimings(path, timings, script.hash);
+
+        std::vector<double> totals;
+        std::vector<double> renders;
+        for (const FrameTiming &timing : timings)
+        {
+            totals.push_back(timing.totalMs);
+            renders.push_back(timing.renderMs);
+        }
+
+        std::cout << "Headless: " << timings.size() << " frames written to " << path << "." << std::endl;
+        std::cout << "Frames: p50 " << percentile(totals, 0.50) << " ms, p95 " << percentile(totals, 0.95) << " ms, p99 " << percentile(totals, 0.99) << " ms." << std::endl;
+        std::cout << "Render: p50 " << percentile(renders, 0.50) << " ms, p95 " << percentile(renders, 0.95) << " ms, p99 " << percentile(renders, 0.99) << " ms." << std::endl;
+
+        imageTexture.release();
+        videoTexture.release();
+        slide.release();
+        fontPlayerText.release();
+
+        ImGui_ImplOpenGL3_Shutdown();
+        ImGui::DestroyContext();
+    }
+
+    glfwDestroyWindow(window);
+    glfwTerminate();
+
+    return result;
+}
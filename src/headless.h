@@ -0,0 +1,42 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// One entry of a headless script, shown for a number of frames. A step may
+// have an image or a video plus an optional text drawn like the projector.
+struct HeadlessStep
+{
+    std::string image;
+    std::string video;
+    std::string text;
+    int frames = 60;
+};
+
+// Script for --headless, e.g.
+//
+//     {
+//         "width": 1280, "height": 720, "fps": 60, "hash": true,
+//         "steps": [
+//             {"image": "images/img-1.jpg", "frames": 30},
+//             {"video": "videos/video1.mp4", "frames": 300},
+//             {"text": "DEUS ENVIOU\nSEU FILHO AMADO", "frames": 30}
+//         ]
+//     }
+struct HeadlessScript
+{
+    int width = 1280;
+    int height = 720;
+    double fps = 60.0;  // Rate of the simulated clock
+    bool hash = false;  // Read every frame back and hash its pixels
+    std::string output; // Per-frame CSV, headless_frames.csv when empty
+    std::vector<HeadlessStep> steps;
+};
+
+bool loadHeadlessScript(const std::string &path, HeadlessScript &script, std::string &error);
+
+// Renders the projector output of the script into an offscreen framebuffer
+// with a simulated clock and writes per-frame timings and hashes. Needs no
+// display: uses GLFW's null platform with a surfaceless EGL or OSMesa
+// context when available (e.g. Mesa llvmpipe). Returns the exit code.
+int runHeadless(const std::string &scriptPath, const std::string &outputPath);
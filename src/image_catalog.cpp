@@ -0,0 +1,234 @@
+#include "image_catalog.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include "thumbnail_cache.h"
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    const int thumbnailSizes[] = {128, 256, 512};
+}
+
+ImageCatalog::ImageCatalog(size_t budgetBytes, int quality)
+    : budgetBytes(budgetBytes), quality(quality)
+{
+}
+
+void ImageCatalog::publish(std::vector<CatalogImage> images)
+{
+    auto next = std::make_shared<Snapshot>();
+    next->images = std::move(images);
+
+    std::lock_guard<std::mutex> lock(snapshotMutex);
+
+    // Size updates keep the generation, so clients keep their cached thumbnails
+    bool sameFiles = next->images.size() == current->images.size() &&
+                     std::equal(next->images.begin(), next->images.end(), current->images.begin(), [](const CatalogImage &a, const CatalogImage &b)
+                                { return a.path == b.path; });
+
+    next->generation = sameFiles ? current->generation : current->generation + 1;
+    current = std::move(next);
+}
+
+std::shared_ptr<const ImageCatalog::Snapshot> ImageCatalog::snapshot() const
+{
+    std::lock_guard<std::mutex> lock(snapshotMutex);
+    return current;
+}
+
+nlohmann::json ImageCatalog::page(size_t offset, size_t limit, int thumbnailWidth) const
+{
+    std::shared_ptr<const Snapshot> images = snapshot();
+    int width = ImageCatalog::thumbnailWidth(thumbnailWidth);
+
+    nlohmann::json items = nlohmann::json::array();
+    size_t end = std::min(images->images.size(), offset + limit);
+
+    for (size_t i = offset; i < end; ++i)
+    {
+        const CatalogImage &image = images->images[i];
+        items.push_back({
+            {"id", i},
+            {"name", fs::path(image.path).filename().string()},
+            {"width", image.width},
+            {"height", image.height},
+            {"thumb", "/api/thumb/" + std::to_string(i) + "?w=" + std::to_string(width) + "&v=" + std::to_string(images->generation) + "&r=" + std::to_string(image.revision)},
+        });
+    }
+
+    return {
+        {"generation", images->generation},
+        {"total", images->images.size()},
+        {"offset", offset},
+        {"images", items},
+    };
+}
+
+std::shared_ptr<const CatalogThumbnail> ImageCatalog::thumbnail(size_t id, int requestedWidth)
+{
+    std::shared_ptr<const Snapshot> images = snapshot();
+    if (id >= images->images.size())
+    {
+        return nullptr;
+    }
+
+    const CatalogImage &image = images->images[id];
+    int width = thumbnailWidth(requestedWidth);
+    // An edited file keeps its path, the revision keeps its old thumbnail from being served
+    std::string key = image.path + "#" + std::to_string(image.revision) + "@" + std::to_string(width);
+
+    std::promise<ThumbnailPtr> encoded;
+    std::shared_future<ThumbnailPtr> pending;
+
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+
+        auto entry = entries.find(key);
+        if (entry != entries.end())
+        {
+            uses.splice(uses.begin(), uses, entry->second.use);
+            hitCount++;
+            return entry->second.thumbnail;
+        }
+
+        auto running = encoding.find(key);
+        if (running != encoding.end())
+        {
+            pending = running->second;
+        }
+        else
+        {
+            encoding[key] = encoded.get_future().share();
+            missCount++;
+        }
+    }
+
+    if (pending.valid())
+    {
+        return pending.get();
+    }
+
+    // A file OpenCV cannot handle is a failure like an unreadable one, the
+    // waiting requests must still get an answer and the key be encoded again later
+    ThumbnailPtr thumbnail;
+    try
+    {
+        thumbnail = encode(image, width);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Error encoding thumbnail: " << image.path << " (" << e.what() << ")" << std::endl;
+    }
+
+    encoded.set_value(thumbnail);
+    store(key, thumbnail); // Also ends the encoding entry
+    return thumbnail;
+}
+
+int ImageCatalog::thumbnailWidth(int requested)
+{
+    for (int size : thumbnailSizes)
+    {
+        if (requested <= size)
+        {
+            return size;
+        }
+    }
+
+    return thumbnailSizes[std::size(thumbnailSizes) - 1];
+}
+
+CatalogStats ImageCatalog::statistics() const
+{
+    std::lock_guard<std::mutex> lock(cacheMutex);
+
+    CatalogStats stats;
+    stats.hits = hitCount;
+    stats.misses = missCount;
+    stats.entries = entries.size();
+    stats.bytes = cachedBytes;
+    return stats;
+}
+
+ImageCatalog::ThumbnailPtr ImageCatalog::encode(const CatalogImage &image, int width) const
+{
+    // JPEG files can be decoded at 1/2, 1/4 or 1/8 of their size, far cheaper than a full decode
+    int mode = cv::IMREAD_COLOR;
+    if (image.width >= width * 8)
+    {
+        mode = cv::IMREAD_REDUCED_COLOR_8;
+    }
+    else if (image.width >= width * 4)
+    {
+        mode = cv::IMREAD_REDUCED_COLOR_4;
+    }
+    else if (image.width >= width * 2)
+    {
+        mode = cv::IMREAD_REDUCED_COLOR_2;
+    }
+
+    cv::Mat pixels = cv::imread(image.path, mode);
+    if (pixels.empty())
+    {
+        return nullptr;
+    }
+
+    // Never scaled up
+    if (pixels.cols > width)
+    {
+        int height = std::max(1, static_cast<int>(static_cast<double>(pixels.rows) * width / pixels.cols + 0.5));
+        cv::Mat scaled;
+        cv::resize(pixels, scaled, cv::Size(width, height), 0, 0, cv::INTER_AREA);
+        pixels = scaled;
+    }
+
+    std::vector<unsigned char> buffer;
+    if (!cv::imencode(".jpg", pixels, buffer, {cv::IMWRITE_JPEG_QUALITY, quality}))
+    {
+        return nullptr;
+    }
+
+    auto thumbnail = std::make_shared<CatalogThumbnail>();
+    thumbnail->jpeg.assign(buffer.begin(), buffer.end());
+    thumbnail->width = pixels.cols;
+    thumbnail->height = pixels.rows;
+
+    std::ostringstream etag;
+    etag << "\"" << std::hex << ThumbnailCache::hashBytes(buffer.data(), buffer.size()) << "\"";
+    thumbnail->etag = etag.str();
+
+    return thumbnail;
+}
+
+void ImageCatalog::store(const std::string &key, ThumbnailPtr thumbnail)
+{
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    encoding.erase(key);
+
+    // Failures are not cached, the file may be fixed or replaced
+    if (!thumbnail)
+    {
+        return;
+    }
+
+    uses.push_front(key);
+    entries[key] = {thumbnail, uses.begin()};
+    cachedBytes += thumbnail->jpeg.size();
+
+    while (cachedBytes > budgetBytes && uses.size() > 1)
+    {
+        auto last = entries.find(uses.back());
+        cachedBytes -= last->second.thumbnail->jpeg.size();
+        entries.erase(last);
+        uses.pop_back();
+    }
+}
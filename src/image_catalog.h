@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+struct CatalogImage
+{
+    std::string path;
+    int width = 0; // Source size, zero until the library decoded the image
+    int height = 0;
+    uint64_t revision = 0; // Changes with the content of the file, part of the thumbnail key and URL
+};
+
+struct CatalogThumbnail
+{
+    std::string jpeg;
+    std::string etag;
+    int width = 0;
+    int height = 0;
+};
+
+struct CatalogStats
+{
+    uint64_t hits = 0;
+    uint64_t misses = 0; // Thumbnails encoded
+    size_t entries = 0;
+    size_t bytes = 0;
+};
+
+// Images of the project for the remote control. The render thread publishes
+// immutable snapshots of the list, the HTTP threads page through them and
+// get JPEG thumbnails that are encoded once per size and kept in memory, the
+// least recently used dropped over the budget.
+class ImageCatalog
+{
+public:
+    struct Snapshot
+    {
+        uint64_t generation = 0; // Changes with the list of files, ids are indexes into it
+        std::vector<CatalogImage> images;
+    };
+
+    explicit ImageCatalog(size_t budgetBytes = 32 * 1024 * 1024, int quality = 80);
+
+    ImageCatalog(const ImageCatalog &) = delete;
+    ImageCatalog &operator=(const ImageCatalog &) = delete;
+
+    // Render thread
+    void publish(std::vector<CatalogImage> images);
+
+    std::shared_ptr<const Snapshot> snapshot() const;
+
+    // {"generation", "total", "offset", "images": [{"id", "name", "width", "height", "thumb"}]}
+    nlohmann::json page(size_t offset, size_t limit, int thumbnailWidth) const;
+
+    // Nullptr when the id is unknown or the file cannot be decoded
+    std::shared_ptr<const CatalogThumbnail> thumbnail(size_t id, int width);
+
+    // Requested widths are rounded up to one of the cached sizes
+    static int thumbnailWidth(int requested);
+
+    CatalogStats statistics() const;
+
+private:
+    using ThumbnailPtr = std::shared_ptr<const CatalogThumbnail>;
+
+    struct Entry
+    {
+        ThumbnailPtr thumbnail;
+        std::list<std::string>::iterator use;
+    };
+
+    ThumbnailPtr encode(const CatalogImage &image, int width) const;
+    void store(const std::string &key, ThumbnailPtr thumbnail);
+
+    size_t budgetBytes;
+    int quality;
+
+    mutable std::mutex snapshotMutex;
+    std::shared_ptr<const Snapshot> current = std::make_shared<Snapshot>();
+
+    mutable std::mutex cacheMutex;
+    std::unordered_map<std::string, Entry> entries;              // path#revision@width
+    std::list<std::string> uses;                                 // Most recently used first
+    std::unordered_map<std::string, std::shared_future<ThumbnailPtr>> encoding; // Requests for the same key wait for one encode
+    size_t cachedBytes = 0;
+    uint64_t hitCount = 0;
+    uint64_t missCount = 0;
+};
@@ -0,0 +1,229 @@
+#include "image_decode_pool.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+DecodedImage ImageDecodePool::decodeFile(const std::string &path)
+{
+    DecodedImage image;
+
+    int channels;
+    unsigned char *data = stbi_load(path.c_str(), &image.width, &image.height, &channels, STBI_rgb_alpha);
+    image.pixels = {data, stbi_image_free};
+    image.sourceWidth = image.width;
+    image.sourceHeight = image.height;
+
+    return image;
+}
+
+ImageDecodePool::ImageDecodePool(DecodeFunction decode, unsigned int threadCount)
+    : decode(std::move(decode))
+{
+    if (threadCount == 0)
+    {
+        // Leave one core for the render thread
+        unsigned int cores = std::thread::hardware_concurrency();
+        threadCount = cores > 1 ? cores - 1 : 1;
+    }
+
+    for (unsigned int i = 0; i < threadCount; ++i)
+    {
+        workers.emplace_back(&ImageDecodePool::workerLoop, this);
+    }
+}
+
+ImageDecodePool::~ImageDecodePool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+
+    jobAvailable.notify_all();
+
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+}
+
+void ImageDecodePool::submit(int id, const std::string &path)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto queued = pending.emplace(id, Job{id, path});
+        if (!queued.second)
+        {
+            queued.first->second.path = path; // Already queued, a renamed file keeps its place
+            return;
+        }
+        backgroundQueue.push_back(id);
+    }
+
+    jobAvailable.notify_one();
+}
+
+void ImageDecodePool::prioritize(int id)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (pending.count(id) != 0)
+    {
+        urgentQueue.push_back(id);
+    }
+}
+
+void ImageDecodePool::cancelAll()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    pending.clear();
+    backgroundQueue.clear();
+    urgentQueue.clear();
+    currentGeneration++;
+
+    // Results of the previous generation are useless now
+    std::lock_guard<std::mutex> resultLock(resultMutex);
+    results.clear();
+}
+
+void ImageDecodePool::remap(const std::vector<int> &newIds)
+{
+    auto mapped = [&newIds](int id)
+    {
+        return id >= 0 && id < static_cast<int>(newIds.size()) ? newIds[id] : id;
+    };
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    std::unordered_map<int, Job> remapped;
+    for (auto &entry : pending)
+    {
+        int id = mapped(entry.first);
+        if (id >= 0)
+        {
+            entry.second.id = id;
+            remapped.emplace(id, std::move(entry.second));
+        }
+    }
+    pending.swap(remapped);
+
+    // Dropped ids stay in the queues as -1, which takeJob() skips as stale
+    for (int &id : backgroundQueue)
+    {
+        id = mapped(id);
+    }
+
+    for (int &id : urgentQueue)
+    {
+        id = mapped(id);
+    }
+
+    for (auto &job : running)
+    {
+        job.second = mapped(job.second);
+    }
+
+    std::lock_guard<std::mutex> resultLock(resultMutex);
+    for (auto result = results.begin(); result != results.end();)
+    {
+        result->id = mapped(result->id);
+        result = result->id >= 0 ? result + 1 : results.erase(result);
+    }
+}
+
+bool ImageDecodePool::popResult(DecodedImage &result)
+{
+    std::lock_guard<std::mutex> lock(resultMutex);
+    if (results.empty())
+    {
+        return false;
+    }
+
+    result = std::move(results.front());
+    results.pop_front();
+    return true;
+}
+
+size_t ImageDecodePool::pendingCount()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return pending.size();
+}
+
+bool ImageDecodePool::takeJob(Job &job)
+{
+    // Stale ids (already taken or cancelled) are skipped in both queues
+    while (!urgentQueue.empty())
+    {
+        int id = urgentQueue.back();
+        urgentQueue.pop_back();
+
+        auto it = pending.find(id);
+        if (it != pending.end())
+        {
+            job = std::move(it->second);
+            pending.erase(it);
+            return true;
+        }
+    }
+
+    while (!backgroundQueue.empty())
+    {
+        int id = backgroundQueue.front();
+        backgroundQueue.pop_front();
+
+        auto it = pending.find(id);
+        if (it != pending.end())
+        {
+            job = std::move(it->second);
+            pending.erase(it);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ImageDecodePool::workerLoop()
+{
+    while (true)
+    {
+        Job job;
+        unsigned int generation;
+        uint64_t ticket;
+
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            jobAvailable.wait(lock, [this]
+                              { return stopping || !pending.empty(); });
+
+            if (stopping)
+            {
+                return;
+            }
+
+            if (!takeJob(job))
+            {
+                continue;
+            }
+
+            generation = currentGeneration.load();
+            ticket = nextTicket++;
+            running[ticket] = job.id;
+        }
+
+        DecodedImage result = decode(job.path);
+        result.generation = generation;
+
+        // The id may have been remapped while decoding, both locks so a remap sees the result in one place
+        std::lock_guard<std::mutex> lock(mutex);
+        auto entry = running.find(ticket);
+        result.id = entry->second;
+        running.erase(entry);
+
+        std::lock_guard<std::mutex> resultLock(resultMutex);
+        if (result.id >= 0 && generation == currentGeneration.load())
+        {
+            results.push_back(std::move(result));
+        }
+    }
+}
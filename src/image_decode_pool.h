@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Pixels produced by a decode job, always RGBA8
+struct DecodedImage
+{
+    int id = -1;
+    unsigned int generation = 0;
+    int width = 0;
+    int height = 0;
+    int sourceWidth = 0; // Size of the file before any scaling
+    int sourceHeight = 0;
+    std::unique_ptr<unsigned char, void (*)(void *)> pixels{nullptr, std::free};
+
+    bool failed() const { return pixels == nullptr; }
+};
+
+// Decodes image files on worker threads so the render thread only uploads.
+// Jobs requested through prioritize() are served before the background queue.
+class ImageDecodePool
+{
+public:
+    using DecodeFunction = std::function<DecodedImage(const std::string &path)>;
+
+    // Decodes the full image at its original size
+    static DecodedImage decodeFile(const std::string &path);
+
+    explicit ImageDecodePool(DecodeFunction decode = decodeFile, unsigned int threadCount = 0);
+    ~ImageDecodePool();
+
+    ImageDecodePool(const ImageDecodePool &) = delete;
+    ImageDecodePool &operator=(const ImageDecodePool &) = delete;
+
+    void submit(int id, const std::string &path);
+    void prioritize(int id);
+    void cancelAll();
+
+    // Renumbers queued, running and finished jobs after the owner compacted
+    // its list: newIds[id] is the new id, or -1 to drop the job
+    void remap(const std::vector<int> &newIds);
+
+    bool popResult(DecodedImage &result);
+
+    unsigned int generation() const { return currentGeneration.load(); }
+    size_t pendingCount();
+    unsigned int threadCount() const { return static_cast<unsigned int>(workers.size()); }
+
+private:
+    struct Job
+    {
+        int id;
+        std::string path;
+    };
+
+    void workerLoop();
+    bool takeJob(Job &job);
+
+    DecodeFunction decode;
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable jobAvailable;
+    bool stopping = false;
+
+    std::unordered_map<int, Job> pending; // id -> job not yet taken by a worker
+    std::deque<int> backgroundQueue;      // FIFO in submit order
+    std::vector<int> urgentQueue;         // LIFO, most recently visible first
+    std::unordered_map<uint64_t, int> running; // Ticket of a job being decoded -> its current id
+    uint64_t nextTicket = 0;
+
+    std::mutex resultMutex;
+    std::deque<DecodedImage> results;
+
+    std::atomic<unsigned int> currentGeneration{0};
+};
@@ -0,0 +1,85 @@
+#include "image_grid.h"
+
+#include <algorithm>
+
+ImageGridResult ImageGrid(const std::vector<ImageEntry> &images, const ImVec2 &cellSize, float paddingBetweenImages)
+{
+    ImageGridResult result;
+
+    int imageCount = static_cast<int>(images.size());
+    if (imageCount == 0)
+    {
+        return result;
+    }
+
+    float windowWidth = ImGui::GetContentRegionAvail().x;
+
+    // Calculate the total width used by each image, including padding
+    float totalCellWidth = cellSize.x + paddingBetweenImages;
+
+    // Adjust calculation for imagesPerRow to include padding, subtracting 1 padding since there's no padding after the last image in a row
+    int imagesPerRow = (std::max)(1, static_cast<int>((windowWidth + paddingBetweenImages) / totalCellWidth));
+    int rowCount = (imageCount + imagesPerRow - 1) / imagesPerRow;
+
+    // Every row advances the cursor by the cell height plus the item spacing
+    float rowHeight = cellSize.y + ImGui::GetStyle().ItemSpacing.y;
+
+    ImDrawList *drawList = ImGui::GetWindowDrawList();
+
+    ImGuiListClipper clipper;
+    clipper.Begin(rowCount, rowHeight);
+
+    while (clipper.Step())
+    {
+        for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row)
+        {
+            ImVec2 rowPos = ImGui::GetCursorScreenPos();
+
+            int first = row * imagesPerRow;
+            int last = (std::min)(first + imagesPerRow, imageCount);
+
+            for (int i = first; i < last; ++i)
+            {
+                const ImageEntry &image = images[i];
+                bool isReady = image.state == ImageState::Ready;
+
+                // Calculate the aspect ratio and size of the image to fit in the cell, pending images fill the cell
+                float aspectRatio = isReady ? static_cast<float>(image.texture.width) / image.texture.height : cellSize.x / cellSize.y;
+                ImVec2 imageSize = (aspectRatio > 1.0f) ? ImVec2(cellSize.x, cellSize.x / aspectRatio) : ImVec2(cellSize.y * aspectRatio, cellSize.y);
+
+                // Cell's top-left corner and the image centered inside it
+                ImVec2 cellPos(rowPos.x + (i - first) * totalCellWidth, rowPos.y);
+                ImVec2 cellMax(cellPos.x + cellSize.x, cellPos.y + cellSize.y);
+
+                ImGui::SetCursorScreenPos(ImVec2(cellPos.x + (cellSize.x - imageSize.x) / 2.0f, cellPos.y + (cellSize.y - imageSize.y) / 2.0f));
+
+                if (isReady)
+                {
+                    ImGui::Image((void *)(intptr_t)image.texture.textureID, imageSize);
+
+                    if (ImGui::IsItemHovered() && ImGui::IsMouseDoubleClicked(0))
+                    {
+                        result.activated = i;
+                    }
+                }
+                else if (image.state != ImageState::Failed)
+                {
+                    // Placeholder while the image is decoded
+                    drawList->AddRectFilled(cellPos, cellMax, IM_COL32(255, 255, 255, 24));
+                }
+
+                // Draw rectangle around the cell
+                drawList->AddRect(cellPos, cellMax, IM_COL32(255, 255, 255, 255));
+            }
+
+            // Advance the layout by exactly one row
+            ImGui::SetCursorScreenPos(rowPos);
+            ImGui::Dummy(ImVec2(windowWidth, cellSize.y));
+
+            result.firstVisible = result.firstVisible < 0 ? first : (std::min)(result.firstVisible, first);
+            result.lastVisible = (std::max)(result.lastVisible, last - 1);
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <vector>
+
+#include "imgui.h"
+
+#include "image_library.h"
+
+struct ImageGridResult
+{
+    int firstVisible = -1; // Range of cells built this frame, -1 when none
+    int lastVisible = -1;
+    int activated = -1; // Cell double clicked this frame
+};
+
+// Virtualized grid of fixed-size cells: only rows inside the scroll view are
+// built, so the per-frame cost depends on the visible cells, not on the catalog.
+ImageGridResult ImageGrid(const std::vector<ImageEntry> &images, const ImVec2 &cellSize, float paddingBetweenImages);
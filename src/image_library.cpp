@@ -0,0 +1,525 @@
+#include "image_library.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <unordered_set>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    double elapsedMs(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+ImageLibrary::ImageLibrary(TextureManager &textures, const std::string &thumbnailDir, int thumbnailWidth, int thumbnailHeight, ImageDecodePool::DecodeFunction decodeThumbnail)
+    : textures(textures),
+      thumbnails(thumbnailDir, thumbnailWidth, thumbnailHeight),
+      pool(decodeThumbnail ? decodeThumbnail : [this](const std::string &path)
+           { return thumbnails.load(path); }),
+      fullPool(ImageDecodePool::decodeFile, 1)
+{
+}
+
+ImageLibrary::~ImageLibrary()
+{
+    clear();
+}
+
+void ImageLibrary::open(const std::string &folder)
+{
+    clear();
+    this->folder = folder;
+
+    if (!fs::is_directory(folder))
+    {
+        return;
+    }
+
+    for (const auto &entry : fs::directory_iterator(folder))
+    {
+        if (entry.is_regular_file())
+        {
+            ImageEntry image;
+            image.path = entry.path().string();
+            imageByPath[image.path] = images.size();
+            images.push_back(image);
+        }
+    }
+
+    prioritized.assign(images.size(), false);
+    settled.assign(images.size(), false);
+    pendingImages = images.size();
+    catalogChanges++;
+
+    openStart = std::chrono::steady_clock::now();
+    thumbnails.resetCounters();
+
+    for (size_t i = 0; i < images.size(); ++i)
+    {
+        submitThumbnail(i);
+    }
+}
+
+void ImageLibrary::submitThumbnail(size_t index)
+{
+    pool.submit(static_cast<int>(index), images[index].path);
+    thumbnailJobs++;
+}
+
+size_t ImageLibrary::findImage(const std::string &path) const
+{
+    auto image = imageByPath.find(path);
+    return image != imageByPath.end() ? image->second : images.size();
+}
+
+void ImageLibrary::applyChanges(const std::vector<FolderChange> &changes)
+{
+    // Removals first, so the indices of the queued jobs are renumbered once per batch
+    std::vector<size_t> removed;
+
+    for (const FolderChange &change : changes)
+    {
+        if (change.type == FolderChangeType::Rescan)
+        {
+            rescan();
+            return;
+        }
+
+        if (change.type == FolderChangeType::Removed)
+        {
+            size_t index = findImage(change.path);
+            if (index < images.size())
+            {
+                removed.push_back(index);
+            }
+        }
+    }
+
+    removeImages(removed);
+
+    for (const FolderChange &change : changes)
+    {
+        if (change.type == FolderChangeType::Renamed)
+        {
+            renameImage(change.oldPath, change.path);
+        }
+        else if (change.type == FolderChangeType::Added || change.type == FolderChangeType::Modified)
+        {
+            addImage(change.path);
+        }
+    }
+}
+
+void ImageLibrary::addImage(const std::string &path)
+{
+    if (pendingImages == 0)
+    {
+        openStart = std::chrono::steady_clock::now();
+    }
+
+    size_t index = findImage(path);
+
+    if (index == images.size())
+    {
+        ImageEntry image;
+        image.path = path;
+        imageByPath[path] = index;
+        images.push_back(image);
+        prioritized.push_back(false);
+        settled.push_back(false);
+        pendingImages++;
+    }
+    else
+    {
+        // New content, the old thumbnail stays on screen until the new one is uploaded
+        ImageEntry &image = images[index];
+        image.revision++;
+
+        if (image.state != ImageState::Ready)
+        {
+            image.state = ImageState::Pending;
+        }
+
+        if (settled[index])
+        {
+            settled[index] = false;
+            pendingImages++;
+        }
+
+        prioritized[index] = false;
+    }
+
+    catalogChanges++;
+    submitThumbnail(index);
+}
+
+void ImageLibrary::renameImage(const std::string &oldPath, const std::string &newPath)
+{
+    // Moved over an existing file, which goes away
+    size_t target = findImage(newPath);
+    if (target < images.size())
+    {
+        removeImages({target});
+    }
+
+    size_t index = findImage(oldPath);
+    if (index == images.size())
+    {
+        addImage(newPath);
+        return;
+    }
+
+    // Same content, the thumbnail is kept
+    imageByPath.erase(oldPath);
+    imageByPath[newPath] = index;
+    images[index].path = newPath;
+    catalogChanges++;
+
+    // A queued job reads the file under its new name
+    if (!settled[index] || images[index].state == ImageState::Pending)
+    {
+        submitThumbnail(index);
+    }
+}
+
+void ImageLibrary::removeImages(std::vector<size_t> indices)
+{
+    if (indices.empty())
+    {
+        return;
+    }
+
+    std::vector<bool> removed(images.size(), false);
+    for (size_t index : indices)
+    {
+        removed[index] = true;
+    }
+
+    if (thumbnailUpload.active && removed[thumbnailUpload.image.id])
+    {
+        cancelUpload(thumbnailUpload);
+    }
+
+    // Compacts the catalog, the remaining entries keep their order and textures
+    std::vector<size_t> newIndex(images.size(), 0);
+    std::vector<int> newIds(images.size(), -1);
+    size_t kept = 0;
+
+    for (size_t i = 0; i < images.size(); ++i)
+    {
+        if (removed[i])
+        {
+            textures.release(images[i].textureKey);
+            if (!settled[i])
+            {
+                pendingImages--;
+            }
+            continue;
+        }
+
+        newIndex[i] = kept;
+        newIds[i] = static_cast<int>(kept);
+        images[kept] = std::move(images[i]);
+        prioritized[kept] = prioritized[i];
+        settled[kept] = settled[i];
+        kept++;
+    }
+
+    images.resize(kept);
+    prioritized.resize(kept);
+    settled.resize(kept);
+
+    if (thumbnailUpload.active)
+    {
+        thumbnailUpload.image.id = static_cast<int>(newIndex[thumbnailUpload.image.id]);
+    }
+
+    imageByKey.clear();
+    imageByPath.clear();
+
+    for (size_t i = 0; i < images.size(); ++i)
+    {
+        if (images[i].textureKey != 0)
+        {
+            imageByKey[images[i].textureKey] = i;
+        }
+
+        imageByPath[images[i].path] = i;
+    }
+
+    // Queued, running and finished jobs carry the old indices, nothing is decoded again
+    pool.remap(newIds);
+
+    catalogChanges++;
+}
+
+void ImageLibrary::rescan()
+{
+    // Events were lost, the listing is compared instead. Content changes in
+    // that window are not detected.
+    std::vector<std::string> files;
+    std::error_code error;
+
+    for (const auto &entry : fs::directory_iterator(folder, error))
+    {
+        if (entry.is_regular_file(error))
+        {
+            files.push_back(entry.path().string());
+        }
+    }
+
+    std::unordered_set<std::string> present(files.begin(), files.end());
+    std::vector<size_t> removed;
+
+    for (size_t i = 0; i < images.size(); ++i)
+    {
+        if (present.count(images[i].path) == 0)
+        {
+            removed.push_back(i);
+        }
+    }
+
+    removeImages(removed);
+
+    for (const std::string &file : files)
+    {
+        if (findImage(file) == images.size())
+        {
+            addImage(file);
+        }
+    }
+}
+
+void ImageLibrary::clear()
+{
+    pool.cancelAll();
+    fullPool.cancelAll();
+
+    for (auto &image : images)
+    {
+        textures.release(image.textureKey);
+    }
+
+    cancelUpload(thumbnailUpload);
+    cancelUpload(selectedUpload);
+
+    textures.release(selectedKey);
+    selectedKey = 0;
+    selected = {0, 0, 0};
+
+    images.clear();
+    prioritized.clear();
+    settled.clear();
+    imageByKey.clear();
+    imageByPath.clear();
+    pendingImages = 0;
+    catalogChanges++;
+}
+
+void ImageLibrary::requestVisible(size_t index)
+{
+    if (index >= images.size())
+    {
+        return;
+    }
+
+    ImageEntry &image = images[index];
+
+    if (image.state == ImageState::Ready)
+    {
+        textures.touch(image.textureKey);
+        return;
+    }
+
+    if (image.state == ImageState::Evicted)
+    {
+        // Scrolled back into view, the thumbnail cache makes this cheap
+        image.state = ImageState::Pending;
+        prioritized[index] = false;
+        submitThumbnail(index);
+    }
+
+    if (image.state == ImageState::Pending && !prioritized[index])
+    {
+        prioritized[index] = true;
+        pool.prioritize(static_cast<int>(index));
+    }
+}
+
+void ImageLibrary::selectImage(size_t index)
+{
+    if (index >= images.size())
+    {
+        return;
+    }
+
+    // Drop a previous selection still in flight
+    fullPool.cancelAll();
+    cancelUpload(selectedUpload);
+
+    fullPool.submit(static_cast<int>(index), images[index].path);
+}
+
+bool ImageLibrary::beginUpload(PendingUpload &upload, ImageDecodePool &source)
+{
+    DecodedImage image;
+    while (source.popResult(image))
+    {
+        if (image.generation != source.generation() || image.id < 0 || image.id >= static_cast<int>(images.size()))
+        {
+            continue;
+        }
+
+        if (image.failed())
+        {
+            std::cerr << "Error loading image: " << images[image.id].path << std::endl;
+
+            if (&source == &pool)
+            {
+                images[image.id].state = ImageState::Failed;
+                imageSettled(image.id);
+            }
+            continue;
+        }
+
+        // Allocate storage now, pixels are streamed in row strips by uploadRows.
+        // Not evictable until complete, the grid does not draw it before that.
+        upload.textureKey = textures.create(image.width, image.height, false);
+        upload.image = std::move(image);
+        upload.uploadedRows = 0;
+        upload.active = true;
+        return true;
+    }
+
+    return false;
+}
+
+bool ImageLibrary::uploadRows(PendingUpload &upload, double budgetMs, std::chrono::steady_clock::time_point start)
+{
+    return uploader.upload(textures.texture(upload.textureKey), upload.image, upload.uploadedRows, budgetMs, start);
+}
+
+void ImageLibrary::cancelUpload(PendingUpload &upload)
+{
+    textures.release(upload.textureKey);
+    upload = PendingUpload();
+}
+
+void ImageLibrary::finishThumbnail()
+{
+    const DecodedImage &image = thumbnailUpload.image;
+    ImageEntry &entry = images[image.id];
+
+    if (entry.textureKey != 0)
+    {
+        imageByKey.erase(entry.textureKey);
+        textures.release(entry.textureKey);
+    }
+
+    entry.textureKey = thumbnailUpload.textureKey;
+    entry.texture = {textures.texture(entry.textureKey), image.width, image.height};
+    entry.sourceWidth = image.sourceWidth;
+    entry.sourceHeight = image.sourceHeight;
+    entry.state = ImageState::Ready;
+
+    textures.setEvictable(entry.textureKey, true);
+    imageByKey[entry.textureKey] = image.id;
+
+    size_t index = image.id;
+    thumbnailUpload = PendingUpload();
+
+    imageSettled(index);
+}
+
+void ImageLibrary::imageSettled(size_t index)
+{
+    // Reloads after an eviction do not count towards the folder open time
+    if (settled[index])
+    {
+        return;
+    }
+
+    settled[index] = true;
+    pendingImages--;
+    catalogChanges++; // The source size is known now
+
+    if (pendingImages == 0)
+    {
+        lastOpenTime = elapsedMs(openStart);
+        std::cout << "Loaded " << images.size() << " images in " << lastOpenTime << " ms (thumbnail cache: " << thumbnails.hits() << " hits, " << thumbnails.misses() << " misses, " << residentBytes() / 1024 << " KB resident)." << std::endl;
+    }
+}
+
+void ImageLibrary::finishSelected()
+{
+    const DecodedImage &image = selectedUpload.image;
+
+    textures.release(selectedKey);
+
+    selectedKey = selectedUpload.textureKey;
+    selected = {textures.texture(selectedKey), image.width, image.height};
+
+    selectedUpload = PendingUpload();
+}
+
+void ImageLibrary::evictTextures()
+{
+    evicted.clear();
+    textures.evictToBudget(evicted);
+
+    for (TextureKey key : evicted)
+    {
+        auto it = imageByKey.find(key);
+        if (it == imageByKey.end())
+        {
+            continue;
+        }
+
+        ImageEntry &entry = images[it->second];
+        entry.textureKey = 0;
+        entry.texture.textureID = 0;
+        entry.state = ImageState::Evicted;
+
+        imageByKey.erase(it);
+    }
+}
+
+double ImageLibrary::processUploads(double budgetMs)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    textures.beginFrame();
+
+    // The projector is waiting on the selected image, so it goes first
+    if (selectedUpload.active || beginUpload(selectedUpload, fullPool))
+    {
+        if (uploadRows(selectedUpload, budgetMs, start))
+        {
+            finishSelected();
+        }
+    }
+
+    while (elapsedMs(start) < budgetMs)
+    {
+        if (!thumbnailUpload.active && !beginUpload(thumbnailUpload, pool))
+        {
+            break;
+        }
+
+        if (uploadRows(thumbnailUpload, budgetMs, start))
+        {
+            finishThumbnail();
+        }
+    }
+
+    evictTextures();
+
+    lastUploadTime = elapsedMs(start);
+    maxUploadTime = (std::max)(maxUploadTime, lastUploadTime);
+
+    return lastUploadTime;
+}
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "opengl.h"
+
+#include "folder_watcher.h"
+#include "image_decode_pool.h"
+#include "row_uploader.h"
+#include "texture_manager.h"
+#include "thumbnail_cache.h"
+
+struct ImageTexture
+{
+    GLuint textureID;
+    int width, height;
+};
+
+enum class ImageState
+{
+    Pending,
+    Ready,
+    Evicted, // Texture dropped by the budget, reloaded when visible again
+    Failed
+};
+
+struct ImageEntry
+{
+    std::string path;
+    ImageTexture texture = {0, 0, 0}; // Cell-sized thumbnail
+    TextureKey textureKey = 0;
+    int sourceWidth = 0;
+    int sourceHeight = 0;
+    ImageState state = ImageState::Pending;
+    uint64_t revision = 0; // Counts changes to the file under the same name
+};
+
+// Image catalog of a project folder. The grid shows cached thumbnails, the
+// selected image is decoded at full size for the projector. Pixels are decoded
+// by worker pools and uploaded by the render thread in row strips under a
+// per-frame time budget. Textures live in the TextureManager, which may evict
+// thumbnails that are off screen.
+class ImageLibrary
+{
+public:
+    // Grid cells come from the thumbnail cache unless another decode function is given
+    ImageLibrary(TextureManager &textures, const std::string &thumbnailDir, int thumbnailWidth, int thumbnailHeight, ImageDecodePool::DecodeFunction decodeThumbnail = nullptr);
+    ~ImageLibrary();
+
+    ImageLibrary(const ImageLibrary &) = delete;
+    ImageLibrary &operator=(const ImageLibrary &) = delete;
+
+    void open(const std::string &folder);
+    void clear();
+
+    // Applies a batch of the folder watcher, only added or modified files are
+    // decoded and the other entries keep their thumbnails
+    void applyChanges(const std::vector<FolderChange> &changes);
+
+    // Called by the grid for cells currently on screen
+    void requestVisible(size_t index);
+
+    // Loads the full resolution image shown by the projector
+    void selectImage(size_t index);
+    const ImageTexture &selectedImage() const { return selected; }
+
+    // Uploads decoded pixels until the budget is spent, returns the time used
+    double processUploads(double budgetMs);
+
+    const std::vector<ImageEntry> &entries() const { return images; }
+    bool empty() const { return images.empty(); }
+    size_t size() const { return images.size(); }
+    size_t pendingCount() const { return pendingImages; }
+
+    // Changes when the list of images or the size of one of them changes
+    uint64_t catalogVersion() const { return catalogChanges; }
+
+    double lastUploadMs() const { return lastUploadTime; }
+    double maxUploadMs() const { return maxUploadTime; }
+    double maxStripMs() const { return uploader.maxStripMs(); } // Longest single row strip, how far a call may overrun its budget
+    double lastOpenMs() const { return lastOpenTime; }
+    uint64_t thumbnailRequests() const { return thumbnailJobs; } // Jobs given to the decode pool
+    size_t residentBytes() const { return textures.statistics().residentBytes; }
+
+    const ThumbnailCache &thumbnailCache() const { return thumbnails; }
+
+private:
+    struct PendingUpload
+    {
+        DecodedImage image;
+        TextureKey textureKey = 0;
+        int uploadedRows = 0;
+        bool active = false;
+    };
+
+    bool beginUpload(PendingUpload &upload, ImageDecodePool &source);
+    bool uploadRows(PendingUpload &upload, double budgetMs, std::chrono::steady_clock::time_point start);
+    void cancelUpload(PendingUpload &upload);
+    void finishThumbnail();
+    void finishSelected();
+    void imageSettled(size_t index);
+    void evictTextures();
+
+    size_t findImage(const std::string &path) const;
+    void addImage(const std::string &path);
+    void renameImage(const std::string &oldPath, const std::string &newPath);
+    void removeImages(std::vector<size_t> indices);
+    void rescan();
+    void submitThumbnail(size_t index);
+
+    TextureManager &textures;
+    ThumbnailCache thumbnails;
+    ImageDecodePool pool;
+    ImageDecodePool fullPool;
+
+    std::string folder;
+    std::vector<ImageEntry> images;
+    std::vector<bool> prioritized;
+    std::vector<bool> settled; // Loaded or failed at least once since open()
+    std::unordered_map<TextureKey, size_t> imageByKey;
+    std::unordered_map<std::string, size_t> imageByPath;
+    size_t pendingImages = 0;
+    uint64_t catalogChanges = 0;
+    uint64_t thumbnailJobs = 0;
+
+    ImageTexture selected = {0, 0, 0};
+    TextureKey selectedKey = 0;
+
+    // Images being uploaded, each may span several frames
+    PendingUpload thumbnailUpload;
+    PendingUpload selectedUpload;
+
+    RowUploader uploader;
+
+    std::vector<TextureKey> evicted;
+    std::chrono::steady_clock::time_point openStart;
+
+    double lastUploadTime = 0.0;
+    double maxUploadTime = 0.0;
+    double lastOpenTime = 0.0;
+};
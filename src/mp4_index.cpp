@@ -0,0 +1,257 @@
+#include "mp4_index.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace
+{
+    const uint64_t maxSamples = 10000000;
+
+    // Boxes are big endian, a 32-bit size followed by a four character type
+    struct Box
+    {
+        char type[5] = {};
+        const unsigned char *data = nullptr; // Payload after the header
+        uint64_t size = 0;                   // Payload size
+    };
+
+    uint32_t readU32(const unsigned char *p)
+    {
+        return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+    }
+
+    uint64_t readU64(const unsigned char *p)
+    {
+        return (uint64_t(readU32(p)) << 32) | readU32(p + 4);
+    }
+
+    // Walks the boxes of a payload, stops at the first malformed header
+    template <typename Visitor>
+    void forEachBox(const unsigned char *data, uint64_t size, Visitor visit)
+    {
+        uint64_t offset = 0;
+
+        while (offset + 8 <= size)
+        {
+            uint64_t boxSize = readU32(data + offset);
+            uint64_t headerSize = 8;
+
+            if (boxSize == 1)
+            {
+                if (offset + 16 > size)
+                {
+                    return;
+                }
+
+                boxSize = readU64(data + offset + 8);
+                headerSize = 16;
+            }
+            else if (boxSize == 0)
+            {
+                boxSize = size - offset;
+            }
+
+            if (boxSize < headerSize || boxSize > size - offset)
+            {
+                return;
+            }
+
+            Box box;
+            std::memcpy(box.type, data + offset + 4, 4);
+            box.data = data + offset + headerSize;
+            box.size = boxSize - headerSize;
+
+            if (!visit(box))
+            {
+                return;
+            }
+
+            offset += boxSize;
+        }
+    }
+
+    bool findBox(const unsigned char *data, uint64_t size, const char *type, Box &found)
+    {
+        bool result = false;
+
+        forEachBox(data, size, [&](const Box &box)
+                   {
+            if (std::strcmp(box.type, type) == 0)
+            {
+                found = box;
+                result = true;
+                return false;
+            }
+            return true; });
+
+        return result;
+    }
+
+    // Reads the top level moov box, skipping media data without loading it
+    bool readMovieBox(const std::string &path, std::vector<unsigned char> &movie)
+    {
+        std::ifstream file(path, std::ios::binary);
+        unsigned char header[16];
+
+        while (file.read(reinterpret_cast<char *>(header), 8))
+        {
+            uint64_t boxSize = readU32(header);
+            uint64_t headerSize = 8;
+
+            if (boxSize == 1)
+            {
+                if (!file.read(reinterpret_cast<char *>(header + 8), 8))
+                {
+                    return false;
+                }
+
+                boxSize = readU64(header + 8);
+                headerSize = 16;
+            }
+
+            if (std::memcmp(header + 4, "moov", 4) == 0)
+            {
+                if (boxSize < headerSize || boxSize - headerSize > 64ull * 1024 * 1024)
+                {
+                    return false;
+                }
+
+                movie.resize(static_cast<size_t>(boxSize - headerSize));
+                return static_cast<bool>(file.read(reinterpret_cast<char *>(movie.data()), static_cast<std::streamsize>(movie.size())));
+            }
+
+            if (boxSize < headerSize)
+            {
+                return false; // Size zero means the box runs to the end of the file
+            }
+
+            file.seekg(static_cast<std::streamoff>(boxSize - headerSize), std::ios::cur);
+        }
+
+        return false;
+    }
+}
+
+bool KeyframeIndex::load(const std::string &path)
+{
+    clear();
+
+    std::vector<unsigned char> movie;
+    if (!readMovieBox(path, movie))
+    {
+        return false;
+    }
+
+    bool found = false;
+
+    forEachBox(movie.data(), movie.size(), [&](const Box &track)
+               {
+        if (std::strcmp(track.type, "trak") != 0)
+        {
+            return true;
+        }
+
+        Box media, handler, header, info, table;
+        if (!findBox(track.data, track.size, "mdia", media) ||
+            !findBox(media.data, media.size, "hdlr", handler) || handler.size < 12 || std::memcmp(handler.data + 8, "vide", 4) != 0 ||
+            !findBox(media.data, media.size, "mdhd", header) || header.size < 24 ||
+            !findBox(media.data, media.size, "minf", info) ||
+            !findBox(info.data, info.size, "stbl", table))
+        {
+            return true;
+        }
+
+        // mdhd version 1 uses 64-bit creation and modification times
+        uint32_t timescale = header.data[0] == 1 ? (header.size >= 36 ? readU32(header.data + 20) : 0) : readU32(header.data + 12);
+        if (timescale == 0)
+        {
+            return true;
+        }
+
+        // Decode time of every sample from the run lengths in stts
+        Box timeToSample;
+        if (!findBox(table.data, table.size, "stts", timeToSample) || timeToSample.size < 8)
+        {
+            return true;
+        }
+
+        uint32_t runCount = readU32(timeToSample.data + 4);
+        if (timeToSample.size < 8 + uint64_t(runCount) * 8)
+        {
+            return true;
+        }
+
+        std::vector<uint64_t> sampleTimes;
+        uint64_t time = 0;
+
+        for (uint32_t i = 0; i < runCount; ++i)
+        {
+            uint32_t count = readU32(timeToSample.data + 8 + i * 8);
+            uint32_t delta = readU32(timeToSample.data + 12 + i * 8);
+
+            if (sampleTimes.size() + count > maxSamples)
+            {
+                return true; // Corrupt table
+            }
+
+            for (uint32_t j = 0; j < count; ++j)
+            {
+                sampleTimes.push_back(time);
+                time += delta;
+            }
+        }
+
+        samples = static_cast<int64_t>(sampleTimes.size());
+        duration = time * 1000.0 / timescale;
+
+        // Without stss every sample is a sync sample
+        Box syncSamples;
+        if (findBox(table.data, table.size, "stss", syncSamples) && syncSamples.size >= 8)
+        {
+            uint32_t count = readU32(syncSamples.data + 4);
+            count = static_cast<uint32_t>(std::min<uint64_t>(count, (syncSamples.size - 8) / 4));
+
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                uint32_t sample = readU32(syncSamples.data + 8 + i * 4);
+                if (sample >= 1 && sample <= sampleTimes.size())
+                {
+                    entries.push_back({sample - 1, sampleTimes[sample - 1] * 1000.0 / timescale});
+                }
+            }
+        }
+        else
+        {
+            for (size_t i = 0; i < sampleTimes.size(); ++i)
+            {
+                entries.push_back({static_cast<int64_t>(i), sampleTimes[i] * 1000.0 / timescale});
+            }
+        }
+
+        found = true;
+        return false; });
+
+    return found && !entries.empty();
+}
+
+void KeyframeIndex::clear()
+{
+    entries.clear();
+    samples = 0;
+    duration = 0.0;
+}
+
+const Keyframe *KeyframeIndex::nearest(double timeMs) const
+{
+    if (entries.empty())
+    {
+        return nullptr;
+    }
+
+    auto it = std::upper_bound(entries.begin(), entries.end(), timeMs, [](double time, const Keyframe &keyframe)
+                               { return time < keyframe.timeMs; });
+
+    return it == entries.begin() ? &entries.front() : &*std::prev(it);
+}
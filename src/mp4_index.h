@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct Keyframe
+{
+    int64_t frame = 0;   // Zero based sample number in decode order
+    double timeMs = 0.0; // Decode timestamp of the sample
+};
+
+// Sync samples of the first video track of an MP4/MOV file, read from the
+// stss and stts boxes without decoding anything. Seeks that land on one of
+// these frames start decoding right away instead of rolling forward from an
+// earlier keyframe.
+class KeyframeIndex
+{
+public:
+    // Returns false when the file is not an MP4 or has no video track
+    bool load(const std::string &path);
+    void clear();
+
+    // Last keyframe at or before the given time, nullptr when the index is empty
+    const Keyframe *nearest(double timeMs) const;
+
+    const std::vector<Keyframe> &keyframes() const { return entries; }
+    bool empty() const { return entries.empty(); }
+    int64_t frameCount() const { return samples; }
+    double durationMs() const { return duration; }
+
+private:
+    std::vector<Keyframe> entries;
+    int64_t samples = 0;
+    double duration = 0.0;
+};
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <utility>
+
+// Unbounded lock-free queue for many producers and one consumer. push() is
+// a single atomic exchange, so producers never wait for each other or for the
+// consumer. A push in progress may be missed by pop() until the producer
+// links its node, the consumer sees it on the next call.
+template <typename T>
+class MpscQueue
+{
+public:
+    MpscQueue() : head(&stub), tail(&stub) {}
+
+    ~MpscQueue()
+    {
+        T value;
+        while (pop(value))
+        {
+        }
+
+        // The last node popped stays behind as the new stub
+        if (tail != &stub)
+        {
+            delete tail;
+        }
+    }
+
+    MpscQueue(const MpscQueue &) = delete;
+    MpscQueue &operator=(const MpscQueue &) = delete;
+
+    // Any thread
+    void push(T value)
+    {
+        Node *node = new Node;
+        node->value = std::move(value);
+
+        Node *previous = head.exchange(node, std::memory_order_acq_rel);
+        previous->next.store(node, std::memory_order_release);
+    }
+
+    // Consumer thread only
+    bool pop(T &value)
+    {
+        Node *first = tail;
+        Node *next = first->next.load(std::memory_order_acquire);
+
+        if (next == nullptr)
+        {
+            return false;
+        }
+
+        // The popped node becomes the new empty head of the list
+        value = std::move(next->value);
+        next->value = T();
+        tail = next;
+
+        if (first != &stub)
+        {
+            delete first;
+        }
+
+        return true;
+    }
+
+private:
+    struct Node
+    {
+        std::atomic<Node *> next{nullptr};
+        T value;
+    };
+
+    Node stub;
+    std::atomic<Node *> head; // Last pushed node, producers
+    Node *tail;               // Last popped node, consumer
+};
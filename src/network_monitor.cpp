@@ -0,0 +1,216 @@
+#include "network_monitor.h"
+
+#include <chrono>
+
+#include <Poco/Exception.h>
+#include <Poco/Net/NetworkInterface.h>
+
+#if defined(__linux__)
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    // Without change notifications, and as a safety net with them
+    const std::chrono::seconds pollInterval(5);
+    const int fallbackRefreshMs = 30000;
+
+    // Bursts of link and address messages (e.g. DHCP) end in a single enumeration
+    const int settleMs = 250;
+}
+
+bool NetworkSnapshot::sameAddresses(const NetworkSnapshot &other) const
+{
+    return addresses == other.addresses && localAddress == other.localAddress;
+}
+
+NetworkMonitor::NetworkMonitor()
+    : current(std::make_shared<NetworkSnapshot>(NetworkSnapshot{0, {"127.0.0.1"}, "127.0.0.1"}))
+{
+#if defined(__linux__)
+    // Opened before the first enumeration, so no change can slip in between
+    netlinkSocket = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (netlinkSocket >= 0)
+    {
+        sockaddr_nl address = {};
+        address.nl_family = AF_NETLINK;
+        address.nl_groups = RTMGRP_LINK | RTMGRP_IPV4_IFADDR;
+
+        if (bind(netlinkSocket, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0)
+        {
+            close(netlinkSocket);
+            netlinkSocket = -1;
+        }
+    }
+
+    wakeEvent = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+#endif
+
+    thread = std::thread(&NetworkMonitor::run, this);
+}
+
+NetworkMonitor::~NetworkMonitor()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+
+    stopRequested.notify_all();
+
+#if defined(__linux__)
+    if (wakeEvent >= 0)
+    {
+        uint64_t one = 1;
+        ssize_t written = write(wakeEvent, &one, sizeof(one));
+        (void)written;
+    }
+#endif
+
+    thread.join();
+
+#if defined(__linux__)
+    if (netlinkSocket >= 0)
+    {
+        close(netlinkSocket);
+    }
+
+    if (wakeEvent >= 0)
+    {
+        close(wakeEvent);
+    }
+#endif
+}
+
+std::shared_ptr<const NetworkSnapshot> NetworkMonitor::snapshot() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return current;
+}
+
+uint64_t NetworkMonitor::enumerations() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return enumerationCount;
+}
+
+NetworkSnapshot NetworkMonitor::enumerate()
+{
+    NetworkSnapshot snapshot;
+
+    try
+    {
+        Poco::Net::NetworkInterface::Map map = Poco::Net::NetworkInterface::map();
+        for (const auto &m : map)
+        {
+            // Interfaces IPv4 ativas que não sejam loopback
+            if (m.second.isLoopback() || !m.second.supportsIPv4() || !m.second.isUp())
+            {
+                continue;
+            }
+
+            for (const auto &ipa : m.second.addressList())
+            {
+                if (ipa.get<0>().family() != Poco::Net::AddressFamily::IPv4)
+                {
+                    continue;
+                }
+
+                Poco::Net::IPAddress ip = ipa.get<0>();
+                if (ip.isLoopback() || !ip.isUnicast())
+                {
+                    continue;
+                }
+
+                snapshot.addresses.push_back(ip.toString());
+
+                if (snapshot.localAddress.empty() && !ip.isWildcard() && !ip.isBroadcast())
+                {
+                    snapshot.localAddress = ip.toString();
+                }
+            }
+        }
+    }
+    catch (const Poco::Exception &)
+    {
+        // Treated as no interface, the next change or poll tries again
+    }
+
+    // Inclui o loopback caso não encontre endereços externos
+    if (snapshot.addresses.empty())
+    {
+        snapshot.addresses.push_back("127.0.0.1");
+    }
+
+    if (snapshot.localAddress.empty())
+    {
+        snapshot.localAddress = "127.0.0.1";
+    }
+
+    return snapshot;
+}
+
+void NetworkMonitor::run()
+{
+    do
+    {
+        refresh();
+    } while (waitForChange());
+}
+
+void NetworkMonitor::refresh()
+{
+    auto next = std::make_shared<NetworkSnapshot>(enumerate());
+
+    std::lock_guard<std::mutex> lock(mutex);
+    enumerationCount++;
+
+    // Readers compare versions, an unchanged list keeps the old one
+    if (enumerationCount > 1 && next->sameAddresses(*current))
+    {
+        return;
+    }
+
+    next->version = current->version + 1;
+    current = std::move(next);
+}
+
+bool NetworkMonitor::waitForChange()
+{
+#if defined(__linux__)
+    if (netlinkSocket >= 0 && wakeEvent >= 0)
+    {
+        pollfd fds[2] = {{netlinkSocket, POLLIN, 0}, {wakeEvent, POLLIN, 0}};
+        int timeout = fallbackRefreshMs;
+
+        // Waits for the first message, then until the burst settles
+        while (poll(fds, 2, timeout) > 0)
+        {
+            if (fds[1].revents != 0)
+            {
+                return false;
+            }
+
+            char buffer[8192];
+            while (recv(netlinkSocket, buffer, sizeof(buffer), MSG_DONTWAIT) > 0)
+            {
+            }
+
+            timeout = settleMs;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        return running;
+    }
+#endif
+
+    std::unique_lock<std::mutex> lock(mutex);
+    stopRequested.wait_for(lock, pollInterval, [&]()
+                           { return !running; });
+    return running;
+}
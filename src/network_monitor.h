@@ -0,0 +1,60 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// IPv4 addresses the remote control can reach the server on
+struct NetworkSnapshot
+{
+    uint64_t version = 0;               // Changes only when the addresses change
+    std::vector<std::string> addresses; // Up, non loopback interfaces, 127.0.0.1 when there is none
+    std::string localAddress;           // First unicast, non broadcast address, 127.0.0.1 when there is none
+
+    bool sameAddresses(const NetworkSnapshot &other) const;
+};
+
+// Enumerates the network interfaces on its own thread and publishes an
+// immutable snapshot, so the UI never walks the interfaces itself. On Linux
+// the thread sleeps on a netlink socket and enumerates again only when a
+// link or an address changes, elsewhere it polls every few seconds.
+class NetworkMonitor
+{
+public:
+    NetworkMonitor();
+    ~NetworkMonitor();
+
+    NetworkMonitor(const NetworkMonitor &) = delete;
+    NetworkMonitor &operator=(const NetworkMonitor &) = delete;
+
+    // Any thread, never blocks on the enumeration
+    std::shared_ptr<const NetworkSnapshot> snapshot() const;
+
+    // Walks the interfaces on the calling thread
+    static NetworkSnapshot enumerate();
+
+    uint64_t enumerations() const;
+
+private:
+    void run();
+    void refresh();
+    bool waitForChange();
+
+    mutable std::mutex mutex;
+    std::shared_ptr<const NetworkSnapshot> current;
+    uint64_t enumerationCount = 0;
+
+    std::condition_variable stopRequested;
+    bool running = true;
+
+#if defined(__linux__)
+    int netlinkSocket = -1;
+    int wakeEvent = -1;
+#endif
+
+    std::thread thread;
+};
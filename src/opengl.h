@@ -0,0 +1,13 @@
+#pragma once
+
+// GLFW plus the core profile entry points past OpenGL 1.1 (buffers, sync
+// objects, shaders). Include this instead of GLFW/glfw3.h.
+#if defined(__APPLE__)
+#define GL_SILENCE_DEPRECATION
+#define GLFW_INCLUDE_GLCOREARB
+#else
+#define GL_GLEXT_PROTOTYPES
+#define GLFW_INCLUDE_GLEXT
+#endif
+
+#include <GLFW/glfw3.h>
@@ -0,0 +1,163 @@
+#include "preview_capture.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "backends/imgui_impl_opengl3.h"
+
+PreviewCapture::~PreviewCapture()
+{
+    release();
+}
+
+void PreviewCapture::allocate(int width, int height)
+{
+    release();
+
+    glGenTextures(1, &colorTexture);
+    glBindTexture(GL_TEXTURE_2D, colorTexture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    size_t bufferSize = static_cast<size_t>(width) * height * 4;
+
+    glGenBuffers(bufferCount, pixelBuffers);
+    for (GLuint buffer : pixelBuffers)
+    {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
+        glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(bufferSize), nullptr, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    captureWidth = width;
+    captureHeight = height;
+    nextBuffer = 0;
+}
+
+void PreviewCapture::release()
+{
+    for (int i = 0; i < bufferCount; ++i)
+    {
+        if (fences[i] != nullptr)
+        {
+            glDeleteSync(fences[i]);
+            fences[i] = nullptr;
+        }
+    }
+
+    if (pixelBuffers[0] != 0)
+    {
+        glDeleteBuffers(bufferCount, pixelBuffers);
+        std::memset(pixelBuffers, 0, sizeof(pixelBuffers));
+    }
+
+    if (framebuffer != 0)
+    {
+        glDeleteFramebuffers(1, &framebuffer);
+        framebuffer = 0;
+    }
+
+    if (colorTexture != 0)
+    {
+        glDeleteTextures(1, &colorTexture);
+        colorTexture = 0;
+    }
+
+    captureWidth = 0;
+    captureHeight = 0;
+}
+
+void PreviewCapture::collect(PreviewStream &stream)
+{
+    // Fences signal in submission order, only the newest finished readback is worth encoding
+    int newest = -1;
+
+    for (int i = 0; i < bufferCount; ++i)
+    {
+        int index = (nextBuffer + i) % bufferCount;
+        if (fences[index] == nullptr || glClientWaitSync(fences[index], 0, 0) == GL_TIMEOUT_EXPIRED)
+        {
+            continue;
+        }
+
+        glDeleteSync(fences[index]);
+        fences[index] = nullptr;
+        newest = index;
+    }
+
+    if (newest < 0)
+    {
+        return;
+    }
+
+    size_t bufferSize = static_cast<size_t>(captureWidth) * captureHeight * 4;
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pixelBuffers[newest]);
+    const void *mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, static_cast<GLsizeiptr>(bufferSize), GL_MAP_READ_BIT);
+
+    if (mapped != nullptr)
+    {
+        const auto *bytes = static_cast<const unsigned char *>(mapped);
+        stream.submit(std::vector<unsigned char>(bytes, bytes + bufferSize), captureWidth, captureHeight);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+bool PreviewCapture::capture(ImDrawList *drawList, ImVec2 pos, ImVec2 size, int width)
+{
+    if (drawList == nullptr || size.x < 1.0f || size.y < 1.0f)
+    {
+        return false;
+    }
+
+    // Even sizes, some JPEG decoders dislike odd chroma blocks
+    width = std::max(2, width & ~1);
+    int height = std::max(2, static_cast<int>(std::lround(width * size.y / size.x)) & ~1);
+
+    if (width != captureWidth || height != captureHeight || framebuffer == 0)
+    {
+        allocate(width, height);
+    }
+
+    if (fences[nextBuffer] != nullptr)
+    {
+        return false;
+    }
+
+    int index = nextBuffer;
+    nextBuffer = (nextBuffer + 1) % bufferCount;
+
+    // Only the projector window, scaled from its screen size to the capture size
+    ImDrawData drawData;
+    drawData.Valid = true;
+    drawData.DisplayPos = pos;
+    drawData.DisplaySize = size;
+    drawData.FramebufferScale = ImVec2(width / size.x, height / size.y);
+    drawData.AddDrawList(drawList);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glViewport(0, 0, width, height);
+    glDisable(GL_SCISSOR_TEST);
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    ImGui_ImplOpenGL3_RenderDrawData(&drawData);
+
+    // The destination is the bound buffer, the call returns before the copy completes
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pixelBuffers[index]);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    fences[index] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    return true;
+}
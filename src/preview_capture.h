@@ -0,0 +1,44 @@
+#pragma once
+
+#include "imgui.h"
+#include "opengl.h"
+
+#include "preview_stream.h"
+
+// Render thread side of the preview. The draw list of the projector window
+// is rendered again into a small framebuffer, so the GPU does the downscale,
+// and read back into a ring of pixel buffer objects. A readback is mapped
+// only once its fence has signaled, a few frames later, so the render thread
+// never waits for the GPU.
+class PreviewCapture
+{
+public:
+    PreviewCapture() = default;
+    ~PreviewCapture();
+
+    PreviewCapture(const PreviewCapture &) = delete;
+    PreviewCapture &operator=(const PreviewCapture &) = delete;
+
+    // Every frame, hands the finished readbacks to the stream
+    void collect(PreviewStream &stream);
+
+    // After ImGui::Render(), with the main context current. False when every buffer is still in flight.
+    bool capture(ImDrawList *drawList, ImVec2 pos, ImVec2 size, int width);
+
+    // Needs the context that created the objects
+    void release();
+
+private:
+    static constexpr int bufferCount = 3;
+
+    void allocate(int width, int height);
+
+    GLuint framebuffer = 0;
+    GLuint colorTexture = 0;
+    int captureWidth = 0;
+    int captureHeight = 0;
+
+    GLuint pixelBuffers[bufferCount] = {};
+    GLsync fences[bufferCount] = {};
+    int nextBuffer = 0;
+};
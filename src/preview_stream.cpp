@@ -0,0 +1,212 @@
+#include "preview_stream.h"
+
+#include <algorithm>
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+
+PreviewStream::Client::Client(PreviewStream &stream)
+    : stream(stream)
+{
+    stream.clientCount++;
+}
+
+PreviewStream::Client::~Client()
+{
+    // The next viewer must not start with a frame from the last session
+    if (--stream.clientCount == 0)
+    {
+        std::lock_guard<std::mutex> lock(stream.mutex);
+        stream.latest.reset();
+    }
+}
+
+PreviewStream::PreviewStream()
+{
+    thread = std::thread(&PreviewStream::run, this);
+}
+
+PreviewStream::~PreviewStream()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+        closes++;
+    }
+
+    captureReady.notify_all();
+    frameReady.notify_all();
+    thread.join();
+}
+
+void PreviewStream::configure(const PreviewSettings &settings)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    current.fps = std::clamp(settings.fps, 1, 60);
+    current.width = std::clamp(settings.width, 64, 1920);
+    current.quality = std::clamp(settings.quality, 10, 100);
+}
+
+PreviewSettings PreviewStream::settings() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return current;
+}
+
+bool PreviewStream::wanted(Clock::time_point now)
+{
+    if (clientCount == 0)
+    {
+        return false;
+    }
+
+    auto interval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / settings().fps));
+    if (now - lastCapture < interval)
+    {
+        return false;
+    }
+
+    lastCapture = now;
+    return true;
+}
+
+void PreviewStream::submit(std::vector<unsigned char> pixels, int width, int height)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        // Readbacks finish a few frames late, the last viewer may be gone by then
+        if (clientCount == 0)
+        {
+            return;
+        }
+
+        if (hasPending)
+        {
+            stats.skipped++;
+        }
+
+        pending.pixels = std::move(pixels);
+        pending.width = width;
+        pending.height = height;
+        hasPending = true;
+        stats.captured++;
+    }
+
+    captureReady.notify_one();
+}
+
+PreviewStream::FramePtr PreviewStream::waitFrame(uint64_t after, uint64_t closeCount, std::chrono::milliseconds timeout)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+
+    frameReady.wait_for(lock, timeout, [&]()
+                        { return closes != closeCount || (latest && latest->sequence > after); });
+
+    if (closes != closeCount || !latest || latest->sequence <= after)
+    {
+        return nullptr;
+    }
+
+    return latest;
+}
+
+uint64_t PreviewStream::closeCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return closes;
+}
+
+void PreviewStream::closeClients()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closes++;
+    }
+
+    frameReady.notify_all();
+}
+
+PreviewStats PreviewStream::statistics() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    PreviewStats result = stats;
+    result.clients = static_cast<size_t>(std::max(0, clientCount.load()));
+    return result;
+}
+
+void PreviewStream::run()
+{
+    uint64_t sequence = 0;
+
+    while (true)
+    {
+        Capture capture;
+        int quality = 0;
+
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            captureReady.wait(lock, [&]()
+                              { return !running || hasPending; });
+
+            if (!running)
+            {
+                return;
+            }
+
+            std::swap(capture, pending);
+            hasPending = false;
+            quality = current.quality;
+        }
+
+        auto start = Clock::now();
+        FramePtr frame = encode(capture, sequence + 1, quality);
+        double encodeMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+        if (!frame)
+        {
+            continue;
+        }
+
+        sequence = frame->sequence;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            latest = std::move(frame);
+            stats.encoded++;
+            stats.lastEncodeMs = encodeMs;
+            stats.maxEncodeMs = std::max(stats.maxEncodeMs, encodeMs);
+        }
+
+        frameReady.notify_all();
+    }
+}
+
+PreviewStream::FramePtr PreviewStream::encode(const Capture &capture, uint64_t sequence, int quality) const
+{
+    if (capture.width <= 0 || capture.height <= 0 || capture.pixels.size() < static_cast<size_t>(capture.width) * capture.height * 4)
+    {
+        return nullptr;
+    }
+
+    // OpenGL rows start at the bottom
+    cv::Mat rgba(capture.height, capture.width, CV_8UC4, const_cast<unsigned char *>(capture.pixels.data()));
+    cv::Mat bgr;
+    cv::cvtColor(rgba, bgr, cv::COLOR_RGBA2BGR);
+    cv::flip(bgr, bgr, 0);
+
+    std::vector<unsigned char> buffer;
+    if (!cv::imencode(".jpg", bgr, buffer, {cv::IMWRITE_JPEG_QUALITY, quality}))
+    {
+        return nullptr;
+    }
+
+    auto frame = std::make_shared<PreviewFrame>();
+    frame->jpeg.assign(buffer.begin(), buffer.end());
+    frame->sequence = sequence;
+    frame->width = capture.width;
+    frame->height = capture.height;
+    return frame;
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Live preview of the projector, read from the "preview" object of config.json
+struct PreviewSettings
+{
+    int fps = 10;      // Frames captured per second while someone watches
+    int width = 640;   // Height follows the aspect of the projector window
+    int quality = 70;  // JPEG quality
+};
+
+struct PreviewFrame
+{
+    std::string jpeg;
+    uint64_t sequence = 0;
+    int width = 0;
+    int height = 0;
+};
+
+struct PreviewStats
+{
+    size_t clients = 0;
+    uint64_t captured = 0; // Readbacks handed to the encoder
+    uint64_t encoded = 0;
+    uint64_t skipped = 0;  // Captures replaced by a newer one before the encoder got to them
+    double lastEncodeMs = 0.0;
+    double maxEncodeMs = 0.0;
+};
+
+// Frames of /api/preview.mjpeg. The render thread submits pixels read back
+// from the GPU, one worker flips and encodes the latest of them, and every
+// client waits for the next encoded frame. Nothing is captured or encoded
+// while no client is connected.
+class PreviewStream
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    using FramePtr = std::shared_ptr<const PreviewFrame>;
+
+    // Registers a viewer for its lifetime
+    class Client
+    {
+    public:
+        explicit Client(PreviewStream &stream);
+        ~Client();
+
+        Client(const Client &) = delete;
+        Client &operator=(const Client &) = delete;
+
+    private:
+        PreviewStream &stream;
+    };
+
+    PreviewStream();
+    ~PreviewStream();
+
+    PreviewStream(const PreviewStream &) = delete;
+    PreviewStream &operator=(const PreviewStream &) = delete;
+
+    void configure(const PreviewSettings &settings);
+    PreviewSettings settings() const;
+
+    // Render thread, true when a viewer is connected and the frame interval passed
+    bool wanted(Clock::time_point now = Clock::now());
+
+    // Render thread, RGBA rows bottom first as glReadPixels returns them
+    void submit(std::vector<unsigned char> pixels, int width, int height);
+
+    // HTTP threads. Nullptr on timeout or once closeClients() is called after closeCount.
+    FramePtr waitFrame(uint64_t after, uint64_t closeCount, std::chrono::milliseconds timeout);
+    uint64_t closeCount() const;
+
+    // Ends the streams being served, the server waits for its threads on stop
+    void closeClients();
+
+    PreviewStats statistics() const;
+
+private:
+    struct Capture
+    {
+        std::vector<unsigned char> pixels;
+        int width = 0;
+        int height = 0;
+    };
+
+    void run();
+    FramePtr encode(const Capture &capture, uint64_t sequence, int quality) const;
+
+    std::atomic<int> clientCount{0};
+    Clock::time_point lastCapture; // Render thread only
+
+    mutable std::mutex mutex;
+    std::condition_variable captureReady;
+    std::condition_variable frameReady;
+    PreviewSettings current;
+    Capture pending;
+    bool hasPending = false;
+    FramePtr latest;
+    uint64_t closes = 0;
+    bool running = true;
+    PreviewStats stats;
+
+    std::thread thread;
+};
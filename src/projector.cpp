@@ -0,0 +1,81 @@
+#include "projector.h"
+
+#include <algorithm>
+#include <cstdint>
+
+void ImageCoverWindow(GLuint textureID, int width, int height)
+{
+    // Get total window dimensions from ImGui
+    ImVec2 windowSize = ImGui::GetContentRegionAvail();
+
+    // Calculate image and window aspect ratio
+    float imageAspectRatio = static_cast<float>(width) / height;
+    float windowAspectRatio = windowSize.x / windowSize.y;
+
+    ImVec2 imageSize;
+    ImVec2 imagePos;
+
+    if (imageAspectRatio > windowAspectRatio)
+    {
+        // Imagem é mais larga que a área disponível
+        imageSize.x = windowSize.y * imageAspectRatio;    // Ajusta a largura baseado na altura da janela
+        imageSize.y = windowSize.y;                       // Altura preenche a janela
+        imagePos.x = (windowSize.x - imageSize.x) * 0.5f; // Centraliza horizontalmente
+        imagePos.y = 0;                                   // Começa do topo da janela
+    }
+    else
+    {
+        // Imagem é mais alta que a área disponível
+        imageSize.x = windowSize.x;                       // Largura preenche a janela
+        imageSize.y = windowSize.x / imageAspectRatio;    // Ajusta a altura baseado na largura da janela
+        imagePos.x = 0;                                   // Começa da lateral esquerda da janela
+        imagePos.y = (windowSize.y - imageSize.y) * 0.5f; // Centraliza verticalmente
+    }
+
+    // Apply calculated position
+    ImGui::SetCursorPos(imagePos);
+
+    // Render image with adjusted size and position
+    ImGui::Image((void *)(intptr_t)textureID, imageSize);
+}
+
+const char *projectorModeName(ProjectorMode mode)
+{
+    switch (mode)
+    {
+    case ProjectorMode::Text:
+        return "text";
+    case ProjectorMode::Media:
+        return "media";
+    case ProjectorMode::Black:
+        return "black";
+    default:
+        return "default";
+    }
+}
+
+void ProjectorView(const ProjectorContent &content)
+{
+    if (content.textureID != 0 && content.width > 0 && content.height > 0)
+    {
+        ImageCoverWindow(content.textureID, content.width, content.height);
+    }
+
+    if (content.text != nullptr && content.font != nullptr && content.font->loaded())
+    {
+        if (content.slide != nullptr)
+        {
+            content.slide->draw(content.text, *content.font);
+        }
+        else
+        {
+            ImVec2 windowPos = ImGui::GetWindowPos();
+            ImVec2 windowSize = ImGui::GetWindowSize();
+            windowSize.x = (std::max)(windowSize.x, 1.0f);
+            windowSize.y = (std::max)(windowSize.y, 1.0f);
+
+            TextBlockLayout layout = layoutTextBlock(content.text, *content.font, windowSize);
+            drawTextBlock(ImGui::GetWindowDrawList(), layout, *content.font, ImVec2(windowPos.x + layout.origin.x, windowPos.y + layout.origin.y));
+        }
+    }
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "imgui.h"
+#include "opengl.h"
+#include "text_layout.h"
+
+// Screen picked by the operator or the remote control: the text over the
+// media, only the text, only the media, or nothing
+enum class ProjectorMode
+{
+    Default,
+    Text,
+    Media,
+    Black
+};
+
+// Lower case name of the mode, as sent to the remote controls
+const char *projectorModeName(ProjectorMode mode);
+
+// What the projector shows, any part may be left empty
+struct ProjectorContent
+{
+    GLuint textureID = 0;
+    int width = 0;
+    int height = 0;
+    const char *text = nullptr;
+    const SdfFont *font = nullptr;
+    TextSlide *slide = nullptr; // Caches the text between frames, drawn directly when null
+};
+
+// Draws the texture scaled to cover the available region, centered and cropped
+void ImageCoverWindow(GLuint textureID, int width, int height);
+
+// Draws the content inside the current window: the image, then the text over it
+void ProjectorView(const ProjectorContent &content);
@@ -0,0 +1,50 @@
+#include "qr_code.h"
+
+#include <vector>
+
+#include <opencv2/imgproc.hpp>
+#include <opencv2/objdetect.hpp>
+
+cv::Mat generateQRCodeImage(const std::string &data, int size)
+{
+    cv::QRCodeEncoder::Params params;
+    params.mode = cv::QRCodeEncoder::EncodeMode::MODE_BYTE; // Modo de codificação do QR Code
+    cv::Ptr<cv::QRCodeEncoder> encoder = cv::QRCodeEncoder::create(params);
+
+    std::vector<cv::Mat> qrcodes;
+
+    // Gera o QR Code
+    encoder->encodeStructuredAppend(data, qrcodes);
+    if (qrcodes.empty())
+        return cv::Mat(); // Verifica se a geração foi bem-sucedida
+
+    // Considerando apenas o primeiro QR Code para a textura
+    cv::Mat qrCode = qrcodes.front();
+
+    // Redimensiona o QR Code para uma resolução mais alta
+    cv::Mat qrCodeHighRes;
+    cv::resize(qrCode, qrCodeHighRes, cv::Size(size, size), 0, 0, cv::INTER_NEAREST);
+
+    // Converte para RGBA
+    cv::Mat qrCodeRGBA;
+    cvtColor(qrCodeHighRes, qrCodeRGBA, cv::COLOR_BGR2RGBA);
+
+    return qrCodeRGBA;
+}
+
+GLuint generateQRCodeTexture(const std::string &data)
+{
+    cv::Mat qrCodeRGBA = generateQRCodeImage(data);
+    if (qrCodeRGBA.empty())
+        return 0;
+
+    // Gera uma textura OpenGL a partir da imagem RGBA
+    GLuint textureID;
+    glGenTextures(1, &textureID);
+    glBindTexture(GL_TEXTURE_2D, textureID);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, qrCodeRGBA.cols, qrCodeRGBA.rows, 0, GL_RGBA, GL_UNSIGNED_BYTE, qrCodeRGBA.data);
+
+    return textureID;
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <string>
+
+#include <opencv2/core.hpp>
+
+#include "opengl.h"
+
+// Encodes the data as a QR Code scaled to size x size RGBA pixels, empty on failure
+cv::Mat generateQRCodeImage(const std::string &data, int size = 1024);
+
+// Function to generate QRCode
+GLuint generateQRCodeTexture(const std::string &data);
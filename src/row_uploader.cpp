@@ -0,0 +1,37 @@
+#include "row_uploader.h"
+
+#include <algorithm>
+
+namespace
+{
+    double elapsedMs(RowUploader::Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(RowUploader::Clock::now() - start).count();
+    }
+}
+
+bool RowUploader::upload(GLuint texture, const DecodedImage &image, int &uploadedRows, double budgetMs, Clock::time_point start)
+{
+    size_t rowBytes = static_cast<size_t>(image.width) * 4;
+
+    // Size the strip from the measured throughput so it fits the remaining budget
+    double remainingMs = budgetMs - elapsedMs(start);
+    int rows = static_cast<int>(remainingMs * bytesPerMs / static_cast<double>(rowBytes));
+    rows = std::clamp(rows, 1, image.height - uploadedRows);
+
+    Clock::time_point stripStart = Clock::now();
+
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, uploadedRows, image.width, rows, GL_RGBA, GL_UNSIGNED_BYTE, image.pixels.get() + uploadedRows * rowBytes);
+
+    double stripMs = elapsedMs(stripStart);
+    maxStripTime = (std::max)(maxStripTime, stripMs);
+    if (stripMs > 0.05)
+    {
+        bytesPerMs = bytesPerMs * 0.8 + (static_cast<double>(rows * rowBytes) / stripMs) * 0.2;
+    }
+
+    uploadedRows += rows;
+
+    return uploadedRows >= image.height;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <chrono>
+
+#include "opengl.h"
+
+#include "image_decode_pool.h"
+
+// Streams a decoded RGBA image into its texture in row strips. Each strip is
+// sized from the measured upload throughput to fit what is left of the frame
+// budget, so a large image spreads over several frames instead of stalling one.
+class RowUploader
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Uploads the next strip, at least one row, and advances uploadedRows.
+    // True once the whole image is in the texture.
+    bool upload(GLuint texture, const DecodedImage &image, int &uploadedRows, double budgetMs, Clock::time_point start);
+
+    double maxStripMs() const { return maxStripTime; } // Longest single strip, how far a call may overrun its budget
+
+private:
+    double bytesPerMs = 256.0 * 1024.0;
+    double maxStripTime = 0.0;
+};
@@ -0,0 +1,162 @@
+#include "rpc_dispatcher.h"
+
+#include <algorithm>
+#include <iostream>
+
+namespace
+{
+    float millisecondsBetween(RpcDispatcher::Clock::time_point from, RpcDispatcher::Clock::time_point to)
+    {
+        return std::chrono::duration<float, std::milli>(to - from).count();
+    }
+}
+
+void RpcDispatcher::Samples::add(float value)
+{
+    values[next] = value;
+    next = (next + 1) % historySize;
+    count = std::min(count + 1, historySize);
+}
+
+void RpcDispatcher::Samples::percentiles(float &p50, float &p99, float &max) const
+{
+    if (count == 0)
+    {
+        p50 = p99 = max = 0.0f;
+        return;
+    }
+
+    std::vector<float> sorted(values.begin(), values.begin() + count);
+    std::sort(sorted.begin(), sorted.end());
+
+    auto at = [&sorted](double fraction)
+    {
+        return sorted[static_cast<size_t>(fraction * (sorted.size() - 1) + 0.5)];
+    };
+
+    p50 = at(0.50);
+    p99 = at(0.99);
+    max = sorted.back();
+}
+
+void RpcDispatcher::addCommand(const std::string &name, Command command)
+{
+    functions[name].command = std::move(command);
+}
+
+void RpcDispatcher::addQuery(const std::string &name, Query query)
+{
+    functions[name].query = std::move(query);
+}
+
+bool RpcDispatcher::isQuery(const std::string &name) const
+{
+    auto it = functions.find(name);
+    return it != functions.end() && it->second.query != nullptr;
+}
+
+void RpcDispatcher::call(const std::string &name, json params, Clock::time_point received)
+{
+    auto it = functions.find(name);
+    if (it == functions.end())
+    {
+        return;
+    }
+
+    Call entry;
+    entry.function = &it->second;
+    entry.params = std::move(params);
+    entry.received = received;
+
+    calls.push(std::move(entry));
+    receivedCount++;
+}
+
+std::future<RpcDispatcher::json> RpcDispatcher::query(const std::string &name, json params, Clock::time_point received)
+{
+    auto reply = std::make_shared<std::promise<json>>();
+    std::future<json> result = reply->get_future();
+
+    auto it = functions.find(name);
+    if (it == functions.end() || !it->second.query)
+    {
+        reply->set_value(json());
+        return result;
+    }
+
+    Call entry;
+    entry.function = &it->second;
+    entry.params = std::move(params);
+    entry.received = received;
+    entry.reply = std::move(reply);
+
+    calls.push(std::move(entry));
+    receivedCount++;
+    return result;
+}
+
+int RpcDispatcher::drain(Clock::time_point now)
+{
+    int count = 0;
+    Call entry;
+
+    while (calls.pop(entry))
+    {
+        queueLatency.add(millisecondsBetween(entry.received, now));
+        executedCount++;
+        count++;
+
+        try
+        {
+            if (entry.reply)
+            {
+                entry.reply->set_value(entry.function->query(entry.params));
+                continue; // Queries do not change the output
+            }
+
+            bool immediate = entry.function->command(entry.params);
+            (immediate ? executedTimes : deferredTimes).push_back(entry.received);
+        }
+        catch (const std::exception &e)
+        {
+            // Bad parameters must not take down the render loop
+            std::cerr << "Remote call failed: " << e.what() << std::endl;
+
+            if (entry.reply)
+            {
+                entry.reply->set_value(json());
+            }
+        }
+    }
+
+    return count;
+}
+
+void RpcDispatcher::release()
+{
+    executedTimes.insert(executedTimes.end(), deferredTimes.begin(), deferredTimes.end());
+    deferredTimes.clear();
+}
+
+void RpcDispatcher::presented(Clock::time_point now)
+{
+    for (Clock::time_point received : executedTimes)
+    {
+        presentLatency.add(millisecondsBetween(received, now));
+        presentedCount++;
+    }
+
+    executedTimes.clear();
+}
+
+RpcStats RpcDispatcher::statistics() const
+{
+    RpcStats stats;
+    stats.received = receivedCount.load();
+    stats.executed = executedCount;
+    stats.presented = presentedCount;
+
+    queueLatency.percentiles(stats.queueP50, stats.queueP99, stats.queueMax);
+    presentLatency.percentiles(stats.presentP50, stats.presentP99, stats.presentMax);
+    return stats;
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "mpsc_queue.h"
+
+struct RpcStats
+{
+    uint64_t received = 0;  // Calls queued by the HTTP threads
+    uint64_t executed = 0;  // Calls run on the render thread
+    uint64_t presented = 0; // Calls whose change reached a presented frame
+
+    // From the HTTP request to the call running on the render thread, ms
+    float queueP50 = 0.0f;
+    float queueP99 = 0.0f;
+    float queueMax = 0.0f;
+
+    // From the HTTP request to the first frame showing the change, ms
+    float presentP50 = 0.0f;
+    float presentP99 = 0.0f;
+    float presentMax = 0.0f;
+};
+
+// Remote control functions called through /api/module/call. HTTP worker
+// threads push calls into a lock-free queue and the render thread runs them
+// from drain(), once per frame, so the functions can touch the UI state
+// without locks. Commands are answered as soon as they are queued, queries
+// wait for the render thread to produce their result.
+class RpcDispatcher
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    using json = nlohmann::json;
+
+    // Returns false when the change shows up later than the next frame, the
+    // call then counts as presented after the next release()
+    using Command = std::function<bool(const json &params)>;
+    using Query = std::function<json(const json &params)>;
+
+    RpcDispatcher() = default;
+
+    RpcDispatcher(const RpcDispatcher &) = delete;
+    RpcDispatcher &operator=(const RpcDispatcher &) = delete;
+
+    // Registration happens before the server starts, the table is read without a lock
+    void addCommand(const std::string &name, Command command);
+    void addQuery(const std::string &name, Query query);
+
+    // HTTP threads
+    bool has(const std::string &name) const { return functions.count(name) > 0; }
+    bool isQuery(const std::string &name) const;
+    void call(const std::string &name, json params, Clock::time_point received);
+    std::future<json> query(const std::string &name, json params, Clock::time_point received);
+
+    // Render thread: runs the queued calls, returns how many
+    int drain(Clock::time_point now = Clock::now());
+
+    // Render thread: the deferred changes are now on the output
+    void release();
+
+    // Render thread, after the frame is swapped
+    void presented(Clock::time_point now = Clock::now());
+
+    RpcStats statistics() const;
+
+private:
+    static constexpr int historySize = 256;
+
+    struct Function
+    {
+        Command command;
+        Query query;
+    };
+
+    struct Call
+    {
+        const Function *function = nullptr;
+        json params;
+        Clock::time_point received;
+        std::shared_ptr<std::promise<json>> reply; // Queries only
+    };
+
+    struct Samples
+    {
+        std::vector<float> values = std::vector<float>(historySize, 0.0f);
+        int next = 0;
+        int count = 0;
+
+        void add(float value);
+        void percentiles(float &p50, float &p99, float &max) const;
+    };
+
+    std::unordered_map<std::string, Function> functions;
+    MpscQueue<Call> calls;
+    std::atomic<uint64_t> receivedCount{0};
+
+    // Render thread only
+    std::vector<Clock::time_point> executedTimes; // Waiting for the next presented frame
+    std::vector<Clock::time_point> deferredTimes; // Waiting for release()
+    uint64_t executedCount = 0;
+    uint64_t presentedCount = 0;
+    Samples queueLatency;
+    Samples presentLatency;
+};
@@ -0,0 +1,450 @@
+#include "sdf_font.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+// ImGui compiles its own copy with static linkage, so does this file
+#define STBTT_STATIC
+#define STB_TRUETYPE_IMPLEMENTATION
+#include "stb_truetype.h"
+
+namespace
+{
+    const int atlasPixelWidth = 512;
+    const unsigned char onEdgeValue = 128;
+
+    // Latin-1 plus the punctuation lyrics are usually typed with
+    const unsigned int extraCodepoints[] = {0x2013, 0x2014, 0x2018, 0x2019, 0x201C, 0x201D, 0x2026};
+
+    const char *vertexSource = R"(#version 330 core
+uniform mat4 ProjMtx;
+in vec2 Position;
+in vec2 UV;
+in vec4 Color;
+out vec2 Frag_UV;
+out vec4 Frag_Color;
+void main()
+{
+    Frag_UV = UV;
+    Frag_Color = Color;
+    gl_Position = ProjMtx * vec4(Position.xy, 0.0, 1.0);
+}
+)";
+
+    // Fill, outline and shadow from the same field, over each other in one pass
+    const char *fragmentSource = R"(#version 330 core
+uniform sampler2D Texture;
+uniform vec4 OutlineColor;
+uniform float OutlineWidth;
+uniform vec4 ShadowColor;
+uniform vec2 ShadowOffset;
+in vec2 Frag_UV;
+in vec4 Frag_Color;
+out vec4 Out_Color;
+void main()
+{
+    float distance = texture(Texture, Frag_UV).r;
+    float smoothing = max(fwidth(distance) * 0.7, 0.0001);
+    float outlineEdge = 0.5 - OutlineWidth;
+
+    float fill = smoothstep(0.5 - smoothing, 0.5 + smoothing, distance);
+    float body = smoothstep(outlineEdge - smoothing, outlineEdge + smoothing, distance);
+    vec4 text = mix(OutlineColor, vec4(Frag_Color.rgb, 1.0), fill);
+    text.a *= body;
+
+    float shadowDistance = texture(Texture, Frag_UV - ShadowOffset).r;
+    float shadow = smoothstep(outlineEdge - 0.05, outlineEdge + 0.05, shadowDistance) * ShadowColor.a;
+
+    float alpha = text.a + shadow * (1.0 - text.a);
+    vec3 color = (text.rgb * text.a + ShadowColor.rgb * shadow * (1.0 - text.a)) / max(alpha, 0.0001);
+    Out_Color = vec4(color, alpha * Frag_Color.a);
+}
+)";
+
+    // Next code point of a UTF-8 string, invalid bytes are returned as is
+    unsigned int nextCodepoint(const std::string &text, size_t &index)
+    {
+        unsigned char first = static_cast<unsigned char>(text[index++]);
+        int extra = first >= 0xF0 ? 3 : first >= 0xE0 ? 2 : first >= 0xC0 ? 1 : 0;
+        unsigned int codepoint = extra == 0 ? first : first & (0x3F >> extra);
+
+        for (int i = 0; i < extra && index < text.size(); ++i)
+        {
+            unsigned char next = static_cast<unsigned char>(text[index]);
+            if ((next & 0xC0) != 0x80)
+            {
+                return first;
+            }
+
+            codepoint = (codepoint << 6) | (next & 0x3F);
+            index++;
+        }
+
+        return codepoint;
+    }
+
+    GLuint compileShader(GLenum type, const char *source)
+    {
+        GLuint shader = glCreateShader(type);
+        glShaderSource(shader, 1, &source, nullptr);
+        glCompileShader(shader);
+
+        GLint compiled = GL_FALSE;
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+        if (compiled != GL_TRUE)
+        {
+            char log[512] = {};
+            glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+            std::cerr << "SDF shader: " << log << std::endl;
+            glDeleteShader(shader);
+            return 0;
+        }
+
+        return shader;
+    }
+}
+
+SdfFont::SdfFont() = default;
+
+SdfFont::~SdfFont()
+{
+    release();
+}
+
+bool SdfFont::load(const std::string &path, float bakeSize, int padding)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+    {
+        return false;
+    }
+
+    fontData.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    fontInfo = std::make_unique<stbtt_fontinfo>();
+
+    if (fontData.empty() || !stbtt_InitFont(fontInfo.get(), fontData.data(), stbtt_GetFontOffsetForIndex(fontData.data(), 0)))
+    {
+        fontData.clear();
+        fontInfo.reset();
+        return false;
+    }
+
+    this->bakeSize = bakeSize;
+    bakeScale = stbtt_ScaleForPixelHeight(fontInfo.get(), bakeSize);
+    distancePerPixel = static_cast<float>(onEdgeValue) / padding / 255.0f;
+
+    int fontAscent = 0, fontDescent = 0, lineGap = 0;
+    stbtt_GetFontVMetrics(fontInfo.get(), &fontAscent, &fontDescent, &lineGap);
+    ascent = fontAscent * bakeScale;
+
+    std::vector<unsigned int> codepoints;
+    for (unsigned int codepoint = 32; codepoint < 127; ++codepoint)
+    {
+        codepoints.push_back(codepoint);
+    }
+    for (unsigned int codepoint = 160; codepoint < 256; ++codepoint)
+    {
+        codepoints.push_back(codepoint);
+    }
+    codepoints.insert(codepoints.end(), std::begin(extraCodepoints), std::end(extraCodepoints));
+
+    // Fields of every glyph first, then a shelf packing into the atlas
+    struct Baked
+    {
+        unsigned int codepoint;
+        unsigned char *field;
+        int width, height, x, y;
+    };
+
+    std::vector<Baked> baked;
+    glyphs.clear();
+
+    for (unsigned int codepoint : codepoints)
+    {
+        int index = stbtt_FindGlyphIndex(fontInfo.get(), static_cast<int>(codepoint));
+        if (index == 0 && codepoint != ' ')
+        {
+            continue;
+        }
+
+        int advance = 0, leftBearing = 0;
+        stbtt_GetGlyphHMetrics(fontInfo.get(), index, &advance, &leftBearing);
+
+        int fieldWidth = 0, fieldHeight = 0, offsetX = 0, offsetY = 0;
+        unsigned char *field = stbtt_GetGlyphSDF(fontInfo.get(), bakeScale, index, padding, onEdgeValue, static_cast<float>(onEdgeValue) / padding, &fieldWidth, &fieldHeight, &offsetX, &offsetY);
+
+        Glyph &glyph = glyphs[codepoint];
+        glyph.advance = advance * bakeScale;
+        glyph.index = index;
+
+        // Blank glyphs (spaces) only advance the pen
+        if (field == nullptr)
+        {
+            continue;
+        }
+
+        glyph.x0 = static_cast<float>(offsetX);
+        glyph.y0 = static_cast<float>(offsetY);
+        glyph.x1 = static_cast<float>(offsetX + fieldWidth);
+        glyph.y1 = static_cast<float>(offsetY + fieldHeight);
+        baked.push_back({codepoint, field, fieldWidth, fieldHeight, 0, 0});
+    }
+
+    // Tallest first keeps the shelves tight
+    std::sort(baked.begin(), baked.end(), [](const Baked &a, const Baked &b)
+              { return a.height > b.height; });
+
+    int x = 0, y = 0, shelfHeight = 0;
+    for (Baked &glyph : baked)
+    {
+        if (x + glyph.width > atlasPixelWidth)
+        {
+            x = 0;
+            y += shelfHeight + 1;
+            shelfHeight = 0;
+        }
+
+        glyph.x = x;
+        glyph.y = y;
+        x += glyph.width + 1;
+        shelfHeight = std::max(shelfHeight, glyph.height);
+    }
+
+    width = atlasPixelWidth;
+    height = std::max(1, y + shelfHeight);
+    pixels.assign(static_cast<size_t>(width) * height, 0);
+
+    for (const Baked &glyph : baked)
+    {
+        for (int row = 0; row < glyph.height; ++row)
+        {
+            std::copy_n(glyph.field + row * glyph.width, glyph.width, pixels.begin() + static_cast<size_t>(glyph.y + row) * width + glyph.x);
+        }
+
+        Glyph &entry = glyphs[glyph.codepoint];
+        entry.uv0 = ImVec2(static_cast<float>(glyph.x) / width, static_cast<float>(glyph.y) / height);
+        entry.uv1 = ImVec2(static_cast<float>(glyph.x + glyph.width) / width, static_cast<float>(glyph.y + glyph.height) / height);
+
+        stbtt_FreeSDF(glyph.field, nullptr);
+    }
+
+    bakeTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return true;
+}
+
+bool SdfFont::upload()
+{
+    if (!loaded())
+    {
+        return false;
+    }
+
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, width, height, 0, GL_RED, GL_UNSIGNED_BYTE, pixels.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    vertexShader = compileShader(GL_VERTEX_SHADER, vertexSource);
+    fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentSource);
+    return vertexShader != 0 && fragmentShader != 0;
+}
+
+void SdfFont::release()
+{
+    if (program != 0)
+    {
+        glDeleteProgram(program);
+        program = 0;
+    }
+
+    if (vertexShader != 0)
+    {
+        glDeleteShader(vertexShader);
+        vertexShader = 0;
+    }
+
+    if (fragmentShader != 0)
+    {
+        glDeleteShader(fragmentShader);
+        fragmentShader = 0;
+    }
+
+    if (texture != 0)
+    {
+        glDeleteTextures(1, &texture);
+        texture = 0;
+    }
+}
+
+const SdfFont::Glyph *SdfFont::find(unsigned int codepoint) const
+{
+    auto glyph = glyphs.find(codepoint);
+    if (glyph == glyphs.end())
+    {
+        glyph = glyphs.find('?');
+    }
+
+    return glyph != glyphs.end() ? &glyph->second : nullptr;
+}
+
+float SdfFont::kerning(const Glyph &left, const Glyph &right) const
+{
+    return stbtt_GetGlyphKernAdvance(fontInfo.get(), left.index, right.index) * bakeScale;
+}
+
+float SdfFont::measure(const std::string &text, float size) const
+{
+    float scale = size / bakeSize;
+    float pen = 0.0f;
+    const Glyph *previous = nullptr;
+
+    for (size_t i = 0; i < text.size();)
+    {
+        const Glyph *glyph = find(nextCodepoint(text, i));
+        if (glyph == nullptr)
+        {
+            continue;
+        }
+
+        if (previous != nullptr)
+        {
+            pen += kerning(*previous, *glyph);
+        }
+
+        pen += glyph->advance;
+        previous = glyph;
+    }
+
+    return pen * scale;
+}
+
+float SdfFont::effectMargin(float size) const
+{
+    return std::ceil(size * (style.outlineWidth + std::max(std::fabs(style.shadowOffset.x), std::fabs(style.shadowOffset.y)))) + 1.0f;
+}
+
+void SdfFont::addText(ImDrawList *drawList, float size, ImVec2 pos, ImU32 color, const std::string &text) const
+{
+    float scale = size / bakeSize;
+    float baseline = pos.y + ascent * scale;
+    float pen = 0.0f;
+    const Glyph *previous = nullptr;
+
+    for (size_t i = 0; i < text.size();)
+    {
+        const Glyph *glyph = find(nextCodepoint(text, i));
+        if (glyph == nullptr)
+        {
+            continue;
+        }
+
+        if (previous != nullptr)
+        {
+            pen += kerning(*previous, *glyph);
+        }
+
+        if (glyph->x1 > glyph->x0)
+        {
+            ImVec2 a(pos.x + (pen + glyph->x0) * scale, baseline + glyph->y0 * scale);
+            ImVec2 b(pos.x + (pen + glyph->x1) * scale, baseline + glyph->y1 * scale);
+            drawList->PrimReserve(6, 4);
+            drawList->PrimRectUV(a, b, glyph->uv0, glyph->uv1, color);
+        }
+
+        pen += glyph->advance;
+        previous = glyph;
+    }
+}
+
+void SdfFont::beginText(ImDrawList *drawList) const
+{
+    drawList->AddCallback(&SdfFont::setupRenderState, const_cast<SdfFont *>(this));
+    drawList->PushTextureID((ImTextureID)(intptr_t)texture);
+}
+
+void SdfFont::endText(ImDrawList *drawList) const
+{
+    drawList->PopTextureID();
+    drawList->AddCallback(ImDrawCallback_ResetRenderState, nullptr);
+}
+
+bool SdfFont::compileProgram(GLint positionLocation, GLint uvLocation, GLint colorLocation)
+{
+    // The backend set up the vertex layout, the program reads it at the same locations
+    program = glCreateProgram();
+    glAttachShader(program, vertexShader);
+    glAttachShader(program, fragmentShader);
+    glBindAttribLocation(program, static_cast<GLuint>(positionLocation), "Position");
+    glBindAttribLocation(program, static_cast<GLuint>(uvLocation), "UV");
+    glBindAttribLocation(program, static_cast<GLuint>(colorLocation), "Color");
+    glLinkProgram(program);
+
+    GLint linked = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (linked != GL_TRUE)
+    {
+        std::cerr << "SDF shader: link failed." << std::endl;
+        glDeleteProgram(program);
+        program = 0;
+        return false;
+    }
+
+    projectionUniform = glGetUniformLocation(program, "ProjMtx");
+    textureUniform = glGetUniformLocation(program, "Texture");
+    outlineColorUniform = glGetUniformLocation(program, "OutlineColor");
+    outlineWidthUniform = glGetUniformLocation(program, "OutlineWidth");
+    shadowColorUniform = glGetUniformLocation(program, "ShadowColor");
+    shadowOffsetUniform = glGetUniformLocation(program, "ShadowOffset");
+    return true;
+}
+
+void SdfFont::setupRenderState(const ImDrawList *, const ImDrawCmd *command)
+{
+    auto *font = static_cast<SdfFont *>(command->UserCallbackData);
+    if (font->vertexShader == 0 || font->fragmentShader == 0)
+    {
+        return;
+    }
+
+    // The ImGui program is current, its projection covers this draw data
+    GLint backendProgram = 0;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &backendProgram);
+
+    if (font->program == 0)
+    {
+        GLint position = glGetAttribLocation(static_cast<GLuint>(backendProgram), "Position");
+        GLint uv = glGetAttribLocation(static_cast<GLuint>(backendProgram), "UV");
+        GLint color = glGetAttribLocation(static_cast<GLuint>(backendProgram), "Color");
+        if (position < 0 || uv < 0 || color < 0 || !font->compileProgram(position, uv, color))
+        {
+            return;
+        }
+    }
+
+    float projection[16] = {};
+    glGetUniformfv(static_cast<GLuint>(backendProgram), glGetUniformLocation(static_cast<GLuint>(backendProgram), "ProjMtx"), projection);
+
+    const SdfStyle &style = font->style;
+    float shadowX = style.shadowOffset.x * font->bakeSize / font->width;
+    float shadowY = style.shadowOffset.y * font->bakeSize / font->height;
+
+    glUseProgram(font->program);
+    glUniformMatrix4fv(font->projectionUniform, 1, GL_FALSE, projection);
+    glUniform1i(font->textureUniform, 0);
+    glUniform4f(font->outlineColorUniform, style.outlineColor.x, style.outlineColor.y, style.outlineColor.z, style.outlineColor.w);
+    glUniform1f(font->outlineWidthUniform, style.outlineWidth * font->bakeSize * font->distancePerPixel);
+    glUniform4f(font->shadowColorUniform, style.shadowColor.x, style.shadowColor.y, style.shadowColor.z, style.shadowColor.w);
+    glUniform2f(font->shadowOffsetUniform, shadowX, shadowY);
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "imgui.h"
+#include "opengl.h"
+
+struct stbtt_fontinfo;
+
+// Outline and shadow of SDF text, sizes in fractions of the font size so a
+// slide looks the same at any size
+struct SdfStyle
+{
+    ImVec4 outlineColor = ImVec4(0.0f, 0.0f, 0.0f, 1.0f);
+    float outlineWidth = 0.03f;
+    ImVec4 shadowColor = ImVec4(0.0f, 0.0f, 0.0f, 0.5f);
+    ImVec2 shadowOffset = ImVec2(0.03f, 0.03f);
+};
+
+// Signed distance field font for the projector text. Glyphs are baked once
+// at a small size into a single channel atlas, any size is drawn from it
+// with crisp edges, and the outline and the shadow come from the same
+// shader pass, set up by a draw list callback around the glyph quads.
+class SdfFont
+{
+public:
+    SdfFont();
+    ~SdfFont();
+
+    SdfFont(const SdfFont &) = delete;
+    SdfFont &operator=(const SdfFont &) = delete;
+
+    // Reads the font and bakes the atlas on the CPU, any thread
+    bool load(const std::string &path, float bakeSize = 64.0f, int padding = 8);
+
+    // Creates the texture and the shader, needs a current context
+    bool upload();
+
+    // Needs the context used by upload()
+    void release();
+
+    bool loaded() const { return !glyphs.empty(); }
+
+    // Width of a UTF-8 line at the size, the line height is the size itself
+    float measure(const std::string &text, float size) const;
+
+    // Room the outline and the shadow need around the glyphs, in pixels at the size
+    float effectMargin(float size) const;
+
+    // Glyph quads of one line, between beginText() and endText()
+    void addText(ImDrawList *drawList, float size, ImVec2 pos, ImU32 color, const std::string &text) const;
+    void beginText(ImDrawList *drawList) const;
+    void endText(ImDrawList *drawList) const;
+
+    void setStyle(const SdfStyle &style) { this->style = style; }
+
+    int atlasWidth() const { return width; }
+    int atlasHeight() const { return height; }
+    size_t atlasBytes() const { return pixels.size(); }
+    size_t glyphCount() const { return glyphs.size(); }
+    double bakeMs() const { return bakeTime; }
+
+private:
+    struct Glyph
+    {
+        float advance = 0.0f; // Bake pixels
+        float x0 = 0.0f;      // Quad relative to the pen on the baseline, bake pixels
+        float y0 = 0.0f;
+        float x1 = 0.0f;
+        float y1 = 0.0f;
+        ImVec2 uv0;
+        ImVec2 uv1;
+        int index = 0; // Glyph index, for kerning
+    };
+
+    const Glyph *find(unsigned int codepoint) const;
+    float kerning(const Glyph &left, const Glyph &right) const;
+    bool compileProgram(GLint positionLocation, GLint uvLocation, GLint colorLocation);
+
+    static void setupRenderState(const ImDrawList *drawList, const ImDrawCmd *command);
+
+    std::vector<unsigned char> fontData;
+    std::unique_ptr<stbtt_fontinfo> fontInfo; // Points into fontData, used for kerning
+    std::unordered_map<unsigned int, Glyph> glyphs;
+    std::vector<unsigned char> pixels;
+    int width = 0;
+    int height = 0;
+    float bakeSize = 0.0f;
+    float bakeScale = 0.0f; // Font units to bake pixels
+    float ascent = 0.0f;    // Bake pixels
+    float distancePerPixel = 0.0f; // Change of the field per bake pixel, 0..1 range
+    double bakeTime = 0.0;
+
+    SdfStyle style;
+
+    GLuint texture = 0;
+    GLuint program = 0;
+    GLuint vertexShader = 0;
+    GLuint fragmentShader = 0;
+    GLint projectionUniform = -1;
+    GLint textureUniform = -1;
+    GLint outlineColorUniform = -1;
+    GLint outlineWidthUniform = -1;
+    GLint shadowColorUniform = -1;
+    GLint shadowOffsetUniform = -1;
+};
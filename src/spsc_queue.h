@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// Bounded lock-free queue for exactly one producer and one consumer thread
+template <typename T>
+class SpscQueue
+{
+public:
+    explicit SpscQueue(size_t capacity)
+        : slots(capacity + 1)
+    {
+    }
+
+    SpscQueue(const SpscQueue &) = delete;
+    SpscQueue &operator=(const SpscQueue &) = delete;
+
+    // Producer side, fails when the queue is full
+    bool push(T &&value)
+    {
+        size_t tail = tailIndex.load(std::memory_order_relaxed);
+        size_t next = increment(tail);
+
+        if (next == headIndex.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+
+        slots[tail] = std::move(value);
+        tailIndex.store(next, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side, nullptr when the queue is empty
+    T *front()
+    {
+        size_t head = headIndex.load(std::memory_order_relaxed);
+
+        if (head == tailIndex.load(std::memory_order_acquire))
+        {
+            return nullptr;
+        }
+
+        return &slots[head];
+    }
+
+    // Consumer side, only valid after front() returned an element
+    void pop()
+    {
+        size_t head = headIndex.load(std::memory_order_relaxed);
+        slots[head] = T();
+        headIndex.store(increment(head), std::memory_order_release);
+    }
+
+    bool pop(T &value)
+    {
+        T *item = front();
+        if (item == nullptr)
+        {
+            return false;
+        }
+
+        value = std::move(*item);
+        pop();
+        return true;
+    }
+
+    bool empty() const { return headIndex.load(std::memory_order_acquire) == tailIndex.load(std::memory_order_acquire); }
+    bool full() const { return increment(tailIndex.load(std::memory_order_acquire)) == headIndex.load(std::memory_order_acquire); }
+    size_t capacity() const { return slots.size() - 1; }
+
+private:
+    size_t increment(size_t index) const { return index + 1 == slots.size() ? 0 : index + 1; }
+
+    std::vector<T> slots;
+    alignas(64) std::atomic<size_t> headIndex{0};
+    alignas(64) std::atomic<size_t> tailIndex{0};
+};
@@ -0,0 +1,108 @@
+#include "startup_trace.h"
+
+#include <iomanip>
+#include <sstream>
+
+StartupTrace::StartupTrace()
+    : start(Clock::now())
+{
+}
+
+double StartupTrace::elapsedMs() const
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+int StartupTrace::begin(const std::string &name, bool background)
+{
+    Phase phase;
+    phase.name = name;
+    phase.background = background;
+    phase.startMs = elapsedMs();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    phaseList.push_back(phase);
+    return static_cast<int>(phaseList.size()) - 1;
+}
+
+void StartupTrace::end(int phase)
+{
+    double now = elapsedMs();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (phase >= 0 && phase < static_cast<int>(phaseList.size()) && phaseList[phase].durationMs < 0.0)
+    {
+        phaseList[phase].durationMs = now - phaseList[phase].startMs;
+    }
+}
+
+void StartupTrace::markFirstFrame()
+{
+    double now = elapsedMs();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (firstFrame < 0.0)
+    {
+        firstFrame = now;
+    }
+}
+
+void StartupTrace::markInteractive()
+{
+    double now = elapsedMs();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (interactiveAt < 0.0)
+    {
+        interactiveAt = now;
+    }
+}
+
+double StartupTrace::firstFrameMs() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return firstFrame;
+}
+
+double StartupTrace::interactiveMs() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return interactiveAt;
+}
+
+std::vector<StartupTrace::Phase> StartupTrace::phases() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return phaseList;
+}
+
+void StartupTrace::print(std::ostream &out) const
+{
+    // Formatted apart, so the caller's stream keeps its own precision
+    std::ostringstream text;
+    text << std::fixed << std::setprecision(1);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        for (const Phase &phase : phaseList)
+        {
+            text << "  " << std::setw(8) << phase.startMs << " ms  " << (phase.background ? "[bg] " : "     ") << phase.name << ": ";
+
+            if (phase.durationMs < 0.0)
+            {
+                text << "running";
+            }
+            else
+            {
+                text << phase.durationMs << " ms";
+            }
+
+            text << "\n";
+        }
+
+        text << "  First frame at " << firstFrame << " ms, interactive at " << interactiveAt << " ms.\n";
+    }
+
+    out << text.str() << std::flush;
+}
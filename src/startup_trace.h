@@ -0,0 +1,56 @@
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Time of each startup phase since the trace was created, with the two
+// milestones: the first frame on screen and the moment everything loaded in
+// the background is usable. Phases may end on any thread.
+class StartupTrace
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Phase
+    {
+        std::string name;
+        bool background = false; // Ran off the render thread, overlapping the frames
+        double startMs = 0.0;
+        double durationMs = -1.0; // Negative while running
+    };
+
+    StartupTrace();
+
+    StartupTrace(const StartupTrace &) = delete;
+    StartupTrace &operator=(const StartupTrace &) = delete;
+
+    int begin(const std::string &name, bool background = false);
+    void end(int phase);
+
+    // Only the first call counts
+    void markFirstFrame();
+    void markInteractive();
+
+    // Negative until marked
+    double firstFrameMs() const;
+    double interactiveMs() const;
+    bool interactive() const { return interactiveMs() >= 0.0; }
+
+    std::vector<Phase> phases() const;
+
+    // One line per phase, then the milestones
+    void print(std::ostream &out) const;
+
+private:
+    double elapsedMs() const;
+
+    Clock::time_point start;
+
+    mutable std::mutex mutex;
+    std::vector<Phase> phaseList;
+    double firstFrame = -1.0;
+    double interactiveAt = -1.0;
+};
@@ -0,0 +1,270 @@
+#include "state_hub.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include <Poco/Exception.h>
+
+namespace
+{
+    // A client that stalls a send or a frame for longer is dropped, so it never holds up the others
+    const Poco::Timespan socketTimeout(0, 250000);
+}
+
+bool PlayerState::same(const PlayerState &other, double positionStepMs) const
+{
+    return mode == other.mode && visible == other.visible && text == other.text && media == other.media &&
+           mediaType == other.mediaType && playing == other.playing && std::abs(positionMs - other.positionMs) < positionStepMs;
+}
+
+nlohmann::json PlayerState::toJson() const
+{
+    return {
+        {"mode", mode},
+        {"visible", visible},
+        {"text", text},
+        {"media", media},
+        {"mediaType", mediaType},
+        {"playing", playing},
+        {"positionMs", positionMs},
+    };
+}
+
+StateHub::StateHub()
+{
+    thread = std::thread(&StateHub::run, this);
+}
+
+StateHub::~StateHub()
+{
+    running = false;
+    pollSet.wakeUp();
+    thread.join();
+}
+
+void StateHub::addClient(Poco::Net::WebSocket socket)
+{
+    socket.setNoDelay(true);
+    socket.setSendTimeout(socketTimeout);
+    socket.setReceiveTimeout(socketTimeout);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        joined.push_back(socket);
+    }
+
+    pollSet.wakeUp();
+}
+
+void StateHub::publish(const nlohmann::json &state)
+{
+    auto message = std::make_shared<const std::string>(state.dump());
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        latest = std::move(message);
+        latestTime = Clock::now();
+        latestSent = false;
+        stats.published++;
+    }
+
+    pollSet.wakeUp();
+}
+
+void StateHub::closeClients()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closeRequested = true;
+    }
+
+    pollSet.wakeUp();
+}
+
+StateHubStats StateHub::statistics() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
+
+void StateHub::run()
+{
+    while (running)
+    {
+        Poco::Net::PollSet::SocketModeMap ready;
+
+        try
+        {
+            ready = pollSet.poll(Poco::Timespan(1, 0));
+        }
+        catch (const Poco::Exception &e)
+        {
+            std::cerr << "Events: " << e.displayText() << std::endl;
+        }
+
+        for (const auto &entry : ready)
+        {
+            auto client = clients.find(entry.first);
+            if (client == clients.end())
+            {
+                continue;
+            }
+
+            if ((entry.second & Poco::Net::PollSet::POLL_ERROR) || !receive(client->second))
+            {
+                pollSet.remove(client->first);
+                clients.erase(client);
+            }
+        }
+
+        addJoined();
+        broadcast();
+
+        bool close = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            std::swap(close, closeRequested);
+            stats.clients = clients.size();
+        }
+
+        if (close)
+        {
+            closeAll();
+        }
+    }
+
+    closeAll();
+}
+
+void StateHub::addJoined()
+{
+    std::vector<Poco::Net::WebSocket> sockets;
+    std::shared_ptr<const std::string> state;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        sockets.swap(joined);
+        state = latestSent ? latest : nullptr; // Unsent states reach everyone in broadcast()
+    }
+
+    for (Poco::Net::WebSocket &socket : sockets)
+    {
+        if (state && !send(socket, *state))
+        {
+            continue;
+        }
+
+        pollSet.add(socket, Poco::Net::PollSet::POLL_READ | Poco::Net::PollSet::POLL_ERROR);
+        clients.emplace(socket, socket);
+    }
+}
+
+void StateHub::broadcast()
+{
+    std::shared_ptr<const std::string> state;
+    Clock::time_point publishedTime;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (latestSent || !latest)
+        {
+            return;
+        }
+
+        state = latest;
+        publishedTime = latestTime;
+        latestSent = true;
+    }
+
+    uint64_t dropped = 0;
+
+    for (auto client = clients.begin(); client != clients.end();)
+    {
+        if (send(client->second, *state))
+        {
+            ++client;
+            continue;
+        }
+
+        pollSet.remove(client->first);
+        client = clients.erase(client);
+        dropped++;
+    }
+
+    double fanOutMs = std::chrono::duration<double, std::milli>(Clock::now() - publishedTime).count();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    stats.broadcasts++;
+    stats.dropped += dropped;
+    stats.lastFanOutMs = fanOutMs;
+    stats.maxFanOutMs = std::max(stats.maxFanOutMs, fanOutMs);
+}
+
+bool StateHub::receive(Poco::Net::WebSocket &socket)
+{
+    int flags = 0;
+    int received = 0;
+
+    try
+    {
+        received = socket.receiveFrame(buffer.data(), static_cast<int>(buffer.size()), flags);
+    }
+    catch (const Poco::Exception &)
+    {
+        return false; // Reset, timeout or a frame larger than the buffer
+    }
+
+    int opcode = flags & Poco::Net::WebSocket::FRAME_OP_BITMASK;
+
+    if ((received == 0 && flags == 0) || opcode == Poco::Net::WebSocket::FRAME_OP_CLOSE)
+    {
+        return false;
+    }
+
+    // Clients only talk to keep the connection alive, everything else is ignored
+    if (opcode == Poco::Net::WebSocket::FRAME_OP_PING)
+    {
+        try
+        {
+            socket.sendFrame(buffer.data(), received, Poco::Net::WebSocket::FRAME_FLAG_FIN | Poco::Net::WebSocket::FRAME_OP_PONG);
+        }
+        catch (const Poco::Exception &)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool StateHub::send(Poco::Net::WebSocket &socket, const std::string &message)
+{
+    try
+    {
+        socket.sendFrame(message.data(), static_cast<int>(message.size()));
+        return true;
+    }
+    catch (const Poco::Exception &)
+    {
+        return false;
+    }
+}
+
+void StateHub::closeAll()
+{
+    for (auto &client : clients)
+    {
+        try
+        {
+            client.second.shutdown();
+        }
+        catch (const Poco::Exception &)
+        {
+        }
+
+        pollSet.remove(client.first);
+    }
+
+    clients.clear();
+}
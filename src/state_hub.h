@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <Poco/Net/PollSet.h>
+#include <Poco/Net/WebSocket.h>
+
+#include <nlohmann/json.hpp>
+
+// Projector state pushed to the remote controls
+struct PlayerState
+{
+    std::string mode; // default, text, media or black
+    bool visible = true;
+    std::string text;
+    std::string media;     // File on screen, empty when none
+    std::string mediaType; // image or video
+    bool playing = false;
+    double positionMs = 0.0;
+
+    // Same state, apart from a playback position that moved less than the step
+    bool same(const PlayerState &other, double positionStepMs) const;
+    nlohmann::json toJson() const;
+};
+
+struct StateHubStats
+{
+    size_t clients = 0;
+    uint64_t published = 0;
+    uint64_t broadcasts = 0; // States sent, a newer state replaces one not sent yet
+    uint64_t dropped = 0;    // Clients closed after a failed or timed out send
+    double lastFanOutMs = 0.0; // From publish() to the last client written
+    double maxFanOutMs = 0.0;
+};
+
+// WebSocket clients of /api/events. After the upgrade the HTTP worker hands
+// the socket over and returns to the pool, one thread polls every client, so
+// idle connections cost a socket and no thread. Each state is serialized once
+// and the same buffer is written to every client.
+class StateHub
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    StateHub();
+    ~StateHub();
+
+    StateHub(const StateHub &) = delete;
+    StateHub &operator=(const StateHub &) = delete;
+
+    // HTTP threads, after the handshake. The client gets the last state right away.
+    void addClient(Poco::Net::WebSocket socket);
+
+    // Any thread
+    void publish(const nlohmann::json &state);
+    void closeClients();
+
+    StateHubStats statistics() const;
+
+private:
+    void run();
+    void addJoined();
+    void broadcast();
+    bool receive(Poco::Net::WebSocket &socket);
+    bool send(Poco::Net::WebSocket &socket, const std::string &message);
+    void closeAll();
+
+    Poco::Net::PollSet pollSet;
+    std::map<Poco::Net::Socket, Poco::Net::WebSocket> clients; // Hub thread only
+    std::vector<char> buffer = std::vector<char>(4096);
+
+    mutable std::mutex mutex;
+    std::vector<Poco::Net::WebSocket> joined;
+    std::shared_ptr<const std::string> latest; // Last published state
+    Clock::time_point latestTime;
+    bool latestSent = true;
+    bool closeRequested = false;
+    StateHubStats stats;
+
+    std::atomic<bool> running{true};
+    std::thread thread;
+};
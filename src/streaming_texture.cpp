@@ -0,0 +1,191 @@
+#include "streaming_texture.h"
+
+#include <cstring>
+
+namespace
+{
+    size_t bytesPerPixel(StreamingTexture::Format format)
+    {
+        return format == StreamingTexture::Format::BGR ? 3 : 4;
+    }
+}
+
+StreamingTexture::~StreamingTexture()
+{
+    release();
+}
+
+bool StreamingTexture::supportsTextureStorage()
+{
+#if defined(__APPLE__)
+    return false; // Not part of the 4.1 core profile macOS provides
+#else
+    static int supported = -1;
+
+    if (supported < 0)
+    {
+        GLint major = 0, minor = 0;
+        glGetIntegerv(GL_MAJOR_VERSION, &major);
+        glGetIntegerv(GL_MINOR_VERSION, &minor);
+
+        supported = (major > 4 || (major == 4 && minor >= 2)) ? 1 : 0;
+
+        GLint extensionCount = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+
+        for (GLint i = 0; i < extensionCount && supported == 0; ++i)
+        {
+            const char *extension = reinterpret_cast<const char *>(glGetStringi(GL_EXTENSIONS, i));
+            if (extension != nullptr && std::strcmp(extension, "GL_ARB_texture_storage") == 0)
+            {
+                supported = 1;
+            }
+        }
+    }
+
+    return supported == 1;
+#endif
+}
+
+void StreamingTexture::allocate(int width, int height, Format format)
+{
+    release();
+
+    GLenum internalFormat = format == Format::BGR ? GL_RGB8 : GL_RGBA8;
+
+    glGenTextures(1, &textureID);
+    glBindTexture(GL_TEXTURE_2D, textureID);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    if (format == Format::BGR)
+    {
+        // Sampling reads blue from the first byte and red from the third, no CPU pass needed
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_R, GL_BLUE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_B, GL_RED);
+    }
+
+#if !defined(__APPLE__)
+    if (supportsTextureStorage())
+    {
+        glTexStorage2D(GL_TEXTURE_2D, 1, internalFormat, width, height);
+    }
+    else
+#endif
+    {
+        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format == Format::BGR ? GL_RGB : GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    }
+
+    textureWidth = width;
+    textureHeight = height;
+    textureFormat = format;
+    bufferSize = static_cast<size_t>(width) * height * bytesPerPixel(format);
+
+    glGenBuffers(bufferCount, pixelBuffers);
+    for (GLuint buffer : pixelBuffers)
+    {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, static_cast<GLsizeiptr>(bufferSize), nullptr, GL_STREAM_DRAW);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    nextBuffer = 0;
+}
+
+void StreamingTexture::release()
+{
+    for (int i = 0; i < bufferCount; ++i)
+    {
+        if (fences[i] != nullptr)
+        {
+            glDeleteSync(fences[i]);
+            fences[i] = nullptr;
+        }
+    }
+
+    if (pixelBuffers[0] != 0)
+    {
+        glDeleteBuffers(bufferCount, pixelBuffers);
+        std::memset(pixelBuffers, 0, sizeof(pixelBuffers));
+    }
+
+    if (textureID != 0)
+    {
+        glDeleteTextures(1, &textureID);
+        textureID = 0;
+    }
+
+    textureWidth = 0;
+    textureHeight = 0;
+    bufferSize = 0;
+}
+
+void StreamingTexture::update(const unsigned char *pixels, int width, int height, size_t stride, Format format)
+{
+    if (width != textureWidth || height != textureHeight || format != textureFormat || textureID == 0)
+    {
+        allocate(width, height, format);
+    }
+
+    int index = nextBuffer;
+    nextBuffer = (nextBuffer + 1) % bufferCount;
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffers[index]);
+
+    // If the GPU still reads this buffer, orphan it instead of waiting. Either
+    // way no pending transfer uses the storage, so the mapping can skip syncing.
+    if (fences[index] != nullptr)
+    {
+        if (glClientWaitSync(fences[index], 0, 0) == GL_TIMEOUT_EXPIRED)
+        {
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, static_cast<GLsizeiptr>(bufferSize), nullptr, GL_STREAM_DRAW);
+        }
+
+        glDeleteSync(fences[index]);
+        fences[index] = nullptr;
+    }
+
+    size_t pixelBytes = bytesPerPixel(format);
+    size_t rowBytes = static_cast<size_t>(width) * pixelBytes;
+    GLenum uploadFormat = format == Format::BGR ? GL_RGB : GL_RGBA;
+    GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+    auto *mapped = static_cast<unsigned char *>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, static_cast<GLsizeiptr>(bufferSize), access));
+
+    glBindTexture(GL_TEXTURE_2D, textureID);
+
+    // Three byte rows are tightly packed and not necessarily 4-byte aligned
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    if (mapped != nullptr)
+    {
+        if (stride == rowBytes)
+        {
+            std::memcpy(mapped, pixels, bufferSize);
+        }
+        else
+        {
+            for (int y = 0; y < height; ++y)
+            {
+                std::memcpy(mapped + y * rowBytes, pixels + y * stride, rowBytes);
+            }
+        }
+
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+        // Source is the bound buffer, the call returns before the transfer completes
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, uploadFormat, GL_UNSIGNED_BYTE, nullptr);
+        fences[index] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+    else
+    {
+        // Mapping failed, fall back to a direct upload from client memory
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, static_cast<GLint>(stride / pixelBytes));
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, uploadFormat, GL_UNSIGNED_BYTE, pixels);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
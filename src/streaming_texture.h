@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+
+#include "opengl.h"
+
+// Texture updated every frame from CPU memory. Storage is allocated once per
+// size (immutable when the driver supports it) and pixels travel through a
+// ring of pixel buffer objects, so glTexSubImage2D returns without waiting
+// for the copy and the transfer overlaps with rendering.
+class StreamingTexture
+{
+public:
+    enum class Format
+    {
+        RGBA,
+        BGR // Decoder output as is, channels are swapped by the texture swizzle when sampled
+    };
+
+    StreamingTexture() = default;
+    ~StreamingTexture();
+
+    StreamingTexture(const StreamingTexture &) = delete;
+    StreamingTexture &operator=(const StreamingTexture &) = delete;
+
+    // Uploads a frame, stride is the size of a source row in bytes
+    void update(const unsigned char *pixels, int width, int height, size_t stride, Format format = Format::RGBA);
+    void release();
+
+    GLuint id() const { return textureID; }
+    int width() const { return textureWidth; }
+    int height() const { return textureHeight; }
+
+private:
+    static constexpr int bufferCount = 3;
+
+    void allocate(int width, int height, Format format);
+    static bool supportsTextureStorage();
+
+    GLuint textureID = 0;
+    int textureWidth = 0;
+    int textureHeight = 0;
+    Format textureFormat = Format::RGBA;
+
+    GLuint pixelBuffers[bufferCount] = {};
+    GLsync fences[bufferCount] = {};
+    size_t bufferSize = 0;
+    int nextBuffer = 0;
+};
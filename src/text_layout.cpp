@@ -0,0 +1,343 @@
+#include "text_layout.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+
+#include "backends/imgui_impl_opengl3.h"
+
+void TextAutoSizedAndCentered(const std::string &text, ImFont *font, bool useDisplaySize)
+{
+    ImGuiIO &io = ImGui::GetIO();
+
+    ImVec2 baseSize; // Initialize base size
+    ImVec2 basePos;  // Initialize base position
+
+    if (useDisplaySize)
+    {
+        if (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable)
+        {
+            // When viewports are enabled, use the main viewport's size and position
+            ImGuiViewport *mainViewport = ImGui::GetMainViewport();
+            baseSize = mainViewport->Size;
+            basePos = mainViewport->Pos;
+        }
+        else
+        {
+            // If viewports are not enabled, use the display size and position (0, 0)
+            baseSize = io.DisplaySize;
+            basePos = ImVec2(0, 0);
+        }
+    }
+    else
+    {
+        // When not using display size, use the current window's size and position
+        baseSize = ImGui::GetWindowSize();
+        basePos = ImGui::GetWindowPos();
+    }
+
+    // Ensure there's a minimum size for drawing text
+    baseSize.x = (std::max)(baseSize.x, 1.0f); // Minimum width
+    baseSize.y = (std::max)(baseSize.y, 1.0f); // Minimum height
+
+    TextBlockLayout layout = layoutTextBlock(text, font, baseSize);
+    drawTextBlock(ImGui::GetForegroundDrawList(), layout, font, ImVec2(basePos.x + layout.origin.x, basePos.y + layout.origin.y));
+}
+
+namespace
+{
+    // Centers the lines at the largest size where all of them fit, widths
+    // measured once at baseSize, margin gives the room around the glyphs
+    TextBlockLayout layoutLines(const std::string &text, float baseSize, const std::function<float(const std::string &)> &measure, const std::function<float(float)> &margin, ImVec2 areaSize)
+    {
+        TextBlockLayout layout;
+
+        // Define padding
+        float paddingX = 20.0f; // Horizontal padding
+        float paddingY = 20.0f; // Vertical padding
+
+        // Calculates available area considering padding
+        float availableWidth = areaSize.x - 2 * paddingX;
+        float availableHeight = areaSize.y - 2 * paddingY;
+
+        // Splits the lines like std::getline, measuring each one once at the base size
+        std::vector<float> widths;
+        float maxLineWidth = 0.0f;
+        size_t start = 0;
+        while (start < text.size())
+        {
+            size_t end = text.find('\n', start);
+            if (end == std::string::npos)
+            {
+                end = text.size();
+            }
+
+            TextBlockLayout::Line line;
+            line.text = text.substr(start, end - start);
+            layout.lines.push_back(line);
+
+            float width = measure(line.text);
+            widths.push_back(width);
+            maxLineWidth = (std::max)(maxLineWidth, width);
+
+            start = end + 1;
+        }
+
+        if (layout.lines.empty())
+        {
+            return layout;
+        }
+
+        float lineCount = static_cast<float>(layout.lines.size());
+
+        // Adjusts the font size if the longest line is wider than the available space
+        float scaleFactor = (maxLineWidth > availableWidth) ? (availableWidth / maxLineWidth) : 1.0f;
+        float fontSize = baseSize * scaleFactor;
+
+        // Ensures the text block fits vertically within the available height
+        float totalTextHeight = fontSize * lineCount;
+        if (totalTextHeight > availableHeight)
+        {
+            fontSize *= availableHeight / totalTextHeight;
+        }
+
+        layout.fontSize = fontSize;
+
+        // Text widths scale with the size, the lines are not measured again
+        float sizeRatio = fontSize / baseSize;
+        float textPosY = paddingY + (availableHeight - fontSize * lineCount) / 2.0f;
+        float left = FLT_MAX;
+        float right = -FLT_MAX;
+
+        for (size_t i = 0; i < layout.lines.size(); ++i)
+        {
+            float width = widths[i] * sizeRatio;
+            float textPosX = paddingX + (availableWidth - width) / 2.0f;
+
+            layout.lines[i].offset = ImVec2(textPosX, textPosY + fontSize * static_cast<float>(i));
+            left = (std::min)(left, textPosX);
+            right = (std::max)(right, textPosX + width);
+        }
+
+        // Whole pixel origin, so a texture of the block maps one to one onto the screen
+        float outline = margin(fontSize);
+        layout.origin = ImVec2(std::floor(left - outline), std::floor(textPosY - outline));
+        layout.size = ImVec2(std::ceil(right + outline - layout.origin.x), std::ceil(textPosY + fontSize * lineCount + outline - layout.origin.y));
+
+        for (TextBlockLayout::Line &line : layout.lines)
+        {
+            line.offset.x -= layout.origin.x;
+            line.offset.y -= layout.origin.y;
+        }
+
+        return layout;
+    }
+}
+
+TextBlockLayout layoutTextBlock(const std::string &text, ImFont *font, ImVec2 areaSize)
+{
+    return layoutLines(
+        text, font->FontSize, [&](const std::string &line)
+        { return font->CalcTextSizeA(font->FontSize, FLT_MAX, 0.0f, line.c_str()).x; },
+        [](float)
+        { return 1.0f; },
+        areaSize);
+}
+
+TextBlockLayout layoutTextBlock(const std::string &text, const SdfFont &font, ImVec2 areaSize, float maxSize)
+{
+    return layoutLines(
+        text, maxSize, [&](const std::string &line)
+        { return font.measure(line, maxSize); },
+        [&](float fontSize)
+        { return font.effectMargin(fontSize); },
+        areaSize);
+}
+
+void drawTextBlock(ImDrawList *drawList, const TextBlockLayout &layout, ImFont *font, ImVec2 origin)
+{
+    // Text and outline colors
+    ImU32 textColor = IM_COL32(255, 255, 255, 255);
+    ImU32 outlineColor = IM_COL32(0, 0, 0, 255);
+    int outlineThickness = 1;
+
+    for (const TextBlockLayout::Line &line : layout.lines)
+    {
+        float textPosX = origin.x + line.offset.x;
+        float textPosY = origin.y + line.offset.y;
+
+        // Draws the outline
+        for (int x = -outlineThickness; x <= outlineThickness; ++x)
+        {
+            for (int y = -outlineThickness; y <= outlineThickness; ++y)
+            {
+                if (x != 0 || y != 0)
+                {
+                    drawList->AddText(font, layout.fontSize, ImVec2(textPosX + x, textPosY + y), outlineColor, line.text.c_str());
+                }
+            }
+        }
+
+        // Draws the line of text
+        drawList->AddText(font, layout.fontSize, ImVec2(textPosX, textPosY), textColor, line.text.c_str());
+    }
+}
+
+void drawTextBlock(ImDrawList *drawList, const TextBlockLayout &layout, const SdfFont &font, ImVec2 origin)
+{
+    ImU32 textColor = IM_COL32(255, 255, 255, 255);
+
+    font.beginText(drawList);
+
+    for (const TextBlockLayout::Line &line : layout.lines)
+    {
+        font.addText(drawList, layout.fontSize, ImVec2(origin.x + line.offset.x, origin.y + line.offset.y), textColor, line.text);
+    }
+
+    font.endText(drawList);
+}
+
+TextSlide::~TextSlide()
+{
+    release();
+}
+
+void TextSlide::draw(const std::string &text, const SdfFont &font)
+{
+    ImVec2 windowPos = ImGui::GetWindowPos();
+    ImVec2 windowSize = ImGui::GetWindowSize();
+    windowSize.x = (std::max)(windowSize.x, 1.0f);
+    windowSize.y = (std::max)(windowSize.y, 1.0f);
+
+    if (!laidOut || &font != this->font || windowSize.x != areaSize.x || windowSize.y != areaSize.y || text != this->text)
+    {
+        this->text = text;
+        this->font = &font;
+        areaSize = windowSize;
+        layout = layoutTextBlock(text, font, areaSize);
+        laidOut = true;
+        layoutCount++;
+
+        // Recorded now, rendered once the frame has been drawn
+        rendered = false;
+        pending = !layout.lines.empty();
+
+        if (pending)
+        {
+            if (!pendingList)
+            {
+                pendingList = std::make_unique<ImDrawList>(ImGui::GetDrawListSharedData());
+            }
+
+            pendingList->_ResetForNewFrame();
+            pendingList->PushClipRect(ImVec2(0.0f, 0.0f), layout.size);
+            drawTextBlock(pendingList.get(), layout, font, ImVec2(0.0f, 0.0f));
+            pendingList->PopClipRect();
+        }
+    }
+
+    if (layout.lines.empty())
+    {
+        return;
+    }
+
+    ImDrawList *drawList = ImGui::GetWindowDrawList();
+    ImVec2 blockMin(windowPos.x + layout.origin.x, windowPos.y + layout.origin.y);
+
+    if (rendered)
+    {
+        // Framebuffer rows start at the bottom
+        ImVec2 blockMax(blockMin.x + textureWidth, blockMin.y + textureHeight);
+        drawList->AddImage((void *)(intptr_t)texture, blockMin, blockMax, ImVec2(0.0f, 1.0f), ImVec2(1.0f, 0.0f));
+    }
+    else
+    {
+        drawTextBlock(drawList, layout, font, blockMin);
+    }
+}
+
+void TextSlide::allocate(int width, int height)
+{
+    release();
+
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+
+    textureWidth = width;
+    textureHeight = height;
+}
+
+void TextSlide::renderPending()
+{
+    if (!pending)
+    {
+        return;
+    }
+
+    pending = false;
+
+    int width = static_cast<int>(layout.size.x);
+    int height = static_cast<int>(layout.size.y);
+    if (width <= 0 || height <= 0)
+    {
+        return;
+    }
+
+    GLint previousFramebuffer = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFramebuffer);
+
+    if (width != textureWidth || height != textureHeight || texture == 0)
+    {
+        allocate(width, height);
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glDisable(GL_SCISSOR_TEST);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    // The backend blending leaves color premultiplied by alpha, only the
+    // black outline and shadow are translucent so it looks the same
+    ImDrawData drawData;
+    drawData.Valid = true;
+    drawData.DisplayPos = ImVec2(0.0f, 0.0f);
+    drawData.DisplaySize = layout.size;
+    drawData.FramebufferScale = ImVec2(1.0f, 1.0f);
+    drawData.AddDrawList(pendingList.get());
+    ImGui_ImplOpenGL3_RenderDrawData(&drawData);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(previousFramebuffer));
+
+    rendered = true;
+    renderCount++;
+}
+
+void TextSlide::release()
+{
+    if (framebuffer != 0)
+    {
+        glDeleteFramebuffers(1, &framebuffer);
+        framebuffer = 0;
+    }
+
+    if (texture != 0)
+    {
+        glDeleteTextures(1, &texture);
+        texture = 0;
+    }
+
+    textureWidth = 0;
+    textureHeight = 0;
+    rendered = false;
+}
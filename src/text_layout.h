@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "imgui.h"
+#include "opengl.h"
+#include "sdf_font.h"
+
+// Draws multi-line text centered in the current window (or the display) with
+// a one pixel outline, scaling the font down until every line fits
+void TextAutoSizedAndCentered(const std::string &text, ImFont *font, bool useDisplaySize);
+
+// Lines of a text centered in an area, positions relative to the top left of
+// the block, which includes the outline
+struct TextBlockLayout
+{
+    struct Line
+    {
+        std::string text;
+        ImVec2 offset;
+    };
+
+    std::vector<Line> lines;
+    float fontSize = 0.0f;
+    ImVec2 origin; // Top left of the block in the area, whole pixels
+    ImVec2 size;
+};
+
+TextBlockLayout layoutTextBlock(const std::string &text, ImFont *font, ImVec2 areaSize);
+
+// Same layout with an SDF font, starting from maxSize, the block includes the
+// room of the outline and the shadow
+TextBlockLayout layoutTextBlock(const std::string &text, const SdfFont &font, ImVec2 areaSize, float maxSize = 500.0f);
+
+// Outline and fill of every line, nine AddText calls per line
+void drawTextBlock(ImDrawList *drawList, const TextBlockLayout &layout, ImFont *font, ImVec2 origin);
+
+// One glyph quad per character, the outline and the shadow come from the shader
+void drawTextBlock(ImDrawList *drawList, const TextBlockLayout &layout, const SdfFont &font, ImVec2 origin);
+
+// Projector text that only changes with the slide. The layout is computed
+// when the text, the font or the window size changes, the outlined block is
+// rendered once into a texture and later frames draw a single quad. On the
+// frame of a change the block is drawn directly, the texture is rendered
+// after ImGui::Render() with the same draw commands.
+class TextSlide
+{
+public:
+    TextSlide() = default;
+    ~TextSlide();
+
+    TextSlide(const TextSlide &) = delete;
+    TextSlide &operator=(const TextSlide &) = delete;
+
+    // Centered in the current window, into its draw list
+    void draw(const std::string &text, const SdfFont &font);
+
+    // After the main ImGui_ImplOpenGL3_RenderDrawData(), restores the bound framebuffer
+    void renderPending();
+
+    // Needs the context that created the texture
+    void release();
+
+    uint64_t layouts() const { return layoutCount; }
+    uint64_t renders() const { return renderCount; }
+
+private:
+    void allocate(int width, int height);
+
+    std::string text;
+    const SdfFont *font = nullptr;
+    ImVec2 areaSize;
+    TextBlockLayout layout;
+    bool laidOut = false;
+
+    std::unique_ptr<ImDrawList> pendingList; // Block recorded on the frame of a change
+    bool pending = false;
+    bool rendered = false;
+
+    GLuint framebuffer = 0;
+    GLuint texture = 0;
+    int textureWidth = 0;
+    int textureHeight = 0;
+
+    uint64_t layoutCount = 0;
+    uint64_t renderCount = 0;
+};
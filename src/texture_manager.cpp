@@ -0,0 +1,127 @@
+#include "texture_manager.h"
+
+#include <iterator>
+
+TextureManager::TextureManager(size_t budgetBytes)
+{
+    stats.budgetBytes = budgetBytes;
+}
+
+TextureManager::~TextureManager()
+{
+    releaseAll();
+}
+
+TextureKey TextureManager::create(int width, int height, bool evictable)
+{
+    Entry entry;
+    entry.bytes = static_cast<size_t>(width) * height * 4;
+    entry.lastUsedFrame = frame;
+    entry.evictable = evictable;
+
+    glGenTextures(1, &entry.textureID);
+    glBindTexture(GL_TEXTURE_2D, entry.textureID);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+    TextureKey key = nextKey++;
+    lru.push_front(key);
+    entry.lruPosition = lru.begin();
+    textures.emplace(key, entry);
+
+    stats.residentBytes += entry.bytes;
+    stats.residentCount++;
+
+    return key;
+}
+
+void TextureManager::release(TextureKey key)
+{
+    auto it = textures.find(key);
+    if (it == textures.end())
+    {
+        return;
+    }
+
+    glDeleteTextures(1, &it->second.textureID);
+
+    stats.residentBytes -= it->second.bytes;
+    stats.residentCount--;
+
+    lru.erase(it->second.lruPosition);
+    textures.erase(it);
+}
+
+void TextureManager::releaseAll()
+{
+    for (auto &texture : textures)
+    {
+        glDeleteTextures(1, &texture.second.textureID);
+    }
+
+    textures.clear();
+    lru.clear();
+
+    stats.residentBytes = 0;
+    stats.residentCount = 0;
+}
+
+GLuint TextureManager::texture(TextureKey key) const
+{
+    auto it = textures.find(key);
+    return it != textures.end() ? it->second.textureID : 0;
+}
+
+void TextureManager::touch(TextureKey key)
+{
+    auto it = textures.find(key);
+    if (it == textures.end())
+    {
+        return;
+    }
+
+    it->second.lastUsedFrame = frame;
+    lru.splice(lru.begin(), lru, it->second.lruPosition);
+}
+
+void TextureManager::setEvictable(TextureKey key, bool evictable)
+{
+    auto it = textures.find(key);
+    if (it != textures.end())
+    {
+        it->second.evictable = evictable;
+    }
+}
+
+void TextureManager::evictToBudget(std::vector<TextureKey> &evicted)
+{
+    auto position = lru.end();
+
+    while (stats.residentBytes > stats.budgetBytes && position != lru.begin())
+    {
+        auto current = std::prev(position);
+        const Entry &entry = textures.at(*current);
+
+        // Everything further up the list was used recently as well
+        if (entry.lastUsedFrame + 1 >= frame)
+        {
+            break;
+        }
+
+        if (!entry.evictable)
+        {
+            position = current;
+            continue;
+        }
+
+        TextureKey key = *current;
+
+        stats.evictionCount++;
+        stats.evictedBytes += entry.bytes;
+        evicted.push_back(key);
+
+        // Only the current node is erased, position stays valid
+        release(key);
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+#include "opengl.h"
+
+using TextureKey = uint64_t;
+
+// Owns GL textures and keeps the evictable ones under a memory budget.
+// Textures used in the current or previous frame are never evicted, the
+// rest are dropped least recently used first.
+class TextureManager
+{
+public:
+    struct Stats
+    {
+        size_t residentBytes = 0;
+        size_t residentCount = 0;
+        size_t budgetBytes = 0;
+        uint64_t evictionCount = 0;
+        uint64_t evictedBytes = 0;
+    };
+
+    explicit TextureManager(size_t budgetBytes);
+    ~TextureManager();
+
+    TextureManager(const TextureManager &) = delete;
+    TextureManager &operator=(const TextureManager &) = delete;
+
+    // Creates an RGBA8 texture with allocated storage and no contents
+    TextureKey create(int width, int height, bool evictable = true);
+    void release(TextureKey key);
+    void releaseAll();
+
+    GLuint texture(TextureKey key) const;
+    void touch(TextureKey key);
+    void setEvictable(TextureKey key, bool evictable);
+
+    void beginFrame() { frame++; }
+
+    // Evicts textures until the budget is met, appending the keys that were dropped
+    void evictToBudget(std::vector<TextureKey> &evicted);
+
+    void setBudget(size_t budgetBytes) { stats.budgetBytes = budgetBytes; }
+    const Stats &statistics() const { return stats; }
+
+private:
+    struct Entry
+    {
+        GLuint textureID;
+        size_t bytes;
+        uint64_t lastUsedFrame;
+        bool evictable;
+        std::list<TextureKey>::iterator lruPosition;
+    };
+
+    std::unordered_map<TextureKey, Entry> textures;
+    std::list<TextureKey> lru; // Most recently used first
+    TextureKey nextKey = 1;
+    uint64_t frame = 0;
+    Stats stats;
+};
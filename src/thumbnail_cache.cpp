@@ -0,0 +1,214 @@
+#include "thumbnail_cache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <thread>
+
+#include <opencv2/imgproc.hpp>
+
+#include "stb_image.h"
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    const char thumbnailMagic[4] = {'T', 'M', 'B', '1'};
+
+    struct ThumbnailHeader
+    {
+        char magic[4];
+        uint32_t width;
+        uint32_t height;
+        uint32_t sourceWidth;
+        uint32_t sourceHeight;
+    };
+
+    bool readFile(const std::string &path, std::vector<unsigned char> &bytes)
+    {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file)
+        {
+            return false;
+        }
+
+        std::streamsize size = file.tellg();
+        file.seekg(0, std::ios::beg);
+
+        bytes.resize(static_cast<size_t>(size));
+        return static_cast<bool>(file.read(reinterpret_cast<char *>(bytes.data()), size));
+    }
+}
+
+ThumbnailCache::ThumbnailCache(const std::string &cacheDir, int maxWidth, int maxHeight)
+    : cacheDir(cacheDir), maxWidth(maxWidth), maxHeight(maxHeight)
+{
+    std::error_code error;
+    fs::create_directories(cacheDir, error);
+}
+
+uint64_t ThumbnailCache::hashBytes(const unsigned char *data, size_t size)
+{
+    // FNV-1a 64
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= data[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+void ThumbnailCache::resetCounters()
+{
+    cacheHits = 0;
+    cacheMisses = 0;
+}
+
+std::string ThumbnailCache::cacheKey(uint64_t contentHash, int64_t mtime) const
+{
+    char key[96];
+    std::snprintf(key, sizeof(key), "%016llx-%llx-%dx%d.thumb", static_cast<unsigned long long>(contentHash), static_cast<unsigned long long>(mtime), maxWidth, maxHeight);
+    return key;
+}
+
+DecodedImage ThumbnailCache::load(const std::string &imagePath)
+{
+    DecodedImage image;
+
+    std::error_code error;
+    auto mtime = fs::last_write_time(imagePath, error);
+    if (error)
+    {
+        return image;
+    }
+
+    std::vector<unsigned char> bytes;
+    if (!readFile(imagePath, bytes))
+    {
+        return image;
+    }
+
+    std::string cacheFile = (fs::path(cacheDir) / cacheKey(hashBytes(bytes.data(), bytes.size()), mtime.time_since_epoch().count())).string();
+
+    if (readThumbnail(cacheFile, image))
+    {
+        cacheHits++;
+        return image;
+    }
+
+    cacheMisses++;
+
+    int width, height, channels;
+    unsigned char *pixels = stbi_load_from_memory(bytes.data(), static_cast<int>(bytes.size()), &width, &height, &channels, STBI_rgb_alpha);
+    if (pixels == nullptr)
+    {
+        return image;
+    }
+
+    image = makeThumbnail(pixels, width, height, maxWidth, maxHeight);
+    stbi_image_free(pixels);
+
+    writeThumbnail(cacheFile, image);
+
+    return image;
+}
+
+DecodedImage ThumbnailCache::makeThumbnail(const unsigned char *pixels, int width, int height, int maxWidth, int maxHeight)
+{
+    DecodedImage thumbnail;
+    thumbnail.sourceWidth = width;
+    thumbnail.sourceHeight = height;
+
+    float scale = (std::min)(1.0f, (std::min)(static_cast<float>(maxWidth) / width, static_cast<float>(maxHeight) / height));
+    thumbnail.width = (std::max)(1, static_cast<int>(width * scale + 0.5f));
+    thumbnail.height = (std::max)(1, static_cast<int>(height * scale + 0.5f));
+
+    size_t size = static_cast<size_t>(thumbnail.width) * thumbnail.height * 4;
+    thumbnail.pixels.reset(static_cast<unsigned char *>(std::malloc(size)));
+
+    // Area interpolation averages source pixels, which is what downscaling wants
+    cv::Mat source(height, width, CV_8UC4, const_cast<unsigned char *>(pixels));
+    cv::Mat target(thumbnail.height, thumbnail.width, CV_8UC4, thumbnail.pixels.get());
+    cv::resize(source, target, target.size(), 0, 0, cv::INTER_AREA);
+
+    return thumbnail;
+}
+
+bool ThumbnailCache::readThumbnail(const std::string &file, DecodedImage &image) const
+{
+    std::ifstream stream(file, std::ios::binary);
+    if (!stream)
+    {
+        return false;
+    }
+
+    ThumbnailHeader header;
+    if (!stream.read(reinterpret_cast<char *>(&header), sizeof(header)) || std::memcmp(header.magic, thumbnailMagic, sizeof(thumbnailMagic)) != 0)
+    {
+        return false;
+    }
+
+    if (header.width == 0 || header.height == 0 || header.width > static_cast<uint32_t>(maxWidth) || header.height > static_cast<uint32_t>(maxHeight))
+    {
+        return false;
+    }
+
+    size_t size = static_cast<size_t>(header.width) * header.height * 4;
+    std::unique_ptr<unsigned char, void (*)(void *)> pixels(static_cast<unsigned char *>(std::malloc(size)), std::free);
+
+    if (!stream.read(reinterpret_cast<char *>(pixels.get()), static_cast<std::streamsize>(size)))
+    {
+        return false;
+    }
+
+    image.width = static_cast<int>(header.width);
+    image.height = static_cast<int>(header.height);
+    image.sourceWidth = static_cast<int>(header.sourceWidth);
+    image.sourceHeight = static_cast<int>(header.sourceHeight);
+    image.pixels = std::move(pixels);
+
+    return true;
+}
+
+void ThumbnailCache::writeThumbnail(const std::string &file, const DecodedImage &image) const
+{
+    ThumbnailHeader header;
+    std::memcpy(header.magic, thumbnailMagic, sizeof(thumbnailMagic));
+    header.width = static_cast<uint32_t>(image.width);
+    header.height = static_cast<uint32_t>(image.height);
+    header.sourceWidth = static_cast<uint32_t>(image.sourceWidth);
+    header.sourceHeight = static_cast<uint32_t>(image.sourceHeight);
+
+    // Write to a per-thread temporary file and rename, so readers never see partial files
+    std::ostringstream tempFile;
+    tempFile << file << ".tmp" << std::hash<std::thread::id>()(std::this_thread::get_id());
+
+    bool written;
+    {
+        std::ofstream stream(tempFile.str(), std::ios::binary | std::ios::trunc);
+        if (!stream)
+        {
+            return;
+        }
+
+        stream.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        stream.write(reinterpret_cast<const char *>(image.pixels.get()), static_cast<std::streamsize>(static_cast<size_t>(image.width) * image.height * 4));
+        written = static_cast<bool>(stream);
+    }
+
+    std::error_code error;
+    if (written)
+    {
+        fs::rename(tempFile.str(), file, error);
+    }
+
+    if (!written || error)
+    {
+        fs::remove(tempFile.str(), error);
+    }
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "image_decode_pool.h"
+
+// Cell-sized thumbnails stored on disk, keyed by content hash + mtime + size.
+// Safe to call from several decode threads at once.
+class ThumbnailCache
+{
+public:
+    ThumbnailCache(const std::string &cacheDir, int maxWidth, int maxHeight);
+
+    // Returns the thumbnail of the image, generating and storing it on a miss
+    DecodedImage load(const std::string &imagePath);
+
+    // Scales RGBA pixels to fit inside maxWidth x maxHeight keeping the aspect ratio
+    static DecodedImage makeThumbnail(const unsigned char *pixels, int width, int height, int maxWidth, int maxHeight);
+
+    static uint64_t hashBytes(const unsigned char *data, size_t size);
+
+    unsigned int hits() const { return cacheHits.load(); }
+    unsigned int misses() const { return cacheMisses.load(); }
+    void resetCounters();
+
+    const std::string &directory() const { return cacheDir; }
+
+private:
+    std::string cacheKey(uint64_t contentHash, int64_t mtime) const;
+    bool readThumbnail(const std::string &file, DecodedImage &image) const;
+    void writeThumbnail(const std::string &file, const DecodedImage &image) const;
+
+    std::string cacheDir;
+    int maxWidth;
+    int maxHeight;
+
+    std::atomic<unsigned int> cacheHits{0};
+    std::atomic<unsigned int> cacheMisses{0};
+};
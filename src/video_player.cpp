@@ -0,0 +1,364 @@
+#include "video_player.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace
+{
+    double millisecondsBetween(VideoPlayer::Clock::time_point from, VideoPlayer::Clock::time_point to)
+    {
+        return std::chrono::duration<double, std::milli>(to - from).count();
+    }
+}
+
+VideoPlayer::~VideoPlayer()
+{
+    close();
+}
+
+bool VideoPlayer::open(const std::string &path)
+{
+    close();
+
+    videoPath = path;
+    if (!openCapture())
+    {
+        videoPath.clear();
+        return false;
+    }
+
+    startDecoding();
+
+    return true;
+}
+
+void VideoPlayer::openAsync(const std::string &path)
+{
+    close();
+
+    videoPath = path;
+    startDecoding();
+}
+
+bool VideoPlayer::openCapture()
+{
+    active = 0;
+    if (!captures[active].open(videoPath))
+    {
+        return false;
+    }
+
+    framesPerSecond = captures[active].get(cv::CAP_PROP_FPS);
+    if (framesPerSecond <= 0.0)
+    {
+        framesPerSecond = 30.0;
+    }
+
+    frameDurationMs = 1000.0 / framesPerSecond;
+    frameWidth = static_cast<int>(captures[active].get(cv::CAP_PROP_FRAME_WIDTH));
+    frameHeight = static_cast<int>(captures[active].get(cv::CAP_PROP_FRAME_HEIGHT));
+
+    // Only MP4/MOV files are indexed, seeks in other containers go by time
+    keyframeIndex.load(videoPath);
+
+    loopOffset = 0.0;
+    lastPts = -frameDurationMs;
+    passRestarted = false;
+    standbyRetry = Clock::time_point();
+
+    return true;
+}
+
+void VideoPlayer::close()
+{
+    stopDecoding();
+
+    captures[0].release();
+    captures[1].release();
+    standbyReady = false;
+    openFailed = false;
+    keyframeIndex.clear();
+    videoPath.clear();
+}
+
+void VideoPlayer::startDecoding()
+{
+    stopping = false;
+    decodeThread = std::thread(&VideoPlayer::decodeLoop, this);
+}
+
+void VideoPlayer::stopDecoding()
+{
+    if (decodeThread.joinable())
+    {
+        stopping = true;
+        spaceAvailable.notify_all();
+        decodeThread.join();
+    }
+
+    framePool.reset();
+    current = nullptr;
+    clockStarted = false;
+    missedIntervals = 0;
+}
+
+bool VideoPlayer::seek(double timeMs)
+{
+    if (!isOpen())
+    {
+        return false;
+    }
+
+    stopDecoding();
+
+    const Keyframe *keyframe = keyframeIndex.nearest(timeMs);
+    if (keyframe != nullptr)
+    {
+        captures[active].set(cv::CAP_PROP_POS_FRAMES, static_cast<double>(keyframe->frame));
+        lastPts = keyframe->timeMs - frameDurationMs;
+    }
+    else
+    {
+        captures[active].set(cv::CAP_PROP_POS_MSEC, timeMs);
+        lastPts = timeMs - frameDurationMs;
+    }
+
+    // Timestamps restart from the media time, the clock resyncs on the first frame
+    loopOffset = 0.0;
+    passRestarted = false;
+    startDecoding();
+
+    return true;
+}
+
+VideoStats VideoPlayer::statistics() const
+{
+    VideoStats result = stats;
+    result.loopDecodeMs = lastLoopDecode;
+    result.maxLoopDecodeMs = maxLoopDecode;
+    return result;
+}
+
+const VideoFrame *VideoPlayer::updateSynchronous(Clock::time_point now)
+{
+    const VideoFrame *shown = nullptr;
+    Clock::time_point deadline = Clock::now() + std::chrono::seconds(5);
+
+    while (true)
+    {
+        if (const VideoFrame *frame = update(now))
+        {
+            shown = frame;
+        }
+
+        // A queued frame that is not due yet means every due frame was taken
+        if (paused || !isOpen() || openFailed || framePool.peek() != nullptr || Clock::now() > deadline)
+        {
+            return shown;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+void VideoPlayer::setPaused(bool value)
+{
+    if (paused == value)
+    {
+        return;
+    }
+
+    paused = value;
+
+    // Resync the clock to the next frame when playback resumes
+    clockStarted = false;
+}
+
+const VideoFrame *VideoPlayer::update(Clock::time_point now)
+{
+    if (paused || !isOpen())
+    {
+        return nullptr;
+    }
+
+    const VideoFrame *next = framePool.peek();
+
+    if (!clockStarted)
+    {
+        if (next == nullptr)
+        {
+            return nullptr;
+        }
+
+        // The first frame after a (re)start is due right now
+        clockStart = now - std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(next->pts));
+        clockStarted = true;
+        presentedSinceStart = false; // A pause is not a gap
+    }
+
+    double mediaTime = millisecondsBetween(clockStart, now);
+    bool changed = false;
+    bool passStarted = false;
+
+    // Take the latest frame that is due, the ones before it are dropped
+    while (next != nullptr && next->pts <= mediaTime)
+    {
+        if (changed)
+        {
+            stats.dropped++;
+        }
+
+        current = framePool.take();
+        spaceAvailable.notify_one();
+
+        passStarted = passStarted || current->passStart;
+        changed = true;
+        next = framePool.peek();
+    }
+
+    if (changed)
+    {
+        missedIntervals = 0;
+        stats.presented++;
+        stats.driftMs = mediaTime - current->pts;
+
+        // Seamless when the screen time between the last frame of the pass and
+        // the first of the next one matches their pts interval
+        if (passStarted)
+        {
+            stats.loops++;
+
+            if (presentedSinceStart)
+            {
+                double gap = millisecondsBetween(lastPresentTime, now) - (current->pts - lastPresentPts);
+                stats.loopGapMs = std::max(gap, 0.0);
+                stats.maxLoopGapMs = std::max(stats.maxLoopGapMs, stats.loopGapMs);
+            }
+        }
+
+        presentedSinceStart = true;
+        lastPresentTime = now;
+        lastPresentPts = current->pts;
+        return current;
+    }
+
+    // The decoder is late: count each frame interval the old frame stays up
+    if (current != nullptr && next == nullptr && mediaTime >= current->pts + frameDurationMs * (missedIntervals + 1))
+    {
+        missedIntervals++;
+        stats.duplicated++;
+    }
+
+    return nullptr;
+}
+
+bool VideoPlayer::prepareStandby()
+{
+    cv::VideoCapture &standby = captures[1 - active];
+
+    // Rewinding the decoder that just finished is cheaper than opening the file again
+    bool ready = standby.isOpened() && standby.set(cv::CAP_PROP_POS_FRAMES, 0) && standby.read(standbyFrame);
+
+    if (!ready)
+    {
+        ready = standby.open(videoPath) && standby.read(standbyFrame);
+    }
+
+    standbyPts = ready ? standby.get(cv::CAP_PROP_POS_MSEC) : 0.0;
+    standbyReady = ready;
+    return ready;
+}
+
+void VideoPlayer::decodeLoop()
+{
+    // Opened by openAsync(), the first published frame makes the properties visible
+    if (!captures[active].isOpened() && !openCapture())
+    {
+        openFailed = true;
+        return;
+    }
+
+    int failedReads = 0;
+
+    while (!stopping)
+    {
+        if (!framePool.canAcquire())
+        {
+            // Use the time the queue is full to get the next pass ready. A file that
+            // was removed or cannot be read is retried later, not on every wake up.
+            if (!standbyReady && !videoPath.empty() && Clock::now() >= standbyRetry)
+            {
+                if (prepareStandby())
+                {
+                    continue;
+                }
+
+                standbyRetry = Clock::now() + std::chrono::milliseconds(100);
+            }
+
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            spaceAvailable.wait_for(lock, std::chrono::milliseconds(5), [this]
+                                    { return stopping || framePool.canAcquire(); });
+            continue;
+        }
+
+        // Decoded straight into a recycled frame, whose buffer is reused while the
+        // size stays the same. The texture swizzle does the color conversion.
+        // grab() first: a failed read() at the end of the clip would release the
+        // buffer, and the standby frame would get an empty one on every loop.
+        VideoFrame *item = framePool.acquire();
+        Clock::time_point readStart = Clock::now();
+
+        if (captures[active].grab() && captures[active].retrieve(item->image))
+        {
+            failedReads = 0;
+            item->decodeMs = millisecondsBetween(readStart, Clock::now());
+            item->passStart = passRestarted;
+            passRestarted = false;
+
+            // Prefer the stream timestamp, fall back to the nominal rate when it is missing
+            item->pts = loopOffset + captures[active].get(cv::CAP_PROP_POS_MSEC);
+        }
+        else
+        {
+            // End of the clip, timestamps continue after the last frame
+            Clock::time_point loopStart = Clock::now();
+            loopOffset = lastPts + frameDurationMs;
+
+            if (++failedReads > 1)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100)); // Unreadable file, avoid spinning
+            }
+
+            if (!standbyReady && !prepareStandby())
+            {
+                captures[active].set(cv::CAP_PROP_POS_FRAMES, 0);
+                passRestarted = true;
+                continue;
+            }
+
+            // Swap decoders and hand over the frame the standby one already decoded,
+            // the standby keeps this frame's buffer for the next pass
+            active = 1 - active;
+            standbyReady = false;
+            std::swap(item->image, standbyFrame);
+            item->pts = loopOffset + standbyPts;
+            item->passStart = true;
+
+            double decodeMs = millisecondsBetween(loopStart, Clock::now());
+            lastLoopDecode = decodeMs;
+            if (decodeMs > maxLoopDecode)
+            {
+                maxLoopDecode = decodeMs;
+            }
+        }
+
+        if (item->pts <= lastPts)
+        {
+            item->pts = lastPts + frameDurationMs;
+        }
+        lastPts = item->pts;
+
+        framePool.publish();
+    }
+}
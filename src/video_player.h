@@ -0,0 +1,132 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <opencv2/videoio.hpp>
+
+#include "frame_pool.h"
+#include "mp4_index.h"
+
+struct VideoFrame
+{
+    cv::Mat image; // BGR as produced by the decoder
+    double pts = 0.0; // Presentation time in ms, keeps increasing across loops
+    double decodeMs = 0.0; // Time the decode thread spent reading the frame
+    bool passStart = false; // First frame after the clip looped
+};
+
+struct VideoStats
+{
+    uint64_t presented = 0;
+    uint64_t dropped = 0;    // Decoded but skipped because a later frame was already due
+    uint64_t duplicated = 0; // Frame intervals where no new frame was ready and the last one stayed up
+    double driftMs = 0.0;    // Clock time minus the pts of the frame on screen
+    uint64_t loops = 0;          // Passes presented after the first one
+    double loopGapMs = 0.0;      // How much later than its pts the first frame of a pass reached the screen, 0 when seamless
+    double maxLoopGapMs = 0.0;
+    double loopDecodeMs = 0.0;   // Decode thread time from the end of the clip to the first frame of the next pass
+    double maxLoopDecodeMs = 0.0;
+};
+
+// Decodes a video on its own thread into a bounded pool of reused frames. The
+// render thread presents frames by their timestamps against a monotonic
+// clock, so decode stalls no longer translate into UI frame drops. A second
+// decoder waits at the start of the clip with its first frame decoded, so
+// looping swaps decoders instead of seeking.
+class VideoPlayer
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    VideoPlayer() = default;
+    ~VideoPlayer();
+
+    VideoPlayer(const VideoPlayer &) = delete;
+    VideoPlayer &operator=(const VideoPlayer &) = delete;
+
+    bool open(const std::string &path);
+    void close();
+
+    // Opens the file on the decode thread, so the caller does not wait for the
+    // demuxer to probe it. Size and rate are valid once frameReady() is true.
+    void openAsync(const std::string &path);
+    bool failed() const { return openFailed; }
+
+    // Returns the frame to show when it changed since the last call, nullptr otherwise
+    const VideoFrame *update(Clock::time_point now = Clock::now());
+
+    // Same as update() but waits for the decoder instead of keeping a late
+    // frame up, so the frame shown at a given time does not depend on the
+    // machine. For offscreen rendering with a simulated clock.
+    const VideoFrame *updateSynchronous(Clock::time_point now);
+
+    void setPaused(bool paused);
+
+    // Jumps to the last keyframe at or before the given media time
+    bool seek(double timeMs);
+
+    bool isOpen() const { return decodeThread.joinable(); }
+
+    // Render thread, true once a decoded frame waits to be presented
+    bool frameReady() { return framePool.peek() != nullptr; }
+    int width() const { return frameWidth; }
+    int height() const { return frameHeight; }
+    double fps() const { return framesPerSecond; }
+    VideoStats statistics() const;
+    const KeyframeIndex &keyframes() const { return keyframeIndex; }
+
+private:
+    bool openCapture();
+    void startDecoding();
+    void stopDecoding();
+    void decodeLoop();
+    bool prepareStandby();
+
+    std::string videoPath;
+    KeyframeIndex keyframeIndex;
+
+    // Decode thread state, the active capture plays while the other one is pre-rolled
+    cv::VideoCapture captures[2];
+    int active = 0;
+    bool standbyReady = false;
+    cv::Mat standbyFrame;
+    double standbyPts = 0.0;
+    double loopOffset = 0.0;
+    double lastPts = 0.0;
+    bool passRestarted = false; // Rewound without a standby decoder, the next frame starts a pass
+    Clock::time_point standbyRetry; // After a failed pre-roll, the file is not opened again before this
+
+    std::atomic<bool> openFailed{false};
+    std::atomic<double> lastLoopDecode{0.0};
+    std::atomic<double> maxLoopDecode{0.0};
+
+    std::thread decodeThread;
+    std::atomic<bool> stopping{false};
+
+    // Eight queued frames plus the one being decoded and the one on screen
+    FramePool<VideoFrame> framePool{10};
+    std::mutex wakeMutex;
+    std::condition_variable spaceAvailable;
+
+    int frameWidth = 0;
+    int frameHeight = 0;
+    double framesPerSecond = 0.0;
+    double frameDurationMs = 0.0;
+
+    // Render thread state
+    const VideoFrame *current = nullptr; // Held in the pool until the next frame replaces it
+    bool paused = false;
+    bool clockStarted = false;
+    Clock::time_point clockStart;
+    uint64_t missedIntervals = 0; // Duplicates counted for the frame on screen
+    bool presentedSinceStart = false; // Since the clock (re)started, the last presented frame below is valid
+    Clock::time_point lastPresentTime;
+    double lastPresentPts = 0.0;
+    VideoStats stats;
+};
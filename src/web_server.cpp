@@ -0,0 +1,599 @@
+#include "web_server.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+
+#include <Poco/File.h>
+#include <Poco/Net/HTTPServerRequest.h>
+#include <Poco/Net/HTTPServerResponse.h>
+#include <Poco/Net/ServerSocket.h>
+#include <Poco/Net/WebSocket.h>
+#include <Poco/Path.h>
+#include <Poco/URI.h>
+
+#include "file_streamer.h"
+#include "network_monitor.h"
+
+using namespace Poco::Net;
+
+namespace
+{
+    std::string trim(const std::string &text)
+    {
+        size_t first = text.find_first_not_of(" \t");
+        size_t last = text.find_last_not_of(" \t");
+        return first == std::string::npos ? std::string() : text.substr(first, last - first + 1);
+    }
+
+    // Accept-Encoding lists gzip (or *) without q=0
+    bool acceptsGzip(const HTTPServerRequest &req)
+    {
+        std::istringstream header(req.get("Accept-Encoding", ""));
+        std::string item;
+
+        while (std::getline(header, item, ','))
+        {
+            size_t parameters = item.find(';');
+            std::string coding = trim(item.substr(0, parameters));
+            std::transform(coding.begin(), coding.end(), coding.begin(), ::tolower);
+
+            if (coding != "gzip" && coding != "*")
+            {
+                continue;
+            }
+
+            if (parameters != std::string::npos)
+            {
+                std::string quality = trim(item.substr(parameters + 1));
+                if (quality.compare(0, 2, "q=") == 0 && std::strtod(quality.c_str() + 2, nullptr) <= 0.0)
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        return false;
+    }
+
+    bool matchesEtag(const std::string &ifNoneMatch, const std::string &etag)
+    {
+        std::istringstream header(ifNoneMatch);
+        std::string item;
+
+        while (std::getline(header, item, ','))
+        {
+            std::string tag = trim(item);
+            if (tag.compare(0, 2, "W/") == 0)
+            {
+                tag = tag.substr(2);
+            }
+
+            if (tag == "*" || tag == etag)
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    int queryInt(const Poco::URI &uri, const std::string &name, int fallback)
+    {
+        for (const auto &parameter : uri.getQueryParameters())
+        {
+            if (parameter.first == name)
+            {
+                return std::atoi(parameter.second.c_str());
+            }
+        }
+
+        return fallback;
+    }
+
+    void sendAsset(HTTPServerRequest &req, HTTPServerResponse &resp, const Asset &asset)
+    {
+        bool useGzip = !asset.gzipBody.empty() && acceptsGzip(req);
+        const std::string &etag = useGzip ? asset.gzipEtag : asset.etag;
+
+        resp.set("ETag", etag);
+        resp.set("Cache-Control", asset.immutable ? "public, max-age=31536000, immutable" : "no-cache");
+
+        if (!asset.gzipBody.empty())
+        {
+            resp.set("Vary", "Accept-Encoding");
+        }
+
+        if (req.has("If-None-Match") && matchesEtag(req.get("If-None-Match"), etag))
+        {
+            // Without a length Poco would close the connection or send chunked, losing keep-alive
+            resp.setStatus(HTTPResponse::HTTP_NOT_MODIFIED);
+            resp.setContentLength(0);
+            resp.send();
+            return;
+        }
+
+        resp.setStatus(HTTPResponse::HTTP_OK);
+        resp.setContentType(asset.contentType);
+
+        if (useGzip)
+        {
+            resp.set("Content-Encoding", "gzip");
+        }
+
+        // Sets Content-Length, so the connection stays open for the next request
+        const std::string &body = useGzip ? asset.gzipBody : asset.body;
+        resp.sendBuffer(body.data(), body.size());
+    }
+}
+
+FileRequestHandler::FileRequestHandler(std::shared_ptr<AssetCache> assets)
+    : assets(std::move(assets))
+{
+}
+
+void FileRequestHandler::handleRequest(HTTPServerRequest &req, HTTPServerResponse &resp)
+{
+    // Exemplo: http://localhost:8080/rcontrol/?api_url=http://localhost:8080/api
+
+    // Extrai o caminho do URI da solicitação e forma o caminho do arquivo
+    std::string requestedPath = req.getURI();
+
+    // Remove os parâmetros de consulta (tudo após '?')
+    size_t queryStart = requestedPath.find('?');
+    if (queryStart != std::string::npos)
+    {
+        requestedPath = requestedPath.substr(0, queryStart);
+    }
+
+    // Prevenção simples contra Directory Traversal Attack
+    if (requestedPath.find("..") != std::string::npos)
+    {
+        resp.setStatus(HTTPResponse::HTTP_FORBIDDEN);
+        resp.send() << "403 - Forbidden";
+        return;
+    }
+
+    if (requestedPath.back() == '/')
+    {
+        requestedPath += "index.html";
+    }
+
+    // Caminho relativo à pasta web, sem a barra inicial
+    size_t nameStart = requestedPath.find_first_not_of('/');
+    std::string relativePath = nameStart == std::string::npos ? "" : requestedPath.substr(nameStart);
+    std::string fullPath = assets->root() + "/" + relativePath;
+    Poco::File file(fullPath);
+
+    std::shared_ptr<const Asset> asset = assets->find(relativePath);
+
+    if (!asset && file.exists() && file.isDirectory())
+    {
+        relativePath += "/index.html";
+        fullPath = assets->root() + "/" + relativePath;
+        file = Poco::File(fullPath);
+        asset = assets->find(relativePath);
+    }
+
+    if (asset)
+    {
+        sendAsset(req, resp, *asset);
+        return;
+    }
+
+    // Too large to keep in memory, streamed from the disk
+    if (file.exists() && file.isFile())
+    {
+        sendFileStreamed(req, resp, fullPath, AssetCache::contentTypeFor(fullPath));
+    }
+    else
+    {
+        // Arquivo não encontrado
+        resp.setStatus(HTTPResponse::HTTP_NOT_FOUND);
+        resp.send() << "404 - Not Found";
+    }
+}
+
+void MediaRoot::set(const std::string &folder)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    path = folder;
+}
+
+std::string MediaRoot::get() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return path;
+}
+
+MediaRequestHandler::MediaRequestHandler(std::shared_ptr<MediaRoot> root)
+    : root(std::move(root))
+{
+}
+
+void MediaRequestHandler::handleRequest(HTTPServerRequest &req, HTTPServerResponse &resp)
+{
+    // /media/images/img-1.jpg -> <projeto>/images/img-1.jpg
+    std::string requestedPath = req.getURI();
+
+    size_t queryStart = requestedPath.find('?');
+    if (queryStart != std::string::npos)
+    {
+        requestedPath = requestedPath.substr(0, queryStart);
+    }
+
+    std::string relativePath;
+    Poco::URI::decode(requestedPath.substr(std::string("/media/").size()), relativePath);
+
+    if (relativePath.find("..") != std::string::npos)
+    {
+        resp.setStatus(HTTPResponse::HTTP_FORBIDDEN);
+        resp.send() << "403 - Forbidden";
+        return;
+    }
+
+    std::string folder = root->get();
+    if (folder.empty() || relativePath.empty())
+    {
+        resp.setStatus(HTTPResponse::HTTP_NOT_FOUND);
+        resp.send() << "404 - Not Found";
+        return;
+    }
+
+    std::string fullPath = folder + "/" + relativePath;
+    sendFileStreamed(req, resp, fullPath, AssetCache::contentTypeFor(fullPath));
+}
+
+void APIRequestHandler::handleRequest(HTTPServerRequest &req, HTTPServerResponse &resp)
+{
+    resp.setStatus(HTTPResponse::HTTP_OK);
+    resp.setContentType("application/json");
+
+    std::ostream &out = resp.send();
+    out << R"({"message": "This is a JSON response from API"})";
+    out.flush();
+}
+
+ModuleCallHandler::ModuleCallHandler(std::shared_ptr<RpcDispatcher> dispatcher)
+    : dispatcher(std::move(dispatcher))
+{
+}
+
+void ModuleCallHandler::handleRequest(HTTPServerRequest &req, HTTPServerResponse &resp)
+{
+    // Start of the end-to-end latency, before the body is read
+    RpcDispatcher::Clock::time_point received = RpcDispatcher::Clock::now();
+
+    using json = nlohmann::json;
+
+    auto reply = [&resp](HTTPResponse::HTTPStatus status, const json &body)
+    {
+        std::string text = body.dump();
+        resp.setStatus(status);
+        resp.setContentType("application/json");
+        resp.sendBuffer(text.data(), text.size());
+    };
+
+    if (req.getMethod() != HTTPRequest::HTTP_POST)
+    {
+        reply(HTTPResponse::HTTP_METHOD_NOT_ALLOWED, {{"error", "POST expected"}});
+        return;
+    }
+
+    json body = json::parse(req.stream(), nullptr, false);
+    if (body.is_discarded() || !body.is_object() || !body.contains("func") || !body["func"].is_string())
+    {
+        reply(HTTPResponse::HTTP_BAD_REQUEST, {{"error", "Invalid call"}});
+        return;
+    }
+
+    std::string func = body["func"].get<std::string>();
+    json params = body.contains("params") ? body["params"] : json::object();
+
+    if (!dispatcher->has(func))
+    {
+        reply(HTTPResponse::HTTP_NOT_FOUND, {{"error", "Unknown function " + func}});
+        return;
+    }
+
+    if (!dispatcher->isQuery(func))
+    {
+        dispatcher->call(func, std::move(params), received);
+        reply(HTTPResponse::HTTP_OK, {{"result", true}});
+        return;
+    }
+
+    // Runs on the render thread, a minimized or stalled window must not hold the worker forever
+    std::future<json> result = dispatcher->query(func, std::move(params), received);
+    if (result.wait_for(std::chrono::seconds(2)) != std::future_status::ready)
+    {
+        reply(HTTPResponse::HTTP_SERVICE_UNAVAILABLE, {{"error", "Timeout"}});
+        return;
+    }
+
+    try
+    {
+        reply(HTTPResponse::HTTP_OK, {{"result", result.get()}});
+    }
+    catch (const std::future_error &)
+    {
+        reply(HTTPResponse::HTTP_SERVICE_UNAVAILABLE, {{"error", "Shutting down"}});
+    }
+}
+
+EventsRequestHandler::EventsRequestHandler(std::shared_ptr<StateHub> hub)
+    : hub(std::move(hub))
+{
+}
+
+void EventsRequestHandler::handleRequest(HTTPServerRequest &req, HTTPServerResponse &resp)
+{
+    try
+    {
+        // Sends 101 Switching Protocols, the worker thread is free once this returns
+        hub->addClient(WebSocket(req, resp));
+    }
+    catch (const WebSocketException &)
+    {
+        resp.setStatus(HTTPResponse::HTTP_BAD_REQUEST);
+        resp.setContentLength(0);
+        resp.send();
+    }
+}
+
+ImagesRequestHandler::ImagesRequestHandler(std::shared_ptr<ImageCatalog> catalog)
+    : catalog(std::move(catalog))
+{
+}
+
+void ImagesRequestHandler::handleRequest(HTTPServerRequest &req, HTTPServerResponse &resp)
+{
+    Poco::URI uri(req.getURI());
+
+    size_t offset = static_cast<size_t>(std::max(0, queryInt(uri, "offset", 0)));
+    size_t limit = static_cast<size_t>(std::clamp(queryInt(uri, "limit", 50), 1, 200));
+    int width = queryInt(uri, "w", 256);
+
+    std::string body = catalog->page(offset, limit, width).dump();
+
+    resp.setStatus(HTTPResponse::HTTP_OK);
+    resp.setContentType("application/json");
+    resp.set("Cache-Control", "no-cache");
+    resp.sendBuffer(body.data(), body.size());
+}
+
+ThumbnailRequestHandler::ThumbnailRequestHandler(std::shared_ptr<ImageCatalog> catalog)
+    : catalog(std::move(catalog))
+{
+}
+
+void ThumbnailRequestHandler::handleRequest(HTTPServerRequest &req, HTTPServerResponse &resp)
+{
+    // /api/thumb/12?w=256
+    Poco::URI uri(req.getURI());
+    std::string id = uri.getPath().substr(std::string("/api/thumb/").size());
+
+    char *end = nullptr;
+    unsigned long index = std::strtoul(id.c_str(), &end, 10);
+
+    std::shared_ptr<const CatalogThumbnail> thumbnail;
+    if (!id.empty() && *end == '\0')
+    {
+        thumbnail = catalog->thumbnail(index, queryInt(uri, "w", 256));
+    }
+
+    if (!thumbnail)
+    {
+        resp.setStatus(HTTPResponse::HTTP_NOT_FOUND);
+        resp.setContentLength(0);
+        resp.send();
+        return;
+    }
+
+    // The URL carries the catalog generation and the file revision, so a short max-age is safe
+    resp.set("ETag", thumbnail->etag);
+    resp.set("Cache-Control", "private, max-age=300");
+
+    if (req.has("If-None-Match") && matchesEtag(req.get("If-None-Match"), thumbnail->etag))
+    {
+        resp.setStatus(HTTPResponse::HTTP_NOT_MODIFIED);
+        resp.setContentLength(0);
+        resp.send();
+        return;
+    }
+
+    resp.setStatus(HTTPResponse::HTTP_OK);
+    resp.setContentType("image/jpeg");
+    resp.sendBuffer(thumbnail->jpeg.data(), thumbnail->jpeg.size());
+}
+
+PreviewRequestHandler::PreviewRequestHandler(std::shared_ptr<PreviewStream> preview)
+    : preview(std::move(preview))
+{
+}
+
+void PreviewRequestHandler::handleRequest(HTTPServerRequest &, HTTPServerResponse &resp)
+{
+    // Captures start with the first viewer and stop with the last
+    PreviewStream::Client client(*preview);
+    uint64_t closeCount = preview->closeCount();
+
+    resp.setStatus(HTTPResponse::HTTP_OK);
+    resp.setContentType("multipart/x-mixed-replace; boundary=frame");
+    resp.set("Cache-Control", "no-cache, no-store");
+    resp.setKeepAlive(false);
+
+    try
+    {
+        std::ostream &out = resp.send();
+        uint64_t sequence = 0;
+
+        while (out.good())
+        {
+            PreviewStream::FramePtr frame = preview->waitFrame(sequence, closeCount, std::chrono::milliseconds(1000));
+            if (!frame)
+            {
+                if (preview->closeCount() != closeCount)
+                {
+                    break;
+                }
+
+                continue;
+            }
+
+            out << "--frame\r\nContent-Type: image/jpeg\r\nContent-Length: " << frame->jpeg.size() << "\r\n\r\n";
+            out.write(frame->jpeg.data(), static_cast<std::streamsize>(frame->jpeg.size()));
+            out << "\r\n";
+            out.flush();
+
+            sequence = frame->sequence;
+        }
+    }
+    catch (const Poco::Exception &)
+    {
+        // Viewer gone or stalled past the send timeout
+    }
+}
+
+RequestHandlerFactory::RequestHandlerFactory(const std::string &webRoot, std::shared_ptr<MediaRoot> mediaRoot, std::shared_ptr<RpcDispatcher> dispatcher, std::shared_ptr<StateHub> hub, std::shared_ptr<ImageCatalog> catalog, std::shared_ptr<PreviewStream> preview)
+    : assets(std::make_shared<AssetCache>(webRoot)), mediaRoot(mediaRoot ? std::move(mediaRoot) : std::make_shared<MediaRoot>()), dispatcher(dispatcher ? std::move(dispatcher) : std::make_shared<RpcDispatcher>()), hub(hub ? std::move(hub) : std::make_shared<StateHub>()), catalog(catalog ? std::move(catalog) : std::make_shared<ImageCatalog>()), preview(preview ? std::move(preview) : std::make_shared<PreviewStream>())
+{
+    routes = {
+        {"/media/", Route::Media},
+        {"/api/module/call", Route::ModuleCall},
+        {"/api/events", Route::Events},
+        {"/api/images", Route::Images},
+        {"/api/thumb/", Route::Thumbnail},
+        {"/api/preview.mjpeg", Route::Preview},
+        {"/api", Route::Api},
+    };
+
+    std::sort(routes.begin(), routes.end(), [](const RouteEntry &a, const RouteEntry &b)
+              { return a.prefix.size() > b.prefix.size(); });
+
+    // Read the files once, requests are served from memory
+    assets->preload();
+}
+
+HTTPRequestHandler *RequestHandlerFactory::createRequestHandler(const HTTPServerRequest &request)
+{
+    // The raw request target, only its prefix matters so it is not parsed
+    const std::string &target = request.getURI();
+    Route route = Route::Files;
+
+    for (const RouteEntry &entry : routes)
+    {
+        if (target.compare(0, entry.prefix.size(), entry.prefix) == 0)
+        {
+            route = entry.route;
+            break;
+        }
+    }
+
+    switch (route)
+    {
+    case Route::Api:
+        return new APIRequestHandler;
+    case Route::ModuleCall:
+        return new ModuleCallHandler(dispatcher);
+    case Route::Events:
+        return new EventsRequestHandler(hub);
+    case Route::Images:
+        return new ImagesRequestHandler(catalog);
+    case Route::Thumbnail:
+        return new ThumbnailRequestHandler(catalog);
+    case Route::Preview:
+        return new PreviewRequestHandler(preview);
+    case Route::Media:
+        return new MediaRequestHandler(mediaRoot);
+    default:
+        return new FileRequestHandler(assets);
+    }
+}
+
+HTTPServerParams *WebServer::createParams(const ServerSettings &settings)
+{
+    HTTPServerParams *params = new HTTPServerParams;
+    params->setMaxThreads(std::max(1, settings.threads));
+    params->setMaxQueued(std::max(1, settings.maxQueued));
+    params->setKeepAlive(settings.keepAlive);
+    params->setMaxKeepAliveRequests(settings.maxKeepAliveRequests);
+    params->setKeepAliveTimeout(Poco::Timespan(settings.keepAliveTimeoutMs / 1000, (settings.keepAliveTimeoutMs % 1000) * 1000));
+    params->setTimeout(Poco::Timespan(settings.timeoutMs / 1000, (settings.timeoutMs % 1000) * 1000));
+    return params;
+}
+
+void WebServer::start(const std::string &host, int port, const ServerSettings &settings)
+{
+    if (host.empty())
+    {
+        return;
+    }
+
+    if (port <= 0)
+    {
+        return;
+    }
+
+    if (serverRunning)
+    {
+        return; // Impede iniciar múltiplas vezes
+    }
+
+    try
+    {
+        Poco::Net::SocketAddress sa(host, port);
+        int threads = std::max(1, settings.threads);
+        threadPool.reset(new Poco::ThreadPool(std::min(2, threads), threads));
+        server = new HTTPServer(new RequestHandlerFactory("./web", mediaRoot, dispatcher, hub, catalog, previewStream), *threadPool, ServerSocket(sa), createParams(settings));
+        server->start();
+        std::cout << "Server started on " << host << ":" << port << "." << std::endl;
+        serverRunning = true;
+    }
+    catch (Poco::Exception &e)
+    {
+        std::cerr << "Error: " << e.displayText() << std::endl;
+    }
+}
+
+void WebServer::stop()
+{
+    if (!serverRunning)
+        return; // Impede parar se não estiver rodando
+    try
+    {
+        if (server)
+        {
+            server->stop();
+            delete server;
+            server = nullptr;
+
+            // Preview streams never end on their own
+            previewStream->closeClients();
+
+            // Connections still being served finish before their threads go away
+            threadPool->joinAll();
+            threadPool.reset();
+            hub->closeClients();
+            std::cout << "Server stopped." << std::endl;
+            serverRunning = false;
+        }
+    }
+    catch (Poco::Exception &e)
+    {
+        std::cerr << "Error: " << e.displayText() << std::endl;
+    }
+}
+
+std::string WebServer::getLocalIPAddress()
+{
+    return NetworkMonitor::enumerate().localAddress;
+}
+
+std::vector<std::string> WebServer::getAvailableIPAddresses()
+{
+    return NetworkMonitor::enumerate().addresses;
+}
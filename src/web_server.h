@@ -0,0 +1,213 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <Poco/Net/HTTPRequestHandler.h>
+#include <Poco/Net/HTTPRequestHandlerFactory.h>
+#include <Poco/Net/HTTPServer.h>
+#include <Poco/Net/HTTPServerParams.h>
+#include <Poco/ThreadPool.h>
+
+#include "asset_cache.h"
+#include "image_catalog.h"
+#include "preview_stream.h"
+#include "rpc_dispatcher.h"
+#include "state_hub.h"
+
+// Serves the files of the web folder, e.g. the remote control page, from the
+// asset cache with Content-Length, ETag and gzip when the client accepts it
+class FileRequestHandler : public Poco::Net::HTTPRequestHandler
+{
+public:
+    explicit FileRequestHandler(std::shared_ptr<AssetCache> assets);
+
+    void handleRequest(Poco::Net::HTTPServerRequest &req, Poco::Net::HTTPServerResponse &resp) override;
+
+private:
+    std::shared_ptr<AssetCache> assets;
+};
+
+class APIRequestHandler : public Poco::Net::HTTPRequestHandler
+{
+public:
+    void handleRequest(Poco::Net::HTTPServerRequest &req, Poco::Net::HTTPServerResponse &resp) override;
+};
+
+// Folder served under /media/, the project folder, may change while the server runs
+class MediaRoot
+{
+public:
+    void set(const std::string &path);
+    std::string get() const;
+
+private:
+    mutable std::mutex mutex;
+    std::string path;
+};
+
+// Project images and videos for phones and tablets, streamed with Range
+// support so videos can be seeked
+class MediaRequestHandler : public Poco::Net::HTTPRequestHandler
+{
+public:
+    explicit MediaRequestHandler(std::shared_ptr<MediaRoot> root);
+
+    void handleRequest(Poco::Net::HTTPServerRequest &req, Poco::Net::HTTPServerResponse &resp) override;
+
+private:
+    std::shared_ptr<MediaRoot> root;
+};
+
+// POST {"func": "...", "params": {...}} from the remote control, answered
+// with {"result": ...} once the call is queued, or run for queries
+class ModuleCallHandler : public Poco::Net::HTTPRequestHandler
+{
+public:
+    explicit ModuleCallHandler(std::shared_ptr<RpcDispatcher> dispatcher);
+
+    void handleRequest(Poco::Net::HTTPServerRequest &req, Poco::Net::HTTPServerResponse &resp) override;
+
+private:
+    std::shared_ptr<RpcDispatcher> dispatcher;
+};
+
+// Upgrades /api/events to a WebSocket and hands it to the state hub
+class EventsRequestHandler : public Poco::Net::HTTPRequestHandler
+{
+public:
+    explicit EventsRequestHandler(std::shared_ptr<StateHub> hub);
+
+    void handleRequest(Poco::Net::HTTPServerRequest &req, Poco::Net::HTTPServerResponse &resp) override;
+
+private:
+    std::shared_ptr<StateHub> hub;
+};
+
+// GET /api/images?offset=&limit=&w=, a page of the project images
+class ImagesRequestHandler : public Poco::Net::HTTPRequestHandler
+{
+public:
+    explicit ImagesRequestHandler(std::shared_ptr<ImageCatalog> catalog);
+
+    void handleRequest(Poco::Net::HTTPServerRequest &req, Poco::Net::HTTPServerResponse &resp) override;
+
+private:
+    std::shared_ptr<ImageCatalog> catalog;
+};
+
+// GET /api/thumb/{id}?w=, a JPEG thumbnail from the catalog cache
+class ThumbnailRequestHandler : public Poco::Net::HTTPRequestHandler
+{
+public:
+    explicit ThumbnailRequestHandler(std::shared_ptr<ImageCatalog> catalog);
+
+    void handleRequest(Poco::Net::HTTPServerRequest &req, Poco::Net::HTTPServerResponse &resp) override;
+
+private:
+    std::shared_ptr<ImageCatalog> catalog;
+};
+
+// GET /api/preview.mjpeg, the projector output as multipart JPEG frames.
+// The connection keeps its worker thread until the viewer leaves.
+class PreviewRequestHandler : public Poco::Net::HTTPRequestHandler
+{
+public:
+    explicit PreviewRequestHandler(std::shared_ptr<PreviewStream> preview);
+
+    void handleRequest(Poco::Net::HTTPServerRequest &req, Poco::Net::HTTPServerResponse &resp) override;
+
+private:
+    std::shared_ptr<PreviewStream> preview;
+};
+
+// Picks the handler by path prefix from a table built once, the handlers
+// only hold pointers to the shared state
+class RequestHandlerFactory : public Poco::Net::HTTPRequestHandlerFactory
+{
+public:
+    explicit RequestHandlerFactory(const std::string &webRoot = "./web", std::shared_ptr<MediaRoot> mediaRoot = nullptr, std::shared_ptr<RpcDispatcher> dispatcher = nullptr, std::shared_ptr<StateHub> hub = nullptr, std::shared_ptr<ImageCatalog> catalog = nullptr, std::shared_ptr<PreviewStream> preview = nullptr);
+
+    Poco::Net::HTTPRequestHandler *createRequestHandler(const Poco::Net::HTTPServerRequest &request) override;
+
+private:
+    enum class Route
+    {
+        Files,
+        Api,
+        ModuleCall,
+        Events,
+        Images,
+        Thumbnail,
+        Preview,
+        Media
+    };
+
+    struct RouteEntry
+    {
+        std::string prefix;
+        Route route;
+    };
+
+    std::vector<RouteEntry> routes; // Longest prefix first, Files when none matches
+
+    std::shared_ptr<AssetCache> assets; // Shared by the handlers of every connection
+    std::shared_ptr<MediaRoot> mediaRoot;
+    std::shared_ptr<RpcDispatcher> dispatcher;
+    std::shared_ptr<StateHub> hub;
+    std::shared_ptr<ImageCatalog> catalog;
+    std::shared_ptr<PreviewStream> preview;
+};
+
+// Concurrency of the server, read from the "server" object of config.json
+struct ServerSettings
+{
+    int threads = 8;                 // Connections served at once
+    int maxQueued = 64;              // Accepted connections waiting for a thread, more are refused
+    bool keepAlive = true;
+    int maxKeepAliveRequests = 100;  // Per connection, 0 for no limit
+    int keepAliveTimeoutMs = 10000;  // Idle time before a kept-alive connection is closed
+    int timeoutMs = 60000;           // Send and receive timeout of the sockets
+};
+
+class WebServer
+{
+public:
+    bool serverRunning = false;
+    Poco::Net::HTTPServer *server = nullptr;
+
+    WebServer() : server(nullptr) {}
+
+    void start(const std::string &host, int port, const ServerSettings &settings = ServerSettings());
+    void stop();
+
+    void setMediaRoot(const std::string &path) { mediaRoot->set(path); }
+
+    // Functions of the remote control, register them before start()
+    RpcDispatcher &rpc() { return *dispatcher; }
+
+    // Player state for the WebSocket clients of /api/events
+    StateHub &events() { return *hub; }
+
+    // Project images for /api/images and /api/thumb/
+    ImageCatalog &images() { return *catalog; }
+
+    // Frames of /api/preview.mjpeg, captured by the render thread
+    PreviewStream &preview() { return *previewStream; }
+
+    // Walk the interfaces on every call, the UI reads a NetworkMonitor snapshot instead
+    std::string getLocalIPAddress();
+    std::vector<std::string> getAvailableIPAddresses();
+
+    static Poco::Net::HTTPServerParams *createParams(const ServerSettings &settings);
+
+private:
+    std::shared_ptr<MediaRoot> mediaRoot = std::make_shared<MediaRoot>();
+    std::shared_ptr<RpcDispatcher> dispatcher = std::make_shared<RpcDispatcher>();
+    std::shared_ptr<StateHub> hub = std::make_shared<StateHub>();
+    std::shared_ptr<ImageCatalog> catalog = std::make_shared<ImageCatalog>();
+    std::shared_ptr<PreviewStream> previewStream = std::make_shared<PreviewStream>();
+    std::unique_ptr<Poco::ThreadPool> threadPool; // Sized for the settings, the default pool stops at 16
+};